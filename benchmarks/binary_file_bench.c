@@ -0,0 +1,1000 @@
+//
+// Benchmarks for binary_file.h: throughput (MB/s) and latency (ns/op)
+//
+// Usage: binary_file_bench [directory] [scale]
+//   directory:  Where the temporary files are written (default: the current directory)
+//   scale:      Multiplies the amount of work done by every benchmark (default: 1.0)
+//
+// Output: One JSON object per line so results can be collected and compared between releases, e.g.
+//   {"benchmark":"write_i32","size":4,"ops":4000000,"bytes":16000000,"seconds":0.0512,"ns_per_op":12.80,"mb_per_s":312.50}
+//
+// Note: 'size' is the size of one operation in bytes (element size, chunk size or average string length).
+//
+
+#include "binary_file.h"
+
+#include <stddef.h>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+//
+// Benchmark state
+//
+char bench_directory[1024] = ".";
+f64 bench_scale = 1.0;
+volatile i64 bench_sink = 0;		// Keeps the compiler from dropping reads whose results are not used
+
+//
+// Helpers
+//
+
+// Get a monotonic time stamp in seconds
+f64 bench_now(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+#endif
+}
+// Scale a work amount by the 'scale' argument (at least 1)
+i64 bench_scaled(i64 amount)
+{
+	i64 scaled = (i64)((f64)amount * bench_scale);
+	return (scaled < 1) ? 1 : scaled;
+}
+// Build the path of a temporary benchmark file
+str bench_path(const char* name)
+{
+	static char path[2048];
+	snprintf(path, sizeof(path), "%s/binary_file_bench_%s.bin", bench_directory, name);
+	return (str)path;
+}
+// Small fast pseudo random number generator (xorshift64)
+u64 bench_random(u64* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+// Print one result line
+void bench_report(const char* name, i64 size, i64 ops, i64 bytes, f64 seconds)
+{
+	if (seconds <= 0.0)
+		seconds = 1e-9;
+
+	printf("{\"benchmark\":\"%s\",\"size\":%lld,\"ops\":%lld,\"bytes\":%lld,\"seconds\":%.6f,\"ns_per_op\":%.2f,\"mb_per_s\":%.2f}\n",
+		name, (long long)size, (long long)ops, (long long)bytes, seconds, seconds * 1e9 / (f64)ops, (f64)bytes / seconds / 1e6);
+	fflush(stdout);
+}
+// Stop the benchmark run if a file operation failed
+void bench_check(bool ok, const char* what)
+{
+	if (!ok)
+	{
+		fprintf(stderr, "Error: %s failed\n", what);
+		exit(1); // Exit to OS
+	}
+}
+
+//
+// Benchmarks
+//
+
+// Write many scalars one call at a time through the FILE* based functions
+void bench_write_scalars(void)
+{
+	i64 count = bench_scaled(4000000);
+	str path = bench_path("scalars");
+
+#define BENCH_WRITE_SCALAR(type) \
+	{ \
+		binary_file file = binary_file_openfor_write_new(path); \
+		bench_check(file != NULL, "open"); \
+		f64 start = bench_now(); \
+		for (i64 i = 0; i < count; i++) \
+			binary_file_write_##type((type)i, file); \
+		binary_file_close(file); \
+		bench_report("write_" #type, sizeof(type), count, count * (i64)sizeof(type), bench_now() - start); \
+	}
+
+	BENCH_WRITE_SCALAR(i8);
+	BENCH_WRITE_SCALAR(i16);
+	BENCH_WRITE_SCALAR(i32);
+	BENCH_WRITE_SCALAR(i64);
+	BENCH_WRITE_SCALAR(u8);
+	BENCH_WRITE_SCALAR(u16);
+	BENCH_WRITE_SCALAR(u32);
+	BENCH_WRITE_SCALAR(u64);
+	BENCH_WRITE_SCALAR(f32);
+	BENCH_WRITE_SCALAR(f64);
+	BENCH_WRITE_SCALAR(bool);
+#undef BENCH_WRITE_SCALAR
+
+	// The same through the buffered writer
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	binary_file_writer* writer = binary_file_writer_open(file, 1 << 20);
+	bench_check(writer != NULL, "writer open");
+	for (i64 i = 0; i < count; i++)
+		binary_file_writer_write_i32((i32)i, writer);
+	bench_check(binary_file_writer_close(writer), "writer close");
+	binary_file_close(file);
+	bench_report("writer_write_i32", sizeof(i32), count, count * (i64)sizeof(i32), bench_now() - start);
+
+	// Read them back one call at a time
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	i32 sum = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		i32 data = 0;
+		binary_file_read_i32(&data, file);
+		sum += data;
+	}
+	binary_file_close(file);
+	bench_report("read_i32", sizeof(i32), count, count * (i64)sizeof(i32), bench_now() - start);
+	bench_sink += sum;
+
+	remove((const char*)path);
+}
+// Write and read large arrays with binary_file_write_elements / binary_file_read_elements at several chunk sizes
+void bench_elements(void)
+{
+	const i64 chunk_sizes[] = { 64, 4096, 262144, 4194304 };
+	i64 total = bench_scaled(128 << 20);
+	str path = bench_path("elements");
+
+	byte* chunk = (byte*)malloc(4194304);
+	bench_check(chunk != NULL, "malloc");
+	memset(chunk, 0x5A, 4194304);
+
+	for (i32 c = 0; c < (i32)(sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); c++)
+	{
+		i64 size = chunk_sizes[c];
+		i64 count = (total + size - 1) / size;
+
+		binary_file file = binary_file_openfor_write_new(path);
+		bench_check(file != NULL, "open");
+		f64 start = bench_now();
+		for (i64 i = 0; i < count; i++)
+			bench_check(binary_file_write_elements(chunk, sizeof(i32), size / sizeof(i32), file), "write_elements");
+		binary_file_close(file);
+		bench_report("write_elements", size, count, count * size, bench_now() - start);
+
+		file = binary_file_openfor_read(path);
+		bench_check(file != NULL, "open");
+		start = bench_now();
+		for (i64 i = 0; i < count; i++)
+			bench_check(binary_file_read_elements(chunk, sizeof(i32), size / sizeof(i32), file), "read_elements");
+		binary_file_close(file);
+		bench_report("read_elements", size, count, count * size, bench_now() - start);
+	}
+
+	free(chunk);
+	remove((const char*)path);
+}
+// Read a string heavy file with every string reading function
+void bench_strings(void)
+{
+	i64 count = bench_scaled(500000);
+	str path = bench_path("strings");
+	u64 random = 0x9E3779B97F4A7C15ull;
+
+	// Write strings of 4 to 40 characters
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	c8 text[64];
+	i64 bytes = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 length = 4 + (i64)(bench_random(&random) % 37);
+		memset(text, 'a' + (int)(i % 26), length);
+		text[length] = '\0';
+		binary_file_write_str(text, file);
+		bytes += length + 1;
+	}
+	binary_file_close(file);
+	i64 average = bytes / count;
+
+	// One malloc per string
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		str result = (str)malloc(1);
+		result = binary_file_read_str(file, result);
+		bench_check(result != NULL, "read_str");
+		free(result);
+	}
+	bench_report("read_str", average, count, bytes, bench_now() - start);
+
+	// One reused buffer
+	binary_file_set_position_begin(file);
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(binary_file_read_str_into(text, sizeof(text), file) >= 0, "read_str_into");
+	bench_report("read_str_into", average, count, bytes, bench_now() - start);
+
+	// Strings kept in an arena, freed every 4096 strings with one reset
+	binary_file_set_position_begin(file);
+	binary_file_arena* arena = binary_file_arena_create(0);
+	bench_check(arena != NULL, "arena");
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		bench_check(binary_file_read_str_arena(arena, file) != NULL, "read_str_arena");
+		if ((i & 4095) == 4095)
+			binary_file_arena_reset(arena);
+	}
+	bench_report("read_str_arena", average, count, bytes, bench_now() - start);
+	binary_file_arena_destroy(arena);
+
+	// Whole blocks split at once
+	binary_file_set_position_begin(file);
+	start = bench_now();
+	i64 found = 0;
+	binary_file_str_table* table;
+	while ((table = binary_file_read_str_table(1 << 20, file)) != NULL)
+	{
+		found += table->count;
+		binary_file_str_table_free(table);
+	}
+	bench_check(found == count, "read_str_table");
+	bench_report("read_str_table", average, count, bytes, bench_now() - start);
+	binary_file_close(file);
+
+	remove((const char*)path);
+}
+// Read 'i64' values at random offsets: seek + read, positional read and memory mapped read
+void bench_random_access(void)
+{
+	i64 elements = bench_scaled(8 << 20);
+	i64 count = bench_scaled(1000000);
+	str path = bench_path("random");
+	u64 random = 0xD1B54A32D192ED03ull;
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	binary_file_writer* writer = binary_file_writer_open(file, 1 << 20);
+	bench_check(writer != NULL, "writer open");
+	for (i64 i = 0; i < elements; i++)
+		binary_file_writer_write_i64(i, writer);
+	bench_check(binary_file_writer_close(writer), "writer close");
+	binary_file_close(file);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+
+	f64 start = bench_now();
+	i64 sum = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 data = 0;
+		binary_file_set_position((file_size)(bench_random(&random) % elements) * sizeof(i64), file);
+		binary_file_read_i64(&data, file);
+		sum += data;
+	}
+	bench_report("seek_read_i64", sizeof(i64), count, count * (i64)sizeof(i64), bench_now() - start);
+
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 data = 0;
+		binary_file_read_i64_at(&data, (file_size)(bench_random(&random) % elements) * sizeof(i64), file);
+		sum += data;
+	}
+	bench_report("read_i64_at", sizeof(i64), count, count * (i64)sizeof(i64), bench_now() - start);
+	binary_file_close(file);
+
+	binary_file_map* map = binary_file_mapfor_read(path);
+	bench_check(map != NULL, "map");
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 data = 0;
+		binary_file_map_set_position((file_size)(bench_random(&random) % elements) * sizeof(i64), map);
+		binary_file_map_read_i64(&data, map);
+		sum += data;
+	}
+	bench_report("map_read_i64", sizeof(i64), count, count * (i64)sizeof(i64), bench_now() - start);
+	binary_file_map_close(map);
+	bench_sink += sum;
+
+	remove((const char*)path);
+}
+// Write and read small ids as varints instead of fixed 8 byte integers
+void bench_varints(void)
+{
+	i64 count = bench_scaled(2000000);
+	str path = bench_path("varints");
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	binary_file_writer* writer = binary_file_writer_open(file, 1 << 20);
+	bench_check(writer != NULL, "writer open");
+	for (i64 i = 0; i < count; i++)
+		binary_file_writer_write_varint_u64((u64)i, writer);
+	bench_check(binary_file_writer_close(writer), "writer close");
+	binary_file_close(file);
+	i64 bytes = binary_file_get_length(path);
+	bench_report("writer_write_varint_u64", bytes / count, count, bytes, bench_now() - start);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	u64 sum = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		u64 data = 0;
+		binary_file_read_varint_u64(&data, file);
+		sum += data;
+	}
+	binary_file_close(file);
+	bench_report("read_varint_u64", bytes / count, count, bytes, bench_now() - start);
+
+	binary_file_map* map = binary_file_mapfor_read(path);
+	bench_check(map != NULL, "map");
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		u64 data = 0;
+		binary_file_map_read_varint_u64(&data, map);
+		sum += data;
+	}
+	binary_file_map_close(map);
+	bench_report("map_read_varint_u64", bytes / count, count, bytes, bench_now() - start);
+	bench_sink += (i64)sum;
+
+	remove((const char*)path);
+}
+// Write and read bool arrays packed into bits
+void bench_bools(void)
+{
+	i64 count = bench_scaled(64 << 20);
+	str path = bench_path("bools");
+
+	bool* flags = (bool*)malloc(count * sizeof(bool));
+	bench_check(flags != NULL, "malloc");
+	u64 random = 0x2545F4914F6CDD1Dull;
+	for (i64 i = 0; i < count; i++)
+		flags[i] = (bench_random(&random) & 1) != 0;
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	bench_check(binary_file_write_bools_packed(flags, count, file), "write_bools_packed");
+	binary_file_close(file);
+	bench_report("write_bools_packed", 1, count, (count + 7) / 8, bench_now() - start);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_bools_packed(flags, count, file), "read_bools_packed");
+	binary_file_close(file);
+	bench_report("read_bools_packed", 1, count, (count + 7) / 8, bench_now() - start);
+
+	free(flags);
+	remove((const char*)path);
+}
+// Write and read a compressed stream front to back, then seek around in it
+void bench_compressed(void)
+{
+	i64 count = bench_scaled(16 << 20);
+	str path = bench_path("compressed");
+
+	f64* samples = (f64*)malloc(count * sizeof(f64));
+	bench_check(samples != NULL, "malloc");
+	for (i64 i = 0; i < count; i++)
+		samples[i] = (f64)(i % 4096) * 0.25;
+
+	binary_file file = binary_file_openfor_write_compressed(path, 0);
+	if (file == NULL)
+	{
+		free(samples);
+		return; // Not supported on this platform
+	}
+	f64 start = bench_now();
+	bench_check(binary_file_write_elements(samples, sizeof(f64), count, file), "write_compressed");
+	binary_file_close(file);
+	bench_report("write_compressed", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	file = binary_file_openfor_read_compressed(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_elements(samples, sizeof(f64), count, file), "read_compressed");
+	bench_report("read_compressed", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	i64 seeks = bench_scaled(10000);
+	u64 random = 0x9E3779B97F4A7C15ull;
+	start = bench_now();
+	for (i64 i = 0; i < seeks; i++)
+	{
+		f64 sample;
+		bench_check(binary_file_set_position((file_size)(bench_random(&random) % count) * sizeof(f64), file), "set_position");
+		bench_check(binary_file_read_f64(&sample, file), "read_f64");
+		bench_sink += (i64)sample;
+	}
+	bench_report("seek_compressed", sizeof(f64), seeks, seeks * sizeof(f64), bench_now() - start);
+	binary_file_close(file);
+
+	// The same with the blocks compressed and decompressed on one thread per CPU
+	file = binary_file_openfor_write_compressed_parallel(path, NULL);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_write_elements(samples, sizeof(f64), count, file), "write_compressed_parallel");
+	binary_file_close(file);
+	bench_report("write_compressed_parallel", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	file = binary_file_openfor_read_compressed_parallel(path, NULL);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_elements(samples, sizeof(f64), count, file), "read_compressed_parallel");
+	binary_file_close(file);
+	bench_report("read_compressed_parallel", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	free(samples);
+	remove((const char*)path);
+}
+// Store records in a columnar file and scan one column, compared to reading all records row by row
+void bench_columns(void)
+{
+	typedef struct bench_record
+	{
+		i64 time;
+		f64 price;
+		f64 values[6];
+		i32 quantity;
+		i32 flags;
+	} bench_record;
+
+	i64 count = bench_scaled(2000000);
+	str path = bench_path("columns");
+
+	bench_record* records = (bench_record*)calloc(count, sizeof(bench_record));
+	f64* prices = (f64*)malloc(count * sizeof(f64));
+	bench_check(records != NULL && prices != NULL, "malloc");
+	for (i64 i = 0; i < count; i++)
+	{
+		records[i].time = i;
+		records[i].price = (f64)(i % 1000);
+		records[i].quantity = (i32)i;
+	}
+
+	i64 sizes[5] = { sizeof(i64), sizeof(f64), 6 * sizeof(f64), sizeof(i32), sizeof(i32) };
+	i64 offsets[5] = { offsetof(bench_record, time), offsetof(bench_record, price), offsetof(bench_record, values), offsetof(bench_record, quantity), offsetof(bench_record, flags) };
+	binary_file_column_writer* writer = binary_file_column_writer_open(path, 5, sizes, 0);
+	bench_check(writer != NULL, "open");
+	f64 start = bench_now();
+	bench_check(binary_file_column_writer_write_records(records, sizeof(bench_record), offsets, count, writer), "write_records");
+	bench_check(binary_file_column_writer_close(writer), "close");
+	bench_report("write_columns", sizeof(bench_record), count, count * sizeof(bench_record), bench_now() - start);
+
+	binary_file_column_reader* reader = binary_file_column_reader_open(path, false);
+	bench_check(reader != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_column_reader_read(prices, 1, 0, count, reader), "read_column");
+	bench_report("read_column", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+	binary_file_column_reader_close(reader);
+
+	reader = binary_file_column_reader_open(path, true);
+	bench_check(reader != NULL, "open");
+	start = bench_now();
+	f64 sum = 0.0;
+	for (i64 row = 0; row < count;)
+	{
+		i64 rows = 0;
+		const f64* chunk = (const f64*)binary_file_column_reader_get_chunk(1, row, &rows, reader);
+		bench_check(chunk != NULL, "get_chunk");
+		for (i64 i = 0; i < rows; i++)
+			sum += chunk[i];
+		row += rows;
+	}
+	bench_sink += (i64)sum;
+	bench_report("scan_column_mapped", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+	binary_file_column_reader_close(reader);
+
+	// Row-major baseline: the same column needs every record to be read
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	bench_check(binary_file_write_elements(records, sizeof(bench_record), count, file), "write_elements");
+	binary_file_close(file);
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_elements(records, sizeof(bench_record), count, file), "read_elements");
+	for (i64 i = 0; i < count; i++)
+		prices[i] = records[i].price;
+	bench_report("read_column_row_major", sizeof(f64), count, count * sizeof(bench_record), bench_now() - start);
+	binary_file_close(file);
+
+	free(prices);
+	free(records);
+	remove((const char*)path);
+}
+// Append variable length records, then fetch them by record number one at a time and in batches
+void bench_records(void)
+{
+	i64 count = bench_scaled(1000000);
+	str path = bench_path("records");
+	byte record[256];
+	memset(record, 'r', sizeof(record));
+
+	binary_file_record_writer* writer = binary_file_record_writer_open(path);
+	bench_check(writer != NULL, "open");
+	u64 random = 0x853C49E6748FEA9Bull;
+	i64 bytes = 0;
+	f64 start = bench_now();
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 length = 16 + (i64)(bench_random(&random) % 200);
+		bench_check(binary_file_record_writer_append(record, length, writer), "append");
+		bytes += length;
+	}
+	bench_check(binary_file_record_writer_close(writer), "close");
+	bench_report("record_append", bytes / count, count, bytes, bench_now() - start);
+
+	binary_file_record_file* records = binary_file_record_file_open(path);
+	bench_check(records != NULL, "open");
+	i64 reads = bench_scaled(200000);
+	start = bench_now();
+	for (i64 i = 0; i < reads; i++)
+		bench_check(binary_file_record_file_read(record, sizeof(record), (i64)(bench_random(&random) % count), records) >= 0, "record_read");
+	bench_report("record_read_random", 0, reads, 0, bench_now() - start);
+
+	i64 batch = 1000;
+	i64* indices = (i64*)malloc(batch * sizeof(i64));
+	byte** data = (byte**)malloc(batch * sizeof(byte*));
+	i64* lengths = (i64*)malloc(batch * sizeof(i64));
+	bench_check(indices != NULL && data != NULL && lengths != NULL, "malloc");
+	start = bench_now();
+	for (i64 done = 0; done < reads; done += batch)
+	{
+		for (i64 i = 0; i < batch; i++)
+			indices[i] = (i64)(bench_random(&random) % count);
+		bench_check(binary_file_record_file_read_batch(indices, batch, data, lengths, records), "record_read_batch");
+		for (i64 i = 0; i < batch; i++)
+			free(data[i]);
+	}
+	bench_report("record_read_batch", 0, (reads + batch - 1) / batch * batch, 0, bench_now() - start);
+	binary_file_record_file_close(records);
+
+	start = bench_now();
+	bench_check(binary_file_record_file_rebuild_index(path, 0) == count, "rebuild_index");
+	bench_report("record_rebuild_index", 0, count, 0, bench_now() - start);
+
+	free(lengths);
+	free(data);
+	free(indices);
+	remove((const char*)path);
+}
+// Producer thread of the append log benchmark: appends records and waits for each to be durable
+binary_file_log* bench_log_handle = NULL;
+i64 bench_log_records = 0;
+void bench_log_producer(void* argument)
+{
+	byte record[100];
+	memset(record, (int)(intptr_t)argument, sizeof(record));
+	for (i64 i = 0; i < bench_log_records; i++)
+		bench_check(binary_file_log_append_sync(record, sizeof(record), bench_log_handle) != 0, "log_append_sync");
+}
+// Append records to a crash-safe log: durable appends from several threads sharing group commits, and appends with one flush at the end
+void bench_log(void)
+{
+	i32 thread_count = 8;
+	str path = bench_path("log");
+	remove((const char*)path);
+
+	bench_log_records = bench_scaled(500);
+	bench_log_handle = binary_file_log_open(path, 1000);
+	bench_check(bench_log_handle != NULL, "log_open");
+	binary_file_thread threads[8];
+	f64 start = bench_now();
+	for (i32 i = 0; i < thread_count; i++)
+		bench_check(binary_file_platform_thread_start(&threads[i], bench_log_producer, (void*)(intptr_t)i), "thread_start");
+	for (i32 i = 0; i < thread_count; i++)
+		binary_file_platform_thread_join(threads[i]);
+	bench_report("log_append_sync", 100, thread_count * bench_log_records, thread_count * bench_log_records * 100, bench_now() - start);
+
+	i64 count = bench_scaled(1000000);
+	byte record[100];
+	memset(record, 'l', sizeof(record));
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(binary_file_log_append(record, sizeof(record), bench_log_handle) != 0, "log_append");
+	bench_check(binary_file_log_flush(bench_log_handle), "log_flush");
+	bench_report("log_append", 100, count, count * 100, bench_now() - start);
+	bench_check(binary_file_log_close(bench_log_handle), "log_close");
+
+	start = bench_now();
+	binary_file_log_reader* reader = binary_file_log_reader_open(path);
+	bench_check(reader != NULL, "log_reader_open");
+	i64 length, records = 0;
+	while (binary_file_log_reader_next(&length, reader) != NULL)
+		records++;
+	binary_file_log_reader_close(reader);
+	bench_check(records == count + thread_count * bench_log_records, "log_reader_next");
+	bench_report("log_read", 100, records, records * 100, bench_now() - start);
+
+	remove((const char*)path);
+}
+// Transform callback of bench_transform: f64 to f32
+i64 bench_to_f32(const byte* input, i64 input_length, byte* output, i64 output_capacity, i64 index, void* user_data)
+{
+	(void)output_capacity;
+	(void)index;
+	(void)user_data;
+	for (i64 i = 0; i < input_length / (i64)sizeof(f64); i++)
+		((f32*)output)[i] = (f32)((const f64*)input)[i];
+	return input_length / 2;
+}
+// Convert a file of f64 to f32 and copy it: one thread with read_elements/write_elements, and the pipeline
+void bench_transform(void)
+{
+	i64 count = bench_scaled(16 << 20);
+	str input_path = bench_path("transform_in");
+	c8 output_path[2048];
+	snprintf((char*)output_path, sizeof(output_path), "%s/binary_file_bench_transform_out.bin", bench_directory);
+
+	i64 chunk = 1 << 17;	// Elements per chunk (1MB of f64)
+	f64* samples = (f64*)malloc(chunk * sizeof(f64));
+	f32* converted = (f32*)malloc(chunk * sizeof(f32));
+	bench_check(samples != NULL && converted != NULL, "malloc");
+
+	binary_file input = binary_file_openfor_write_new(input_path);
+	bench_check(input != NULL, "open");
+	for (i64 done = 0; done < count; done += chunk)
+	{
+		i64 n = (count - done < chunk) ? count - done : chunk;
+		for (i64 i = 0; i < n; i++)
+			samples[i] = (f64)(done + i);
+		bench_check(binary_file_write_elements(samples, sizeof(f64), n, input), "write_elements");
+	}
+	binary_file_close(input);
+
+	// One thread: read, convert, write
+	input = binary_file_openfor_read(input_path);
+	binary_file output = binary_file_openfor_write_new(output_path);
+	bench_check(input != NULL && output != NULL, "open");
+	f64 start = bench_now();
+	for (i64 done = 0; done < count; done += chunk)
+	{
+		i64 n = (count - done < chunk) ? count - done : chunk;
+		bench_check(binary_file_read_elements(samples, sizeof(f64), n, input), "read_elements");
+		for (i64 i = 0; i < n; i++)
+			converted[i] = (f32)samples[i];
+		bench_check(binary_file_write_elements(converted, sizeof(f32), n, output), "write_elements");
+	}
+	binary_file_close(output);
+	binary_file_close(input);
+	bench_report("convert_elements", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	// Pipeline, chunks written out of order
+	binary_file_pipeline_options options = { chunk * (i64)sizeof(f64), 0, chunk * (i64)sizeof(f32), 0, 0 };
+	input = binary_file_openfor_read(input_path);
+	output = binary_file_openfor_write_new(output_path);
+	bench_check(input != NULL && output != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_transform(bench_to_f32, NULL, &options, input, output) == count * (i64)sizeof(f32), "transform");
+	binary_file_close(output);
+	binary_file_close(input);
+	bench_report("transform_pipeline", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	// Copy through stdio
+	input = binary_file_openfor_read(input_path);
+	output = binary_file_openfor_write_new(output_path);
+	bench_check(input != NULL && output != NULL, "open");
+	start = bench_now();
+	for (i64 done = 0; done < count; done += chunk)
+	{
+		i64 n = (count - done < chunk) ? count - done : chunk;
+		bench_check(binary_file_read_elements(samples, sizeof(f64), n, input), "read_elements");
+		bench_check(binary_file_write_elements(samples, sizeof(f64), n, output), "write_elements");
+	}
+	binary_file_close(output);
+	binary_file_close(input);
+	bench_report("copy_elements", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	// Copy inside the kernel where possible
+	input = binary_file_openfor_read(input_path);
+	output = binary_file_openfor_write_new(output_path);
+	bench_check(input != NULL && output != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_copy(input, output) == count * (i64)sizeof(f64), "copy");
+	binary_file_close(output);
+	binary_file_close(input);
+	bench_report("copy", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	free(converted);
+	free(samples);
+	remove((const char*)output_path);
+	remove((const char*)input_path);
+}
+// Write records of a header, a name and an array: one call per field, and one scatter/gather call per record
+void bench_segments(void)
+{
+	str path = bench_path("segments");
+	static byte array[256 * 1024];
+	memset(array, 'a', sizeof(array));
+	u64 header[2] = { 1, 2 };
+	c8 name[20];
+	memset(name, 'n', sizeof(name));
+
+	i64 sizes[2] = { 64, (i64)sizeof(array) };
+	for (i32 s = 0; s < 2; s++)
+	{
+		i64 count = bench_scaled(sizes[s] < 1024 ? 1000000 : 2000);
+		i64 record = sizeof(header) + sizeof(name) + sizes[s];
+		c8 label[64];
+
+		binary_file file = binary_file_openfor_write_new(path);
+		bench_check(file != NULL, "open");
+		f64 start = bench_now();
+		for (i64 i = 0; i < count; i++)
+		{
+			bench_check(binary_file_write_elements(header, sizeof(u64), 2, file), "write_elements");
+			bench_check(binary_file_write_byte(name, sizeof(name), file), "write_byte");
+			bench_check(binary_file_write_byte(array, sizes[s], file), "write_byte");
+		}
+		binary_file_close(file);
+		snprintf((char*)label, sizeof(label), "record_fields_%lld", (long long)sizes[s]);
+		bench_report((const char*)label, record, count, count * record, bench_now() - start);
+
+		binary_file_segment segments[3] = { { header, sizeof(header) }, { name, sizeof(name) }, { array, sizes[s] } };
+		file = binary_file_openfor_write_new(path);
+		bench_check(file != NULL, "open");
+		start = bench_now();
+		for (i64 i = 0; i < count; i++)
+			bench_check(binary_file_write_segments(segments, 3, file), "write_segments");
+		binary_file_close(file);
+		snprintf((char*)label, sizeof(label), "write_segments_%lld", (long long)sizes[s]);
+		bench_report((const char*)label, record, count, count * record, bench_now() - start);
+
+		file = binary_file_openfor_read(path);
+		bench_check(file != NULL, "open");
+		start = bench_now();
+		for (i64 i = 0; i < count; i++)
+			bench_check(binary_file_read_segments(segments, 3, file), "read_segments");
+		binary_file_close(file);
+		snprintf((char*)label, sizeof(label), "read_segments_%lld", (long long)sizes[s]);
+		bench_report((const char*)label, record, count, count * record, bench_now() - start);
+	}
+
+	remove((const char*)path);
+}
+// Dump a large array and read it back: through stdio and the page cache, and past the page cache from a pooled aligned buffer
+void bench_direct(void)
+{
+	i64 count = bench_scaled(32 << 20);
+	str path = bench_path("direct");
+
+	binary_file_buffer_pool* pool = binary_file_buffer_pool_create(count * sizeof(f64), 1);
+	bench_check(pool != NULL, "buffer_pool_create");
+	f64* samples = (f64*)binary_file_buffer_pool_acquire(pool);
+	for (i64 i = 0; i < count; i++)
+		samples[i] = (f64)i;
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	bench_check(binary_file_write_elements(samples, sizeof(f64), count, file), "write_elements");
+	binary_file_close(file);
+	bench_report("write_elements_stdio", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_elements(samples, sizeof(f64), count, file), "read_elements");
+	binary_file_close(file);
+	bench_report("read_elements_stdio", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+	file = binary_file_openfor_write_direct(path, NULL);
+	if (file != NULL)
+	{
+		start = bench_now();
+		bench_check(binary_file_write_elements(samples, sizeof(f64), count, file), "write_elements_direct");
+		binary_file_close(file);
+		bench_report("write_elements_direct", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+
+		file = binary_file_openfor_read_direct(path, NULL);
+		bench_check(file != NULL, "open");
+		start = bench_now();
+		bench_check(binary_file_read_elements(samples, sizeof(f64), count, file), "read_elements_direct");
+		binary_file_close(file);
+		bench_report("read_elements_direct", sizeof(f64), count, count * sizeof(f64), bench_now() - start);
+		bench_check(samples[count - 1] == (f64)(count - 1), "read_elements_direct");
+	}
+
+	binary_file_buffer_pool_release((byte*)samples, pool);
+	binary_file_buffer_pool_destroy(pool);
+	remove((const char*)path);
+}
+// Scan a file as i32s and read 16 bytes every 64KB: through the FILE* stdio buffer, and through the read-ahead reader
+void bench_read_ahead(void)
+{
+	i64 count = bench_scaled(16 << 20);
+	i64 stride = 65536;
+	str path = bench_path("read_ahead");
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	binary_file_writer* writer = binary_file_writer_open(file, 1 << 20);
+	bench_check(writer != NULL, "writer open");
+	for (i64 i = 0; i < count; i++)
+		binary_file_writer_write_i32((i32)i, writer);
+	bench_check(binary_file_writer_close(writer), "writer close");
+	binary_file_close(file);
+	i64 strides = count * (i64)sizeof(i32) / stride;
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	i32 sum = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		i32 data = 0;
+		binary_file_read_i32(&data, file);
+		sum += data;
+	}
+	bench_report("scan_read_i32", sizeof(i32), count, count * (i64)sizeof(i32), bench_now() - start);
+
+	start = bench_now();
+	for (i64 i = 0; i < strides; i++)
+	{
+		i32 data[4];
+		bench_check(binary_file_set_position(i * stride, file) && binary_file_read_elements(data, sizeof(i32), 4, file), "read_elements");
+		sum += data[0];
+	}
+	bench_report("stride_read_elements", 16, strides, strides * 16, bench_now() - start);
+	binary_file_close(file);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	binary_file_reader* reader = binary_file_reader_open(file, 1 << 20);
+	bench_check(reader != NULL, "reader open");
+	for (i64 i = 0; i < count; i++)
+	{
+		i32 data = 0;
+		binary_file_reader_read_i32(&data, reader);
+		sum += data;
+	}
+	bench_report("scan_reader_read_i32", sizeof(i32), count, count * (i64)sizeof(i32), bench_now() - start);
+
+	start = bench_now();
+	for (i64 i = 0; i < strides; i++)
+	{
+		i32 data[4];
+		bench_check(binary_file_reader_set_position(i * stride, reader) && binary_file_reader_read_elements(data, sizeof(i32), 4, reader), "reader_read_elements");
+		sum += data[0];
+	}
+	bench_report("stride_reader_read_elements", 16, strides, strides * 16, bench_now() - start);
+	binary_file_reader_close(reader);
+	binary_file_close(file);
+	bench_sink += sum;
+
+	remove((const char*)path);
+}
+binary_file bench_shared_file = NULL;
+binary_file_shared_writer* bench_shared_writer = NULL;
+i64 bench_shared_records = 0;
+void bench_shared_stdio_producer(void* argument)
+{
+	byte record[64];
+	memset(record, (int)(intptr_t)argument, sizeof(record));
+	for (i64 i = 0; i < bench_shared_records; i++)
+		bench_check(binary_file_write_byte(record, sizeof(record), bench_shared_file), "write_byte");
+}
+void bench_shared_writer_producer(void* argument)
+{
+	byte record[64];
+	memset(record, (int)(intptr_t)argument, sizeof(record));
+	for (i64 i = 0; i < bench_shared_records; i++)
+		bench_check(binary_file_shared_writer_write(record, sizeof(record), bench_shared_writer), "shared_writer_write");
+}
+// Write 64-byte records to one file from several threads: through the locked FILE, and through the lock-free shared writer
+void bench_shared(void)
+{
+	str path = bench_path("shared");
+	bench_shared_records = bench_scaled(250000);
+
+	for (i32 thread_count = 1; thread_count <= 8; thread_count *= 2)
+	{
+		binary_file_thread threads[8];
+		char name[64];
+
+		bench_shared_file = binary_file_openfor_write_new(path);
+		bench_check(bench_shared_file != NULL, "open");
+		f64 start = bench_now();
+		for (i32 i = 0; i < thread_count; i++)
+			bench_check(binary_file_platform_thread_start(&threads[i], bench_shared_stdio_producer, (void*)(intptr_t)i), "thread_start");
+		for (i32 i = 0; i < thread_count; i++)
+			binary_file_platform_thread_join(threads[i]);
+		binary_file_close(bench_shared_file);
+		snprintf(name, sizeof(name), "shared_stdio_%dt", thread_count);
+		bench_report(name, 64, thread_count * bench_shared_records, thread_count * bench_shared_records * 64, bench_now() - start);
+
+		bench_shared_file = binary_file_openfor_write_new(path);
+		bench_check(bench_shared_file != NULL, "open");
+		start = bench_now();
+		bench_shared_writer = binary_file_shared_writer_open(bench_shared_file, 0);
+		bench_check(bench_shared_writer != NULL, "shared_writer_open");
+		for (i32 i = 0; i < thread_count; i++)
+			bench_check(binary_file_platform_thread_start(&threads[i], bench_shared_writer_producer, (void*)(intptr_t)i), "thread_start");
+		for (i32 i = 0; i < thread_count; i++)
+			binary_file_platform_thread_join(threads[i]);
+		bench_check(binary_file_shared_writer_close(bench_shared_writer), "shared_writer_close");
+		binary_file_close(bench_shared_file);
+		snprintf(name, sizeof(name), "shared_writer_%dt", thread_count);
+		bench_report(name, 64, thread_count * bench_shared_records, thread_count * bench_shared_records * 64, bench_now() - start);
+		bench_check(binary_file_get_length(path) == (file_size)(thread_count * bench_shared_records * 64), "shared_writer_length");
+	}
+
+	remove((const char*)path);
+}
+// Ask for the length of a file by name and of an open file
+void bench_get_length(void)
+{
+	i64 count = bench_scaled(200000);
+	str path = bench_path("length");
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	binary_file_write_i64(42, file);
+	binary_file_close(file);
+
+	f64 start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(binary_file_get_length(path) == sizeof(i64), "get_length");
+	bench_report("get_length", 0, count, 0, bench_now() - start);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(binary_file_get_open_length(file) == sizeof(i64), "get_open_length");
+	bench_report("get_open_length", 0, count, 0, bench_now() - start);
+	binary_file_close(file);
+
+	remove((const char*)path);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+		snprintf(bench_directory, sizeof(bench_directory), "%s", argv[1]);
+	if (argc > 2)
+		bench_scale = atof(argv[2]);
+	if (bench_scale <= 0.0)
+		bench_scale = 1.0;
+
+	bench_write_scalars();
+	bench_elements();
+	bench_strings();
+	bench_random_access();
+	bench_varints();
+	bench_bools();
+	bench_compressed();
+	bench_direct();
+	bench_columns();
+	bench_records();
+	bench_segments();
+	bench_transform();
+	bench_log();
+	bench_read_ahead();
+	bench_shared();
+	bench_get_length();
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+//
+// Benchmarks for the C++ struct serializer in binary_file.h: one call per field versus the generated routines
+//
+// Usage: binary_file_bench_structs [directory] [scale]
+//   Same arguments and JSON output as binary_file_bench.
+//
+
+#include "binary_file.h"
+
+#include <chrono>
+
+//
+// Benchmark state
+//
+char bench_directory[1024] = ".";
+f64 bench_scale = 1.0;
+
+//
+// Structs
+//
+struct bench_particle
+{
+	f32 x, y, z;
+	i32 id;
+};
+BINARY_FILE_FIELDS(bench_particle, x, y, z, id)
+
+struct bench_trade						// Has padding, so it is packed field by field
+{
+	i64 time;
+	u8 side;
+	f64 price;
+	i32 quantity;
+};
+BINARY_FILE_FIELDS(bench_trade, time, side, price, quantity)
+
+//
+// Helpers
+//
+
+// Get a monotonic time stamp in seconds
+f64 bench_now(void)
+{
+	return std::chrono::duration<f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+// Scale a work amount by the 'scale' argument (at least 1)
+i64 bench_scaled(i64 amount)
+{
+	i64 scaled = (i64)((f64)amount * bench_scale);
+	return (scaled < 1) ? 1 : scaled;
+}
+// Build the path of a temporary benchmark file
+str bench_path(const char* name)
+{
+	static char path[2048];
+	snprintf(path, sizeof(path), "%s/binary_file_bench_%s.bin", bench_directory, name);
+	return (str)path;
+}
+// Print one result line
+void bench_report(const char* name, i64 size, i64 ops, i64 bytes, f64 seconds)
+{
+	if (seconds <= 0.0)
+		seconds = 1e-9;
+
+	printf("{\"benchmark\":\"%s\",\"size\":%lld,\"ops\":%lld,\"bytes\":%lld,\"seconds\":%.6f,\"ns_per_op\":%.2f,\"mb_per_s\":%.2f}\n",
+		name, (long long)size, (long long)ops, (long long)bytes, seconds, seconds * 1e9 / (f64)ops, (f64)bytes / seconds / 1e6);
+	fflush(stdout);
+}
+// Stop the benchmark run if a file operation failed
+void bench_check(bool ok, const char* what)
+{
+	if (!ok)
+	{
+		fprintf(stderr, "Error: %s failed\n", what);
+		exit(1); // Exit to OS
+	}
+}
+
+//
+// Benchmarks
+//
+
+// Write structs with one call per field, one call per struct and one call for the whole array
+template<typename T, typename W>
+void bench_write(const char* name, T* data, i64 count, W write_fields)
+{
+	str path = bench_path(name);
+	i64 bytes = count * binary_file_get_struct_size<T>();
+	char label[128];
+
+	binary_file file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	f64 start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(write_fields(data[i], file), "write fields");
+	binary_file_close(file);
+	snprintf(label, sizeof(label), "write_fields_%s", name);
+	bench_report(label, binary_file_get_struct_size<T>(), count, bytes, bench_now() - start);
+
+	file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	for (i64 i = 0; i < count; i++)
+		bench_check(binary_file_write_struct(data[i], file), "write_struct");
+	binary_file_close(file);
+	snprintf(label, sizeof(label), "write_struct_%s", name);
+	bench_report(label, binary_file_get_struct_size<T>(), count, bytes, bench_now() - start);
+
+	file = binary_file_openfor_write_new(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_write_structs(data, count, file), "write_structs");
+	binary_file_close(file);
+	snprintf(label, sizeof(label), "write_structs_%s", name);
+	bench_report(label, binary_file_get_struct_size<T>(), count, bytes, bench_now() - start);
+
+	file = binary_file_openfor_read(path);
+	bench_check(file != NULL, "open");
+	start = bench_now();
+	bench_check(binary_file_read_structs(data, count, file), "read_structs");
+	binary_file_close(file);
+	snprintf(label, sizeof(label), "read_structs_%s", name);
+	bench_report(label, binary_file_get_struct_size<T>(), count, bytes, bench_now() - start);
+
+	remove((const char*)path);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+		snprintf(bench_directory, sizeof(bench_directory), "%s", argv[1]);
+	if (argc > 2)
+		bench_scale = atof(argv[2]);
+	if (bench_scale <= 0.0)
+		bench_scale = 1.0;
+
+	i64 count = bench_scaled(2000000);
+
+	bench_particle* particles = (bench_particle*)malloc(count * sizeof(bench_particle));
+	bench_check(particles != NULL, "malloc");
+	for (i64 i = 0; i < count; i++)
+		particles[i] = { (f32)i, (f32)i * 0.5f, (f32)i * 0.25f, (i32)i };
+	bench_write("particle", particles, count, [](const bench_particle& p, binary_file file)
+	{
+		return binary_file_write_f32(p.x, file) && binary_file_write_f32(p.y, file) && binary_file_write_f32(p.z, file) && binary_file_write_i32(p.id, file);
+	});
+	free(particles);
+
+	bench_trade* trades = (bench_trade*)malloc(count * sizeof(bench_trade));
+	bench_check(trades != NULL, "malloc");
+	for (i64 i = 0; i < count; i++)
+		trades[i] = { i * 1000, (u8)(i & 1), 100.0 + (f64)(i % 50), (i32)(i % 700) };
+	bench_write("trade", trades, count, [](const bench_trade& t, binary_file file)
+	{
+		return binary_file_write_i64(t.time, file) && binary_file_write_u8(t.side, file) && binary_file_write_f64(t.price, file) && binary_file_write_i32(t.quantity, file);
+	});
+	free(trades);
+
+	return 0;
+}
@@ -13,7 +13,6 @@
 //       otherwise remember to add +1 like this: text = malloc(size + 1);
 //       when dealing with strings (null terminated).
 //
-// TODO: Make this also to work with C++.
 // TODO: Make *__new(..) and *__delete(..) pairs for reading/writing strings to/from file instead of current function.
 // 
 // 
@@ -94,7 +93,7 @@
 //		
 //		i64 mydata4 = 0;
 //		binary_file_read_i64(&mydata4, file);
-//		printf("mydata4: %lli\n", mydata4);
+//		printf("mydata4: %lli\n", (long long)mydata4);
 //		
 //		u8 mydata5 = 0;
 //		binary_file_read_u8(&mydata5, file);
@@ -110,7 +109,7 @@
 //		
 //		u64 mydata8 = 0;
 //		binary_file_read_u64(&mydata8, file);
-//		printf("mydata8: %llu\n", mydata8);
+//		printf("mydata8: %llu\n", (unsigned long long)mydata8);
 //		
 //		binary_file_close(file);
 // 
@@ -203,11 +202,294 @@
 //		free(text4);
 //		
 //		binary_file_close(file);
+//
+// 
+// Example of reading many strings into one reused buffer
+// 
+//		binary_file file = binary_file_openfor_read("newbin.bin");
+//		if (file == NULL)
+//		{
+//			printf("Error: Failed to open binary file for reading\n");
+//			exit(1); // Exit to OS
+//		}
+//		
+//		c8 name[256];
+//		while (binary_file_read_str_into(name, sizeof(name), file) >= 0)
+//			printf("#%s#\n", name);
+//		
+//		binary_file_close(file);
+// 
+// 
+// Example of reading from a memory mapped file (no copies, pointers point into the file)
+// 
+//		binary_file_map* map = binary_file_mapfor_read("newbin.bin");
+//		if (map == NULL)
+//		{
+//			printf("Error: Failed to map binary file for reading\n");
+//			exit(1); // Exit to OS
+//		}
+//		
+//		binary_file_map_set_position(16, map);
+//		const i32* list = binary_file_map_read_elements(sizeof(i32), 4, map);
+//		if (list != NULL)
+//			printf("%d\n", list[0]);
+//		
+//		binary_file_map_close(map);
+// 
+// 
+// Example of writing many small values through a buffered writer
+// 
+//		binary_file file = binary_file_openfor_write_new("newbin.bin");
+//		if (file == NULL)
+//		{
+//			printf("Error: Failed to open binary file for writing\n");
+//			exit(1); // Exit to OS
+//		}
+//		
+//		binary_file_writer* writer = binary_file_writer_open(file, 1 << 20); // 1 MB buffer
+//		for (i32 i = 0; i < 1000000; i++)
+//		{
+//			binary_file_writer_write_i32(i, writer);
+//			binary_file_writer_write_f64(i * 0.5, writer);
+//		}
+//		binary_file_writer_close(writer); // Flushes the buffer
+//		
+//		binary_file_close(file);
+// 
+// 
+// Example of reading many chunks at once with the async I/O engine (io_uring on Linux, a thread pool elsewhere)
+// 
+//		binary_file file = binary_file_openfor_read("newbin.bin");
+//		binary_file_async* async = binary_file_async_create(64, 0); // 64 requests in flight, default thread count
+//		
+//		for (i32 i = 0; i < 64; i++)
+//			binary_file_async_read(chunks[i], 65536, (file_size)i * 65536, file, i, async);
+//		binary_file_async_submit(async);
+//		
+//		binary_file_async_completion completions[64];
+//		i64 count = binary_file_async_reap(completions, 64, 64, async); // Wait for all 64
+//		for (i64 i = 0; i < count; i++)
+//			printf("chunk %llu: %lld bytes\n", (unsigned long long)completions[i].user_data, (long long)completions[i].result);
+//		
+//		binary_file_async_close(async);
+//		binary_file_close(file);
+// 
+// 
+// Example of writing a file with a fixed byte order (readable on any host)
+// 
+//		binary_file file = binary_file_openfor_write_new("newbin.bin");
+//		binary_file_write_u32_le(0x46494C45, file);				// Magic number
+//		binary_file_write_f64_le(3.14, file);
+//		
+//		i32 list[4] = { 1, 2, 3, 4 };
+//		binary_file_write_elements_le(list, sizeof(i32), 4, file);	// Swapped in bulk only on big-endian hosts
+//		
+//		binary_file_close(file);
+// 
+// 
+// Example of reading a whole block of strings at once (one allocation for all of them)
+// 
+//		binary_file file = binary_file_openfor_read("newbin.bin");
+//		binary_file_str_table* table;
+//		while ((table = binary_file_read_str_table(1 << 20, file)) != NULL) // 1 MB per block
+//		{
+//			for (i64 i = 0; i < table->count; i++)
+//				printf("#%s#\n", binary_file_str_table_get(i, table));
+//			binary_file_str_table_free(table);
+//		}
+//		binary_file_close(file);
+// 
+// 
+// Example of compact length prefixed fields that can be skipped without reading them
+// 
+//		binary_file file = binary_file_openfor_write_new("newbin.bin");
+//		binary_file_write_varint_u64(300, file);			// 2 bytes
+//		binary_file_write_varint_i64(-3, file);			// 1 byte
+//		binary_file_write_str_prefixed("name", file);		// 1 + 4 bytes
+//		binary_file_write_blob(pixels, 1024, file);		// 2 + 1024 bytes, may contain zeros
+//		binary_file_close(file);
+//		
+//		file = binary_file_openfor_read("newbin.bin");
+//		u64 id;
+//		i64 delta;
+//		binary_file_read_varint_u64(&id, file);
+//		binary_file_read_varint_i64(&delta, file);
+//		binary_file_skip_blob(file);						// Skip the name
+//		i64 length;
+//		byte* data = binary_file_read_blob(&length, file);
+//		free(data);
+//		binary_file_close(file);
+// 
+// 
+// Example of packing bools and small fields into bits
+// 
+//		binary_file file = binary_file_openfor_write_new("newbin.bin");
+//		binary_file_write_bools_packed(flags, 1000000, file);			// 125000 bytes instead of 1000000
+//		
+//		binary_file_bit_writer* bits = binary_file_bit_writer_open(file);
+//		binary_file_bit_writer_write_bits(5, 3, bits);					// A 3-bit field
+//		binary_file_bit_writer_write_bool(true, bits);
+//		binary_file_bit_writer_close(bits);							// Pads to a whole byte
+//		binary_file_close(file);
+// 
+// 
+// Example of writing and reading a compressed file through the normal functions
+// 
+//		binary_file file = binary_file_openfor_write_compressed("newbin.lz", 0);	// Default block size
+//		binary_file_write_elements(samples, sizeof(f64), 1000000, file);
+//		if (!binary_file_close_checked(file))									// Writes the last block and the block index
+//			return false;														// The file is incomplete
+//		
+//		file = binary_file_openfor_read_compressed("newbin.lz");
+//		binary_file_set_position(500000 * sizeof(f64), file);					// Only decompresses one block
+//		f64 sample;
+//		binary_file_read_f64(&sample, file);
+//		binary_file_close(file);
+// 
+// Example of compressing on all cores with at most 16 blocks in memory
+// 
+//		binary_file_lz_options options = { 1 << 20, 0, 16 };					// 1MB blocks, one thread per CPU
+//		binary_file file = binary_file_openfor_write_compressed_parallel("newbin.lz", &options);
+//		binary_file_write_elements(samples, sizeof(f64), 100000000, file);
+//		if (!binary_file_close_checked(file))									// Waits for the last blocks
+//			return false;
+// 
+// Example of storing records column by column and scanning one column
+// 
+//		i64 sizes[3] = { sizeof(i64), sizeof(f64), sizeof(i32) };				// time, price, quantity
+//		i64 offsets[3] = { offsetof(trade, time), offsetof(trade, price), offsetof(trade, quantity) };
+//		binary_file_column_writer* writer = binary_file_column_writer_open("trades.col", 3, sizes, 0);
+//		binary_file_column_writer_write_records(trades, sizeof(trade), offsets, trade_count, writer);
+//		binary_file_column_writer_close(writer);
+//		
+//		binary_file_column_reader* reader = binary_file_column_reader_open("trades.col", true);	// Memory mapped
+//		binary_file_column_reader_read(prices, 1, 0, binary_file_column_reader_get_row_count(reader), reader);
+//		binary_file_column_reader_close(reader);
+// 
+// Example of a file of variable length records read back by record number
+// 
+//		binary_file_record_writer* writer = binary_file_record_writer_open("events.rec");
+//		binary_file_record_writer_append(event, event_length, writer);			// Any number of times
+//		binary_file_record_writer_close(writer);								// Writes the index
+//		
+//		binary_file_record_file* records = binary_file_record_file_open("events.rec");
+//		i64 length;
+//		byte* event = binary_file_record_file_read_new(&length, 123456, records);	// One positional read
+//		free(event);
+//		binary_file_record_file_close(records);
+// 
+// Example of a crash-safe event log shared by many threads
+// 
+//		binary_file_log* log = binary_file_log_open("events.log", 2000);			// Records wait at most 2ms to share a commit
+//		binary_file_log_append_sync(event, event_length, log);					// Returns when the event is on disk
+//		binary_file_log_close(log);
+//		
+//		binary_file_log_reader* reader = binary_file_log_reader_open("events.log");
+//		i64 length;
+//		const byte* record;
+//		while ((record = binary_file_log_reader_next(&length, reader)) != NULL)
+//			handle_event(record, length);
+//		binary_file_log_reader_close(reader);
+// 
+// Example of converting a large file of f64 to f32 on all cores
+// 
+//		i64 to_f32(const byte* input, i64 input_length, byte* output, i64 output_capacity, i64 index, void* user_data)
+//		{
+//			for (i64 i = 0; i < input_length / 8; i++)
+//				((f32*)output)[i] = (f32)((const f64*)input)[i];
+//			return input_length / 2;
+//		}
+//		...
+//		binary_file_pipeline_options options = { 1 << 20, 0, 1 << 19, 0, 0 };	// 1MB chunks become exactly 512KB, so they are written out of order
+//		binary_file_transform(to_f32, NULL, &options, input, output);
+//		binary_file_copy(input, backup);										// No transform: copied inside the kernel where it can be
+// 
+// Example of writing a record made of a header, a name and an array in one call, and reading it back the same way
+// 
+//		binary_file_segment segments[3] =
+//		{
+//			{ &header, sizeof(header) },
+//			{ name, header.name_length },
+//			{ points, header.point_count * sizeof(f32) },
+//		};
+//		binary_file_write_segments(segments, 3, file);		// Large records go to the file with one writev(), no staging copy
+//		...
+//		binary_file_read_segments_at(segments, 3, record_offset, file);	// One preadv() fills all three buffers
+// 
+// Example of reading many strings without one malloc() per string (freed all at once)
+// 
+//		binary_file_arena* arena = binary_file_arena_create(64 * 1024);
+//		str text;
+//		while ((text = binary_file_read_str_arena(arena, file)) != NULL)
+//			add_name(text);
+//		...
+//		binary_file_arena_reset(arena);										// Every string at once, the blocks are kept for reuse
+//		binary_file_arena_destroy(arena);
+// 
+// Example of dumping a large array past the page cache (O_DIRECT) with a buffer from a pool
+// 
+//		binary_file_buffer_pool* pool = binary_file_buffer_pool_create(64 << 20, 4);	// Four 64MB page aligned buffers
+//		f64* samples = (f64*)binary_file_buffer_pool_acquire(pool);			// Aligned, so written without a copy
+//		...
+//		binary_file file = binary_file_openfor_write_direct("samples.bin", pool);
+//		binary_file_write_elements(samples, sizeof(f64), sample_count, file);
+//		bool ok = binary_file_close_checked(file);								// Writes the unaligned tail and cuts the padding off
+//		binary_file_buffer_pool_release(samples, pool);
+//		binary_file_buffer_pool_destroy(pool);
+// 
+// Example of counting I/O (compile with BINARY_FILE_STATS defined, otherwise the counting is compiled out)
+// 
+//		binary_file_stats stats;
+//		binary_file_stats_get_file(&stats, file);								// Or binary_file_stats_get(&stats) for all files
+//		printf("reads: %llu, p99: %lld ns\n", (unsigned long long)stats.calls[BINARY_FILE_STATS_READ], (long long)binary_file_stats_get_percentile(&stats, BINARY_FILE_STATS_READ, 0.99));
+//		
+//		c8 json[8192];
+//		if (binary_file_stats_export(json, sizeof(json), &stats) > 0)
+//			publish_metrics(json);
+// 
+// Example of scanning a large file with read-ahead
+// 
+//		binary_file_reader* reader = binary_file_reader_open(file, 4 << 20);	// 4MB windows, the next one is read in the background
+//		i32 value;
+//		while (binary_file_reader_read_i32(&value, reader))
+//			sum += value;
+//		binary_file_reader_close(reader);
+// 
+// Example of many threads writing records to one file without taking a lock
+// 
+//		binary_file_shared_writer* writer = binary_file_shared_writer_open(file, 0);	// Default ring size
+//		...
+//		binary_file_shared_writer_write(event, event_length, writer);			// From any number of threads
+//		...
+//		binary_file_shared_writer_close(writer);								// After the producer threads are done
+//		binary_file_close(file);
+// 
+// Example of writing and reading structs in C++ (fields declared once)
+// 
+//		struct particle { f32 x, y, z; i32 id; };
+//		BINARY_FILE_FIELDS(particle, x, y, z, id)
+//		...
+//		binary_file_write_structs(particles, 1000000, file);					// One write call, the struct has no padding
+//		binary_file_read_struct(&first, file);
 // 
 // 
 
 #pragma once
 
+//
+// Platform configuration (these only take effect if this header is included before any system header, see the checks after the includes)
+//
+#ifndef _WIN32
+#ifdef _GNU_SOURCE
+#define BINARY_FILE_GNU_SOURCE		// Defined by the includer, so the GNU extensions are visible whatever was included first
+#else
+#define _GNU_SOURCE					// pread(), pwrite(), fileno(), fseeko() and friends
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64		// 64-bit file offsets also on 32-bit systems
+#endif
+#endif
+
 //
 // C includes
 //
@@ -215,19 +497,97 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+//
+// Platform includes
+//
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/uio.h>
+#endif
+#if defined(__linux__) && !defined(BINARY_FILE_NO_IO_URING)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#include <errno.h>
+#define BINARY_FILE_IO_URING // Async I/O uses io_uring (define BINARY_FILE_NO_IO_URING to always use the thread pool)
+#endif
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(__cplusplus) && ((defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 201703L)
+#define BINARY_FILE_STRUCTS // The struct serializer (needs C++17, left out of older C++ builds)
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#endif
+#if defined(__GLIBC__) && (!defined(__USE_XOPEN2K8) || !defined(__USE_MISC))
+#error "binary_file.h: The POSIX declarations are hidden (a system header was included before binary_file.h in strict ISO C mode). Include binary_file.h first, compile with -std=gnu11, or define _DEFAULT_SOURCE."
+#endif
+#if defined(__USE_GNU) || defined(BINARY_FILE_GNU_SOURCE)
+#define BINARY_FILE_GNU_EXTENSIONS // The GNU extensions are declared (a system header included before binary_file.h may have hidden them)
+#endif
+#if defined(BINARY_FILE_GNU_EXTENSIONS) && (defined(__GLIBC__) || (defined(__linux__) && !defined(__ANDROID__)))
+#define BINARY_FILE_STREAM_COOKIE // Custom FILE* streams with fopencookie() (used by the compressed stream mode)
+#endif
+#if defined(BINARY_FILE_GNU_EXTENSIONS) && defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define BINARY_FILE_COPY_RANGE // File to file copies inside the kernel with copy_file_range()
+#endif
+
+//
+// Configuration
+//
+#ifndef BINARY_FILE_STR_CHUNK_SIZE
+#define BINARY_FILE_STR_CHUNK_SIZE 256 // Bytes read per step when scanning for the end of a string
+#endif
+
+//
+// Byte order of the host (detected, unless BINARY_FILE_LITTLE_ENDIAN or BINARY_FILE_BIG_ENDIAN is defined by the includer)
+//
+#if defined(BINARY_FILE_LITTLE_ENDIAN) && defined(BINARY_FILE_BIG_ENDIAN)
+#error "binary_file.h: Define only one of BINARY_FILE_LITTLE_ENDIAN and BINARY_FILE_BIG_ENDIAN."
+#elif defined(BINARY_FILE_LITTLE_ENDIAN) || defined(BINARY_FILE_BIG_ENDIAN)
+// Given by the includer
+#elif defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define BINARY_FILE_LITTLE_ENDIAN
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BINARY_FILE_BIG_ENDIAN
+#else
+#error "binary_file.h: Unknown byte order. Define BINARY_FILE_LITTLE_ENDIAN on little-endian hosts, or BINARY_FILE_BIG_ENDIAN on big-endian hosts."
+#endif
+
 //
 // Data types
 //
-typedef char				 i8;
-typedef short				i16;
-typedef int					i32;
-typedef long long			i64;
-typedef unsigned char		 u8;
-typedef unsigned short		u16;
-typedef unsigned int		u32;
-typedef unsigned long long	u64;
+typedef int8_t				 i8;
+typedef int16_t				i16;
+typedef int32_t				i32;
+typedef int64_t				i64;
+typedef uint8_t				 u8;
+typedef uint16_t			u16;
+typedef uint32_t			u32;
+typedef uint64_t			u64;
 typedef float				f32;
 typedef double				f64;
 typedef unsigned char	   byte;
@@ -240,6 +600,610 @@ typedef unsigned char		 c8;
 typedef FILE*		binary_file;
 typedef i64			  file_size;
 
+//
+// Memory mapped file types
+//
+typedef struct binary_file_map
+{
+	byte* data;				// Start of the read-only view of the file (NULL for an empty file)
+	file_size length;		// Length of the file
+	file_size position;		// Cursor used by the binary_file_map_read_*(..) functions
+#ifdef _WIN32
+	HANDLE file_handle;
+	HANDLE mapping_handle;
+#endif
+} binary_file_map;
+
+//
+// Statistics types (define BINARY_FILE_STATS before including this file to count the I/O, otherwise the counting is compiled out)
+//
+#ifndef BINARY_FILE_STATS_MAX_FILES
+#define BINARY_FILE_STATS_MAX_FILES 64					// Binary files counted on their own (a power of two). Files beyond this only count in the totals.
+#endif
+#ifndef BINARY_FILE_STATS_SAMPLE
+#define BINARY_FILE_STATS_SAMPLE 16						// Time one in this many reads, writes and seeks per thread (a power of two, 1 = every call). Flushes are always timed.
+#endif
+#define BINARY_FILE_STATS_BUCKETS 40					// Latency histogram: bucket k counts timed calls that took less than 2^k nanoseconds (and not less than 2^(k-1))
+
+typedef enum binary_file_stats_operation
+{
+	BINARY_FILE_STATS_READ,								// fread() and positional reads
+	BINARY_FILE_STATS_WRITE,							// fwrite() and positional writes
+	BINARY_FILE_STATS_SEEK,								// binary_file_set_position*(..)
+	BINARY_FILE_STATS_FLUSH,							// Buffers written out by the buffered, bit, shared writers and the append log
+	BINARY_FILE_STATS_OPERATION_COUNT
+} binary_file_stats_operation;
+
+typedef struct binary_file_stats
+{
+	u64 calls[BINARY_FILE_STATS_OPERATION_COUNT];
+	u64 bytes[BINARY_FILE_STATS_OPERATION_COUNT];		// Bytes read, written and flushed
+	u64 short_reads;									// Reads that returned fewer bytes than asked for (also at the end of the file)
+	u64 failures;										// Writes and seeks that failed, reads that returned an error
+	u64 latency[BINARY_FILE_STATS_OPERATION_COUNT][BINARY_FILE_STATS_BUCKETS];	// Only the timed calls
+} binary_file_stats;
+
+typedef struct binary_file_stats_slot
+{
+	u64 file;											// The binary file counted here, 0 if never used, 1 if closed
+	binary_file_stats stats;
+} binary_file_stats_slot;
+
+#ifdef BINARY_FILE_STATS
+#define BINARY_FILE_FREAD(data, size, count, file) binary_file_stats_fread(data, size, count, file)
+#define BINARY_FILE_FWRITE(data, size, count, file) binary_file_stats_fwrite(data, size, count, file)
+#define BINARY_FILE_SEEK(offset, origin, file) binary_file_stats_seek(offset, origin, file)
+#define BINARY_FILE_STATS_START(start) i64 start = binary_file_stats_start()
+#define BINARY_FILE_STATS_TIME(start) i64 start = binary_file_platform_get_time_ns()
+#define BINARY_FILE_STATS_RECORD(operation, asked, done, start, file) binary_file_stats_record(operation, asked, done, start, file)
+#define BINARY_FILE_FCLOSE(file) binary_file_stats_fclose(file)
+#else
+#define BINARY_FILE_FREAD fread
+#define BINARY_FILE_FWRITE fwrite
+#define BINARY_FILE_SEEK binary_file_platform_seek
+#define BINARY_FILE_STATS_START(start)
+#define BINARY_FILE_STATS_TIME(start)
+#define BINARY_FILE_STATS_RECORD(operation, asked, done, start, file) ((void)0)
+#define BINARY_FILE_FCLOSE fclose
+#endif
+
+//
+// Buffered writer types
+//
+typedef struct binary_file_writer
+{
+	binary_file file;		// File the buffer is written to on flush
+	byte* buffer;			// Pending data not yet written to the file
+	i64 capacity;			// Size of the buffer
+	i64 used;				// Bytes pending in the buffer
+	bool growable;			// Grow the buffer instead of flushing when it is full (arena-style)
+} binary_file_writer;
+
+//
+// Columnar file types
+//
+#ifndef BINARY_FILE_COLUMN_GROUP_ROWS
+#define BINARY_FILE_COLUMN_GROUP_ROWS 65536 // Default rows buffered per column before they are written as one chunk
+#endif
+#define BINARY_FILE_COLUMN_ALIGNMENT 8		// Chunks start at a multiple of this, so mapped chunks can be used in place
+
+typedef struct binary_file_column_writer
+{
+	binary_file file;
+	i32 column_count;
+	i64* element_sizes;			// Size of one value of each column
+	byte** buffers;				// Buffered values of each column
+	i64 group_rows;				// Rows per group (chunk length of every column)
+	i64 used_rows;				// Rows buffered in the current group
+	i64 row_count;				// Rows written so far
+	u64* offsets;				// File offset of each chunk: offsets[group * column_count + column]
+	i64 group_count;
+	i64 group_capacity;
+	bool failed;				// A chunk could not be written. Every later write fails.
+} binary_file_column_writer;
+
+typedef struct binary_file_column_reader
+{
+	binary_file file;			// Used for positional reads when the file is not mapped
+	binary_file_map* map;		// Read-only view when opened mapped
+	i32 column_count;
+	i64* element_sizes;
+	i64 group_rows;
+	i64 row_count;
+	i64 group_count;
+	u64* offsets;
+} binary_file_column_reader;
+
+//
+// Record file types
+//
+typedef struct binary_file_record_writer
+{
+	binary_file file;
+	file_size position;			// Offset where the next record starts
+	u64* offsets;				// Offset of every record written (the index)
+	i64 count;
+	i64 capacity;
+} binary_file_record_writer;
+
+typedef struct binary_file_record_file
+{
+	binary_file file;			// Read with positional reads only, so threads can share it
+	u64* offsets;				// Offset of the length prefix of every record
+	i64 count;
+	file_size data_end;			// End of the last record (start of the index)
+} binary_file_record_file;
+
+typedef struct binary_file_record_slice
+{
+	binary_file file;
+	byte* data;					// Where the slice is read to
+	i64 length;
+	file_size offset;
+	bool ok;					// Set by the thread that read it
+} binary_file_record_slice;
+
+typedef struct binary_file_record_request
+{
+	u64 offset;					// Offset of the record in the file
+	i64 slot;					// Position of the record in the batch
+} binary_file_record_request;
+
+//
+// Bit packing types
+//
+#ifndef BINARY_FILE_BIT_BUFFER_SIZE
+#define BINARY_FILE_BIT_BUFFER_SIZE 4096 // Bytes buffered by the bit writer and bit reader
+#endif
+
+typedef struct binary_file_bit_writer
+{
+	binary_file file;
+	u64 bits;				// Pending bits, lowest bit first (always less than 8)
+	i32 bit_count;			// Number of pending bits
+	i64 used;				// Whole bytes waiting in 'buffer'
+	byte buffer[BINARY_FILE_BIT_BUFFER_SIZE];
+} binary_file_bit_writer;
+
+typedef struct binary_file_bit_reader
+{
+	binary_file file;
+	u64 bits;				// Bits read but not used yet, lowest bit first
+	i32 bit_count;			// Number of bits in 'bits'
+	i64 used;				// Bytes of 'buffer' already moved into 'bits'
+	i64 length;				// Bytes read into 'buffer'
+	byte buffer[BINARY_FILE_BIT_BUFFER_SIZE];
+} binary_file_bit_reader;
+
+//
+// String table types
+//
+typedef struct binary_file_str_table
+{
+	byte* data;				// One block holding all the strings with their null terminators
+	i64 length;				// Bytes used in 'data'
+	i64* offsets;			// Start of each string in 'data'
+	i64 count;				// Number of strings
+} binary_file_str_table;
+
+//
+// Arena types
+//
+#ifndef BINARY_FILE_ARENA_BLOCK_SIZE
+#define BINARY_FILE_ARENA_BLOCK_SIZE (64 * 1024) // Default size of each arena block
+#endif
+#define BINARY_FILE_ARENA_ALIGNMENT 8				// binary_file_arena_alloc() returns memory aligned for any i64, f64 or pointer
+
+typedef struct binary_file_arena_block
+{
+	struct binary_file_arena_block* next;	// Next block. Blocks stay in the list after a reset and are used again.
+	i64 capacity;							// Bytes in 'data'
+	byte* data;								// Memory of the block (right after this header)
+} binary_file_arena_block;
+
+typedef struct binary_file_arena
+{
+	binary_file_arena_block* first;		// First block (never NULL)
+	binary_file_arena_block* current;	// Block allocations are taken from
+	i64 used;							// Bytes used in the current block
+	i64 block_size;						// Size of new blocks (larger for allocations that do not fit)
+} binary_file_arena;
+
+//
+// Scatter/gather types
+//
+#ifndef BINARY_FILE_SEGMENTS_VECTOR_SIZE
+#define BINARY_FILE_SEGMENTS_VECTOR_SIZE (16 * 1024) // Segments totalling less than this go through the stdio buffer, larger ones straight to the file in one call
+#endif
+#define BINARY_FILE_SEGMENTS_BATCH 64				// Segments passed to the OS per readv()/writev() call
+
+typedef struct binary_file_segment
+{
+	void* data;				// Memory of the segment
+	i64 length;				// Bytes in the segment
+} binary_file_segment;
+
+//
+// Thread types
+//
+#ifdef _WIN32
+typedef HANDLE				binary_file_thread;
+typedef SRWLOCK				binary_file_mutex;
+typedef CONDITION_VARIABLE	binary_file_condition;
+#else
+typedef pthread_t			binary_file_thread;
+typedef pthread_mutex_t		binary_file_mutex;
+typedef pthread_cond_t		binary_file_condition;
+#endif
+typedef void (*binary_file_task_function)(void* argument);
+
+typedef struct binary_file_task
+{
+	binary_file_task_function function;
+	void* argument;
+} binary_file_task;
+
+typedef struct binary_file_thread_pool
+{
+	binary_file_thread* threads;
+	i32 thread_count;
+	binary_file_task* tasks;		// Ring buffer of queued tasks
+	i64 task_capacity;
+	i64 task_first;					// Index of the oldest queued task
+	i64 task_count;					// Number of queued tasks
+	i64 unfinished;					// Queued plus running tasks
+	bool stopping;
+	binary_file_mutex mutex;
+	binary_file_condition task_ready;
+	binary_file_condition all_done;
+} binary_file_thread_pool;
+
+//
+// Asynchronous I/O types
+//
+typedef struct binary_file_async_completion
+{
+	u64 user_data;					// Value given when the request was queued
+	i64 result;						// Bytes transferred (less than requested at the end of the file), or -1 on failure
+} binary_file_async_completion;
+
+typedef struct binary_file_async_request
+{
+	struct binary_file_async* async;
+	binary_file file;
+	void* data;
+	i64 length;
+	file_size offset;
+	u64 user_data;
+	bool write;
+	i64 result;							// Bytes done so far (io_uring), then the result
+#ifdef BINARY_FILE_IO_URING
+	struct iovec vector;
+#endif
+} binary_file_async_request;
+
+typedef struct binary_file_async
+{
+	i32 queue_depth;					// Maximum number of queued plus in flight requests
+	binary_file_async_request* requests;	// One slot per possible request
+	i32* free_slots;					// Stack of unused request slots
+	i32 free_count;
+	i32* queued_slots;					// Requests queued but not yet submitted
+	i32 queued_count;
+	i32 in_flight;						// Requests submitted but not yet reaped
+	bool uring;							// Uses io_uring, otherwise the thread pool
+#ifdef BINARY_FILE_IO_URING
+	int ring_descriptor;
+	void* submission_ring;
+	size_t submission_ring_size;
+	void* completion_ring;
+	size_t completion_ring_size;
+	struct io_uring_sqe* submission_entries;
+	size_t submission_entries_size;
+	u32* submission_head;
+	u32* submission_tail;
+	u32* submission_mask;
+	u32* submission_array;
+	u32* completion_head;
+	u32* completion_tail;
+	u32* completion_mask;
+	struct io_uring_cqe* completion_entries;
+	i32 unsubmitted;					// Entries in the submission ring the kernel has not taken yet
+#endif
+	binary_file_thread_pool* pool;		// Thread pool fallback
+	binary_file_async_completion* completed;	// Ring buffer of finished requests (thread pool fallback)
+	i32 completed_first;
+	i32 completed_count;
+	binary_file_mutex mutex;
+	binary_file_condition completion_ready;
+} binary_file_async;
+
+//
+// Compressed stream types
+//
+#ifndef BINARY_FILE_LZ_BLOCK_SIZE
+#define BINARY_FILE_LZ_BLOCK_SIZE (64 * 1024) // Default uncompressed size of a block in a compressed stream
+#endif
+
+#define BINARY_FILE_LZ_SLOT_FREE 0
+#define BINARY_FILE_LZ_SLOT_BUSY 1		// Being compressed or decompressed
+#define BINARY_FILE_LZ_SLOT_DONE 2
+#define BINARY_FILE_LZ_SLOT_FAILED 3
+
+typedef struct binary_file_lz_options
+{
+	i64 block_size;				// Uncompressed block size when writing (0 = BINARY_FILE_LZ_BLOCK_SIZE)
+	i32 thread_count;			// Compression threads (0 = one per CPU)
+	i32 max_in_flight;			// Blocks being compressed, written or read ahead at once (0 = twice the thread count)
+} binary_file_lz_options;
+
+typedef struct binary_file_lz_slot
+{
+	struct binary_file_lz_stream* stream;
+	byte* block;				// Uncompressed data
+	i64 block_used;
+	byte* compressed;
+	i64 compressed_size;		// 0 if the block is stored uncompressed
+	i64 index;					// Block number, -1 if none
+	i32 state;					// BINARY_FILE_LZ_SLOT_*
+} binary_file_lz_slot;
+
+typedef struct binary_file_lz_stream
+{
+	binary_file file;			// The real file holding the compressed blocks
+	bool writing;
+	i64 block_size;				// Uncompressed size of every block but the last
+	byte* block;				// Block being filled (writing) or the last decompressed block (reading)
+	i64 block_used;				// Bytes in 'block'
+	i64 block_index;			// Index of the block in 'block' when reading, -1 if none
+	byte* compressed;			// Room for one compressed block
+	i64 compressed_capacity;
+	u64* offsets;				// File offset of each block (the block index)
+	i64 block_count;
+	i64 offsets_capacity;
+	file_size length;			// Uncompressed length of the stream
+	file_size position;			// Uncompressed position when reading
+	binary_file_thread_pool* pool;		// Parallel mode: compresses or decompresses the blocks
+	binary_file_lz_slot* slots;			// Parallel mode: blocks in flight, block n uses slot n % slot_count
+	i32 slot_count;
+	i64 next_submit;					// Parallel writing: number of the next block handed to the pool
+	i64 next_write;						// Parallel writing: number of the next block the I/O thread writes
+	binary_file_thread io_thread;		// Parallel writing: writes the compressed blocks in order
+	bool io_started;
+	bool closing;
+	bool failed;
+	binary_file_mutex mutex;
+	binary_file_condition slot_changed;
+} binary_file_lz_stream;
+
+//
+// Append log types
+//
+#ifndef BINARY_FILE_LOG_BATCH_SIZE
+#define BINARY_FILE_LOG_BATCH_SIZE (1024 * 1024) // A group commit starts early once this many bytes are waiting; appends wait when 4 times this is waiting
+#endif
+
+typedef struct binary_file_log
+{
+	binary_file file;					// Opened with binary_file_openfor_write_append(..)
+	byte* pending;						// Framed records waiting for the next group commit
+	i64 pending_used;
+	i64 pending_capacity;
+	byte* flushing;						// Records being written and synced by the flusher
+	i64 flushing_capacity;
+	u64 appended;						// Sequence number of the last appended record
+	u64 durable;						// Sequence number of the last record on the storage device
+	i64 max_delay_us;					// Longest a record waits for others to share its commit
+	bool flush_requested;				// Commit now, without waiting for more records
+	bool stopping;
+	bool failed;						// A write or sync failed, nothing more becomes durable
+	binary_file_thread flusher;
+	binary_file_mutex mutex;
+	binary_file_condition pending_ready;	// The flusher waits on this
+	binary_file_condition durable_ready;	// Appending and waiting threads wait on this
+} binary_file_log;
+
+typedef struct binary_file_log_reader
+{
+	binary_file file;
+	byte* record;						// The last record read
+	i64 capacity;
+	file_size length;					// Length of the file
+	file_size position;					// End of the last valid record
+} binary_file_log_reader;
+
+//
+// Shared writer types
+//
+#ifndef BINARY_FILE_SHARED_WRITER_RING_SIZE
+#define BINARY_FILE_SHARED_WRITER_RING_SIZE (8 * 1024 * 1024) // Default ring size, also the most a write can wait behind
+#endif
+#define BINARY_FILE_CACHE_LINE_SIZE 64
+
+typedef struct binary_file_shared_writer
+{
+	volatile u64 reserved;				// End of the last reservation, in bytes since open (never wraps around)
+	byte reserved_padding[BINARY_FILE_CACHE_LINE_SIZE - sizeof(u64)];	// Keep the producers' cursor off the drainer's cache line
+	volatile u64 drained;				// Everything before this has been written out of the ring by the drainer
+	volatile u32 drainer_idle;			// The drainer sleeps until a producer wakes it
+	volatile u32 failed;				// A write failed, the rest of the records are dropped
+	byte drained_padding[BINARY_FILE_CACHE_LINE_SIZE - sizeof(u64) - 2 * sizeof(u32)];
+	binary_file file;
+	byte* ring;							// Record bytes in reservation order, followed by room for the part of a record that runs past the end
+	u64 ring_size;						// Power of two
+	volatile u64* committed;			// One bit per byte of the ring, set while the byte belongs to a committed record that is not written yet
+	bool direct;						// Written with pwritev() at 'file_position' instead of through the stdio buffer
+	file_size file_position;			// Where the drainer writes next (only used by the drainer until it stops)
+	u64 written;						// Everything before this is written to the file (protected by the mutex)
+	bool stopping;
+	binary_file_thread drainer;
+	binary_file_mutex mutex;
+	binary_file_condition work_ready;	// The drainer waits on this
+	binary_file_condition written_ready;	// Flushing threads wait on this
+} binary_file_shared_writer;
+
+//
+// Read-ahead reader types
+//
+#ifndef BINARY_FILE_READER_WINDOW_SIZE
+#define BINARY_FILE_READER_WINDOW_SIZE (1024 * 1024) // Default number of bytes read at a time
+#endif
+#define BINARY_FILE_READER_ALIGNMENT 4096				// Windows start on page boundaries and the buffers are page aligned
+
+typedef struct binary_file_reader
+{
+	binary_file file;					// Read with positional reads, the position of the file is not used or moved
+	file_size length;					// Length of the file when the reader was opened
+	file_size position;					// Next byte to read
+	i64 window_size;					// Size of each buffer
+	byte* window;						// Bytes [window_offset, window_offset + window_used) of the file
+	file_size window_offset;
+	i64 window_used;
+	byte* prefetch;						// The next window, read by the prefetch thread
+	file_size prefetch_offset;
+	i64 prefetch_length;				// Bytes asked for
+	i64 prefetch_used;					// Bytes read, -1 on failure
+	i32 prefetch_state;					// Idle, pending or ready (protected by the mutex)
+	bool stopping;
+	file_size seek_target;				// Stride detection: position of the last seek
+	i64 stride;							// Stride detection: distance between the last two forward seeks
+	i32 stride_hits;					// Stride detection: forward seeks in a row with that distance
+	i64 seek_read;						// Stride detection: bytes read since the last seek
+	i64 stride_read;					// Stride detection: bytes read between the last two seeks
+	binary_file_thread prefetcher;
+	binary_file_mutex mutex;
+	binary_file_condition prefetch_changed;
+} binary_file_reader;
+
+//
+// Direct I/O types
+//
+#ifndef BINARY_FILE_DIRECT_BUFFER_SIZE
+#define BINARY_FILE_DIRECT_BUFFER_SIZE (4 * 1024 * 1024)	// Staging buffer of a direct stream that has no buffer pool
+#endif
+#define BINARY_FILE_DIRECT_ALIGNMENT 4096				// Offsets, lengths and memory of direct transfers are multiples of this
+
+typedef struct binary_file_buffer_pool
+{
+	byte** buffers;						// Buffers not handed out
+	i32 count;							// Number of buffers not handed out
+	i32 capacity;						// Number of buffers in the pool
+	i64 buffer_size;					// A multiple of BINARY_FILE_DIRECT_ALIGNMENT
+	binary_file_mutex mutex;
+} binary_file_buffer_pool;
+
+typedef struct binary_file_direct_stream
+{
+	binary_file file;					// Opened with O_DIRECT, only aligned positional reads and writes are used on it
+	bool writing;
+	bool direct;						// False if the file system does not support O_DIRECT and the file was opened normally
+	byte* buffer;						// Aligned. Writing: the bytes not yet written (less than a block after a full write). Reading: the last blocks read.
+	i64 capacity;
+	i64 used;
+	file_size buffer_offset;			// Offset in the file of buffer[0], always aligned
+	file_size position;					// Position of the stream
+	file_size length;					// Reading: length of the file
+	binary_file_buffer_pool* pool;		// The buffer came from here (NULL = allocated by the stream)
+} binary_file_direct_stream;
+
+//
+// Pipeline types
+//
+#ifndef BINARY_FILE_PIPELINE_CHUNK_SIZE
+#define BINARY_FILE_PIPELINE_CHUNK_SIZE (1024 * 1024) // Default input bytes per chunk of a pipeline
+#endif
+
+#define BINARY_FILE_PIPELINE_SLOT_FREE 0
+#define BINARY_FILE_PIPELINE_SLOT_BUSY 1	// Being read, transformed or written
+#define BINARY_FILE_PIPELINE_SLOT_DONE 2
+#define BINARY_FILE_PIPELINE_SLOT_FAILED 3
+
+// Transform the 'input_length' bytes of chunk number 'index' into 'output', which can hold 'output_capacity' bytes. Returns the output length, or -1 on failure.
+// Called on several threads at once for different chunks.
+typedef i64 (*binary_file_transform_function)(const byte* input, i64 input_length, byte* output, i64 output_capacity, i64 index, void* user_data);
+
+typedef struct binary_file_pipeline_options
+{
+	i64 chunk_size;				// Input bytes per chunk (0 = BINARY_FILE_PIPELINE_CHUNK_SIZE). Keep it a multiple of the element or record size.
+	i64 output_capacity;		// Output bytes one chunk can become (0 = chunk_size)
+	i64 output_chunk_size;		// If not 0, every chunk but the last becomes exactly this many bytes and is written as soon as it is done
+	i32 thread_count;			// Transform threads (0 = one per CPU)
+	i32 max_in_flight;			// Chunks in memory at once (0 = twice the thread count)
+} binary_file_pipeline_options;
+
+typedef struct binary_file_pipeline_slot
+{
+	struct binary_file_pipeline* pipeline;
+	byte* input;
+	byte* output;				// NULL without a transform (the input is written as it is)
+	i64 output_length;
+	i64 index;					// Chunk number
+	i32 state;					// BINARY_FILE_PIPELINE_SLOT_*
+} binary_file_pipeline_slot;
+
+typedef struct binary_file_pipeline
+{
+	binary_file input;
+	binary_file output;
+	file_size input_offset;		// Where the chunks start in the input
+	file_size length;			// Input bytes to go through the pipeline
+	file_size output_offset;	// Where the output starts
+	binary_file_transform_function transform;	// NULL to copy
+	void* user_data;
+	i64 chunk_size;
+	i64 output_capacity;
+	i64 output_chunk_size;
+	binary_file_pipeline_slot* slots;	// Chunk n uses slot n % slot_count
+	i32 slot_count;
+	binary_file_mutex mutex;
+	binary_file_condition slot_changed;
+} binary_file_pipeline;
+
+//
+// Prototypes: Platform
+//
+bool binary_file_platform_seek(file_size offset, int origin, binary_file file);
+file_size binary_file_platform_tell(binary_file file);
+i64 binary_file_platform_pread(void* data, i64 length, file_size offset, binary_file file);
+i64 binary_file_platform_pwrite(const void* data, i64 length, file_size offset, binary_file file);
+i64 binary_file_platform_preadv(const binary_file_segment* segments, i64 count, file_size offset, binary_file file);
+i64 binary_file_platform_pwritev(const binary_file_segment* segments, i64 count, file_size offset, binary_file file);
+file_size binary_file_platform_get_length(binary_file file);
+file_size binary_file_platform_get_length_path(str filename);
+i64 binary_file_platform_get_lengths(str directory, str* filenames, i64 count, file_size* lengths);
+bool binary_file_platform_truncate(file_size length, binary_file file);
+bool binary_file_platform_sync(binary_file file);
+i64 binary_file_platform_get_time_us(void);
+i64 binary_file_platform_get_time_ns(void);
+bool binary_file_platform_map(str filename, binary_file_map* map);
+void binary_file_platform_unmap(binary_file_map* map);
+i32 binary_file_platform_get_cpu_count(void);
+bool binary_file_platform_thread_start(binary_file_thread* thread, binary_file_task_function function, void* argument);
+void binary_file_platform_thread_join(binary_file_thread thread);
+void binary_file_platform_mutex_init(binary_file_mutex* mutex);
+void binary_file_platform_mutex_destroy(binary_file_mutex* mutex);
+void binary_file_platform_mutex_lock(binary_file_mutex* mutex);
+void binary_file_platform_mutex_unlock(binary_file_mutex* mutex);
+void binary_file_platform_condition_init(binary_file_condition* condition);
+void binary_file_platform_condition_destroy(binary_file_condition* condition);
+void binary_file_platform_condition_wait(binary_file_condition* condition, binary_file_mutex* mutex);
+bool binary_file_platform_condition_wait_timeout(binary_file_condition* condition, binary_file_mutex* mutex, i64 microseconds);
+void binary_file_platform_condition_signal(binary_file_condition* condition);
+void binary_file_platform_condition_broadcast(binary_file_condition* condition);
+u64 binary_file_platform_atomic_load_u64(volatile u64* value);
+void binary_file_platform_atomic_store_u64(u64 data, volatile u64* value);
+void binary_file_platform_atomic_add_u64(u64 data, volatile u64* value);
+bool binary_file_platform_atomic_compare_exchange_u64(u64 expected, u64 desired, volatile u64* value);
+u32 binary_file_platform_atomic_load_u32(volatile u32* value);
+void binary_file_platform_atomic_store_u32(u32 data, volatile u32* value);
+void binary_file_platform_yield(void);
+void* binary_file_platform_aligned_alloc(i64 size, i64 alignment);
+void binary_file_platform_aligned_free(void* memory);
+void binary_file_platform_advise_sequential(binary_file file);
+void binary_file_platform_prefetch(file_size offset, i64 length, binary_file file);
+binary_file binary_file_platform_open_direct(str filename, bool writing, bool* direct);
+i64 binary_file_platform_copy_range(file_size input_offset, file_size output_offset, i64 length, binary_file input, binary_file output);
+
 //
 // Prototypes: Text file
 //
@@ -247,6 +1211,8 @@ binary_file binary_file_openfor_write_new(str filename);
 binary_file binary_file_openfor_write_append(str filename);
 binary_file binary_file_openfor_read(str filename);
 file_size binary_file_get_length(str filename);
+file_size binary_file_get_open_length(binary_file file);
+i64 binary_file_get_lengths(str directory, str* filenames, i64 count, file_size* lengths);
 bool binary_file_write_i8(i8 data, binary_file file);
 bool binary_file_write_i16(i16 data, binary_file file);
 bool binary_file_write_i32(i32 data, binary_file file);
@@ -274,363 +1240,7818 @@ bool binary_file_read_f64(f64* data, binary_file file);
 bool binary_file_read_bool(bool* data, binary_file file);
 bool binary_file_read_byte(byte* data, i64 length, binary_file file);
 str binary_file_read_str(binary_file file, str in_temp);
+i64 binary_file_read_str_into(str buffer, i64 capacity, binary_file file);
 bool binary_file_read_elements(void* data, i64 size, i64 count, binary_file file);
 bool binary_file_set_position_begin(binary_file file);
 bool binary_file_set_position(file_size position, binary_file file);
 bool binary_file_set_position_relative(file_size position, binary_file file);
 bool binary_file_set_position_end(binary_file file);
 file_size binary_file_get_position(binary_file file);
+i64 binary_file_get_remaining(binary_file file);
 void binary_file_close(binary_file file);
+bool binary_file_close_checked(binary_file file);
 
 //
-// Implementations: Binary file
+// Prototypes: Positional binary file (does not use or move the current position, safe to share one file between threads)
 //
+bool binary_file_write_i8_at(i8 data, file_size offset, binary_file file);
+bool binary_file_write_i16_at(i16 data, file_size offset, binary_file file);
+bool binary_file_write_i32_at(i32 data, file_size offset, binary_file file);
+bool binary_file_write_i64_at(i64 data, file_size offset, binary_file file);
+bool binary_file_write_u8_at(u8 data, file_size offset, binary_file file);
+bool binary_file_write_u16_at(u16 data, file_size offset, binary_file file);
+bool binary_file_write_u32_at(u32 data, file_size offset, binary_file file);
+bool binary_file_write_u64_at(u64 data, file_size offset, binary_file file);
+bool binary_file_write_f32_at(f32 data, file_size offset, binary_file file);
+bool binary_file_write_f64_at(f64 data, file_size offset, binary_file file);
+bool binary_file_write_bool_at(bool data, file_size offset, binary_file file);
+bool binary_file_write_byte_at(byte* data, i64 length, file_size offset, binary_file file);
+bool binary_file_write_elements_at(void* data, i64 size, i64 count, file_size offset, binary_file file);
+bool binary_file_read_i8_at(i8* data, file_size offset, binary_file file);
+bool binary_file_read_i16_at(i16* data, file_size offset, binary_file file);
+bool binary_file_read_i32_at(i32* data, file_size offset, binary_file file);
+bool binary_file_read_i64_at(i64* data, file_size offset, binary_file file);
+bool binary_file_read_u8_at(u8* data, file_size offset, binary_file file);
+bool binary_file_read_u16_at(u16* data, file_size offset, binary_file file);
+bool binary_file_read_u32_at(u32* data, file_size offset, binary_file file);
+bool binary_file_read_u64_at(u64* data, file_size offset, binary_file file);
+bool binary_file_read_f32_at(f32* data, file_size offset, binary_file file);
+bool binary_file_read_f64_at(f64* data, file_size offset, binary_file file);
+bool binary_file_read_bool_at(bool* data, file_size offset, binary_file file);
+bool binary_file_read_byte_at(byte* data, i64 length, file_size offset, binary_file file);
+bool binary_file_read_elements_at(void* data, i64 size, i64 count, file_size offset, binary_file file);
 
-// Open a binary file for writing in truncate mode.
-binary_file binary_file_openfor_write_new(str filename)
-{
-	// Create a binary file. Truncate the file if it already exists.
-	binary_file file = fopen((const char*)filename, "wb");
+//
+// Prototypes: Scatter/gather (several buffers written from or read into one contiguous part of a binary file)
+//
+i64 binary_file_get_segments_length(const binary_file_segment* segments, i64 count);
+bool binary_file_write_segments(const binary_file_segment* segments, i64 count, binary_file file);
+bool binary_file_read_segments(const binary_file_segment* segments, i64 count, binary_file file);
+bool binary_file_write_segments_at(const binary_file_segment* segments, i64 count, file_size offset, binary_file file);
+bool binary_file_read_segments_at(const binary_file_segment* segments, i64 count, file_size offset, binary_file file);
 
-	return file;
-}
-// Open a binary file for writing in append mode.
-binary_file binary_file_openfor_write_append(str filename)
-{
+//
+// Prototypes: Byte order (little-endian '_le' and big-endian '_be' file layouts, independent of the host)
+//
+u16 binary_file_swap_u16(u16 data);
+u32 binary_file_swap_u32(u32 data);
+u64 binary_file_swap_u64(u64 data);
+void binary_file_swap_elements(void* destination, const void* source, i64 size, i64 count);
+bool binary_file_write_i16_le(i16 data, binary_file file);
+bool binary_file_write_i32_le(i32 data, binary_file file);
+bool binary_file_write_i64_le(i64 data, binary_file file);
+bool binary_file_write_u16_le(u16 data, binary_file file);
+bool binary_file_write_u32_le(u32 data, binary_file file);
+bool binary_file_write_u64_le(u64 data, binary_file file);
+bool binary_file_write_f32_le(f32 data, binary_file file);
+bool binary_file_write_f64_le(f64 data, binary_file file);
+bool binary_file_write_elements_le(void* data, i64 size, i64 count, binary_file file);
+bool binary_file_write_i16_be(i16 data, binary_file file);
+bool binary_file_write_i32_be(i32 data, binary_file file);
+bool binary_file_write_i64_be(i64 data, binary_file file);
+bool binary_file_write_u16_be(u16 data, binary_file file);
+bool binary_file_write_u32_be(u32 data, binary_file file);
+bool binary_file_write_u64_be(u64 data, binary_file file);
+bool binary_file_write_f32_be(f32 data, binary_file file);
+bool binary_file_write_f64_be(f64 data, binary_file file);
+bool binary_file_write_elements_be(void* data, i64 size, i64 count, binary_file file);
+bool binary_file_read_i16_le(i16* data, binary_file file);
+bool binary_file_read_i32_le(i32* data, binary_file file);
+bool binary_file_read_i64_le(i64* data, binary_file file);
+bool binary_file_read_u16_le(u16* data, binary_file file);
+bool binary_file_read_u32_le(u32* data, binary_file file);
+bool binary_file_read_u64_le(u64* data, binary_file file);
+bool binary_file_read_f32_le(f32* data, binary_file file);
+bool binary_file_read_f64_le(f64* data, binary_file file);
+bool binary_file_read_elements_le(void* data, i64 size, i64 count, binary_file file);
+bool binary_file_read_i16_be(i16* data, binary_file file);
+bool binary_file_read_i32_be(i32* data, binary_file file);
+bool binary_file_read_i64_be(i64* data, binary_file file);
+bool binary_file_read_u16_be(u16* data, binary_file file);
+bool binary_file_read_u32_be(u32* data, binary_file file);
+bool binary_file_read_u64_be(u64* data, binary_file file);
+bool binary_file_read_f32_be(f32* data, binary_file file);
+bool binary_file_read_f64_be(f64* data, binary_file file);
+bool binary_file_read_elements_be(void* data, i64 size, i64 count, binary_file file);
+
+//
+// Prototypes: String scanning and string tables
+//
+i64 binary_file_find_zero(const byte* data, i64 length);
+i64 binary_file_find_zeros(const byte* data, i64 length, i64* positions);
+binary_file_str_table* binary_file_read_str_table(i64 length, binary_file file);
+str binary_file_str_table_get(i64 index, binary_file_str_table* table);
+i64 binary_file_str_table_get_length(i64 index, binary_file_str_table* table);
+void binary_file_str_table_free(binary_file_str_table* table);
+
+//
+// Prototypes: Arena (bump allocator, everything is freed at once) and strings read into an arena
+//
+binary_file_arena* binary_file_arena_create(i64 block_size);
+void* binary_file_arena_alloc(i64 size, binary_file_arena* arena);
+byte* binary_file_arena_reserve(i64 size, i64* available, binary_file_arena* arena);
+void binary_file_arena_commit(i64 size, binary_file_arena* arena);
+void binary_file_arena_reset(binary_file_arena* arena);
+void binary_file_arena_destroy(binary_file_arena* arena);
+str binary_file_read_str_arena(binary_file_arena* arena, binary_file file);
+byte* binary_file_read_blob_arena(i64* length, binary_file_arena* arena, binary_file file);
+str binary_file_read_str_prefixed_arena(binary_file_arena* arena, binary_file file);
+
+//
+// Prototypes: Variable length integers (LEB128 varints, zigzag for signed) and length prefixed strings/blobs
+//
+i32 binary_file_encode_varint(u64 data, byte* buffer);
+i32 binary_file_decode_varint(const byte* data, i64 length, u64* value);
+bool binary_file_write_varint_u32(u32 data, binary_file file);
+bool binary_file_write_varint_u64(u64 data, binary_file file);
+bool binary_file_write_varint_i32(i32 data, binary_file file);
+bool binary_file_write_varint_i64(i64 data, binary_file file);
+bool binary_file_write_blob(byte* data, i64 length, binary_file file);
+bool binary_file_write_str_prefixed(str text, binary_file file);
+bool binary_file_read_varint_u32(u32* data, binary_file file);
+bool binary_file_read_varint_u64(u64* data, binary_file file);
+bool binary_file_read_varint_i32(i32* data, binary_file file);
+bool binary_file_read_varint_i64(i64* data, binary_file file);
+byte* binary_file_read_blob(i64* length, binary_file file);
+i64 binary_file_read_blob_into(byte* buffer, i64 capacity, binary_file file);
+str binary_file_read_str_prefixed(binary_file file);
+i64 binary_file_read_str_prefixed_into(str buffer, i64 capacity, binary_file file);
+bool binary_file_skip_blob(binary_file file);
+bool binary_file_writer_write_varint_u64(u64 data, binary_file_writer* writer);
+bool binary_file_writer_write_varint_i64(i64 data, binary_file_writer* writer);
+bool binary_file_writer_write_blob(byte* data, i64 length, binary_file_writer* writer);
+bool binary_file_map_read_varint_u64(u64* data, binary_file_map* map);
+bool binary_file_map_read_varint_i64(i64* data, binary_file_map* map);
+const byte* binary_file_map_read_blob(i64* length, binary_file_map* map);
+
+//
+// Prototypes: Bit packing (bools and fields of any width packed into bits, lowest bit first)
+//
+void binary_file_pack_bools(const bool* data, i64 count, byte* packed);
+void binary_file_unpack_bools(const byte* packed, i64 count, bool* data);
+bool binary_file_write_bools_packed(const bool* data, i64 count, binary_file file);
+bool binary_file_read_bools_packed(bool* data, i64 count, binary_file file);
+binary_file_bit_writer* binary_file_bit_writer_open(binary_file file);
+bool binary_file_bit_writer_write_bits(u64 data, i32 width, binary_file_bit_writer* writer);
+bool binary_file_bit_writer_write_bool(bool data, binary_file_bit_writer* writer);
+bool binary_file_bit_writer_write_bools(const bool* data, i64 count, binary_file_bit_writer* writer);
+bool binary_file_bit_writer_flush(binary_file_bit_writer* writer);
+bool binary_file_bit_writer_close(binary_file_bit_writer* writer);
+binary_file_bit_reader* binary_file_bit_reader_open(binary_file file);
+bool binary_file_bit_reader_read_bits(u64* data, i32 width, binary_file_bit_reader* reader);
+bool binary_file_bit_reader_read_bool(bool* data, binary_file_bit_reader* reader);
+bool binary_file_bit_reader_read_bools(bool* data, i64 count, binary_file_bit_reader* reader);
+void binary_file_bit_reader_align(binary_file_bit_reader* reader);
+bool binary_file_bit_reader_close(binary_file_bit_reader* reader);
+
+//
+// Prototypes: Block compression (fast LZ4-style codec) and compressed streams
+//
+i64 binary_file_lz_bound(i64 length);
+i64 binary_file_lz_compress(const byte* source, i64 length, byte* destination, i64 capacity);
+i64 binary_file_lz_decompress(const byte* source, i64 length, byte* destination, i64 capacity);
+binary_file binary_file_openfor_write_compressed(str filename, i64 block_size);
+binary_file binary_file_openfor_read_compressed(str filename);
+binary_file binary_file_openfor_write_compressed_parallel(str filename, const binary_file_lz_options* options);
+binary_file binary_file_openfor_read_compressed_parallel(str filename, const binary_file_lz_options* options);
+
+//
+// Prototypes: Direct I/O (O_DIRECT streams that bypass the page cache, and a pool of aligned buffers)
+//
+binary_file_buffer_pool* binary_file_buffer_pool_create(i64 buffer_size, i32 buffer_count);
+byte* binary_file_buffer_pool_acquire(binary_file_buffer_pool* pool);
+void binary_file_buffer_pool_release(byte* buffer, binary_file_buffer_pool* pool);
+i64 binary_file_buffer_pool_get_buffer_size(binary_file_buffer_pool* pool);
+void binary_file_buffer_pool_destroy(binary_file_buffer_pool* pool);
+binary_file binary_file_openfor_write_direct(str filename, binary_file_buffer_pool* pool);
+binary_file binary_file_openfor_read_direct(str filename, binary_file_buffer_pool* pool);
+
+//
+// Prototypes: Memory mapped binary file
+//
+binary_file_map* binary_file_mapfor_read(str filename);
+file_size binary_file_map_get_length(binary_file_map* map);
+const byte* binary_file_map_read_byte(i64 length, binary_file_map* map);
+const void* binary_file_map_read_elements(i64 size, i64 count, binary_file_map* map);
+const c8* binary_file_map_read_str(binary_file_map* map);
+bool binary_file_map_read_i8(i8* data, binary_file_map* map);
+bool binary_file_map_read_i16(i16* data, binary_file_map* map);
+bool binary_file_map_read_i32(i32* data, binary_file_map* map);
+bool binary_file_map_read_i64(i64* data, binary_file_map* map);
+bool binary_file_map_read_u8(u8* data, binary_file_map* map);
+bool binary_file_map_read_u16(u16* data, binary_file_map* map);
+bool binary_file_map_read_u32(u32* data, binary_file_map* map);
+bool binary_file_map_read_u64(u64* data, binary_file_map* map);
+bool binary_file_map_read_f32(f32* data, binary_file_map* map);
+bool binary_file_map_read_f64(f64* data, binary_file_map* map);
+bool binary_file_map_read_bool(bool* data, binary_file_map* map);
+bool binary_file_map_set_position_begin(binary_file_map* map);
+bool binary_file_map_set_position(file_size position, binary_file_map* map);
+bool binary_file_map_set_position_relative(file_size position, binary_file_map* map);
+bool binary_file_map_set_position_end(binary_file_map* map);
+file_size binary_file_map_get_position(binary_file_map* map);
+void binary_file_map_close(binary_file_map* map);
+
+//
+// Prototypes: Buffered binary file writer
+//
+binary_file_writer* binary_file_writer_open(binary_file file, i64 capacity);
+binary_file_writer* binary_file_writer_open_growable(binary_file file, i64 initial_capacity);
+bool binary_file_writer_reserve(i64 length, binary_file_writer* writer);
+bool binary_file_writer_write_i8(i8 data, binary_file_writer* writer);
+bool binary_file_writer_write_i16(i16 data, binary_file_writer* writer);
+bool binary_file_writer_write_i32(i32 data, binary_file_writer* writer);
+bool binary_file_writer_write_i64(i64 data, binary_file_writer* writer);
+bool binary_file_writer_write_u8(u8 data, binary_file_writer* writer);
+bool binary_file_writer_write_u16(u16 data, binary_file_writer* writer);
+bool binary_file_writer_write_u32(u32 data, binary_file_writer* writer);
+bool binary_file_writer_write_u64(u64 data, binary_file_writer* writer);
+bool binary_file_writer_write_f32(f32 data, binary_file_writer* writer);
+bool binary_file_writer_write_f64(f64 data, binary_file_writer* writer);
+bool binary_file_writer_write_bool(bool data, binary_file_writer* writer);
+bool binary_file_writer_write_byte(byte* data, i64 length, binary_file_writer* writer);
+bool binary_file_writer_write_str(str text, binary_file_writer* writer);
+bool binary_file_writer_write_elements(void* data, i64 size, i64 count, binary_file_writer* writer);
+bool binary_file_writer_flush(binary_file_writer* writer);
+bool binary_file_writer_close(binary_file_writer* writer);
+
+//
+// Prototypes: Read-ahead binary file reader (large page aligned windows, the next window read in the background, forward strides detected)
+//
+binary_file_reader* binary_file_reader_open(binary_file file, i64 window_size);
+bool binary_file_reader_read_i8(i8* data, binary_file_reader* reader);
+bool binary_file_reader_read_i16(i16* data, binary_file_reader* reader);
+bool binary_file_reader_read_i32(i32* data, binary_file_reader* reader);
+bool binary_file_reader_read_i64(i64* data, binary_file_reader* reader);
+bool binary_file_reader_read_u8(u8* data, binary_file_reader* reader);
+bool binary_file_reader_read_u16(u16* data, binary_file_reader* reader);
+bool binary_file_reader_read_u32(u32* data, binary_file_reader* reader);
+bool binary_file_reader_read_u64(u64* data, binary_file_reader* reader);
+bool binary_file_reader_read_f32(f32* data, binary_file_reader* reader);
+bool binary_file_reader_read_f64(f64* data, binary_file_reader* reader);
+bool binary_file_reader_read_bool(bool* data, binary_file_reader* reader);
+bool binary_file_reader_read_byte(byte* data, i64 length, binary_file_reader* reader);
+bool binary_file_reader_read_elements(void* data, i64 size, i64 count, binary_file_reader* reader);
+bool binary_file_reader_set_position(file_size position, binary_file_reader* reader);
+bool binary_file_reader_set_position_relative(file_size position, binary_file_reader* reader);
+file_size binary_file_reader_get_position(binary_file_reader* reader);
+void binary_file_reader_close(binary_file_reader* reader);
+
+//
+// Prototypes: Columnar binary file (struct-of-arrays records, each column read on its own)
+//
+binary_file_column_writer* binary_file_column_writer_open(str filename, i32 column_count, const i64* element_sizes, i64 group_rows);
+bool binary_file_column_writer_write_row(const void* const* values, binary_file_column_writer* writer);
+bool binary_file_column_writer_write_records(const void* records, i64 record_size, const i64* field_offsets, i64 count, binary_file_column_writer* writer);
+bool binary_file_column_writer_close(binary_file_column_writer* writer);
+binary_file_column_reader* binary_file_column_reader_open(str filename, bool mapped);
+i64 binary_file_column_reader_get_row_count(binary_file_column_reader* reader);
+i32 binary_file_column_reader_get_column_count(binary_file_column_reader* reader);
+i64 binary_file_column_reader_get_element_size(i32 column, binary_file_column_reader* reader);
+bool binary_file_column_reader_read(void* data, i32 column, i64 first_row, i64 count, binary_file_column_reader* reader);
+const void* binary_file_column_reader_get_chunk(i32 column, i64 row, i64* row_count, binary_file_column_reader* reader);
+void binary_file_column_reader_close(binary_file_column_reader* reader);
+
+//
+// Prototypes: Record file (variable length records with an offset index, record k in one positional read)
+//
+binary_file_record_writer* binary_file_record_writer_open(str filename);
+bool binary_file_record_writer_append(const void* data, i64 length, binary_file_record_writer* writer);
+i64 binary_file_record_writer_get_count(binary_file_record_writer* writer);
+bool binary_file_record_writer_close(binary_file_record_writer* writer);
+binary_file_record_file* binary_file_record_file_open(str filename);
+i64 binary_file_record_file_get_count(binary_file_record_file* records);
+i64 binary_file_record_file_get_length(i64 index, binary_file_record_file* records);
+i64 binary_file_record_file_read(void* data, i64 capacity, i64 index, binary_file_record_file* records);
+byte* binary_file_record_file_read_new(i64* length, i64 index, binary_file_record_file* records);
+bool binary_file_record_file_read_batch(const i64* indices, i64 count, byte** data, i64* lengths, binary_file_record_file* records);
+i64 binary_file_record_file_rebuild_index(str filename, i32 thread_count);
+void binary_file_record_file_close(binary_file_record_file* records);
+
+//
+// Prototypes: Append log (CRC32C framed records, group commit with fdatasync, torn tail recovery)
+//
+u32 binary_file_crc32c(const void* data, i64 length, u32 crc);
+binary_file_log* binary_file_log_open(str filename, i64 max_delay_us);
+u64 binary_file_log_append(const void* data, i64 length, binary_file_log* log);
+bool binary_file_log_wait(u64 sequence, binary_file_log* log);
+u64 binary_file_log_append_sync(const void* data, i64 length, binary_file_log* log);
+bool binary_file_log_flush(binary_file_log* log);
+bool binary_file_log_close(binary_file_log* log);
+binary_file_log_reader* binary_file_log_reader_open(str filename);
+const byte* binary_file_log_reader_next(i64* length, binary_file_log_reader* reader);
+file_size binary_file_log_reader_get_position(binary_file_log_reader* reader);
+void binary_file_log_reader_close(binary_file_log_reader* reader);
+
+//
+// Prototypes: Shared writer (many threads write records to one file without a lock, one drainer thread writes them in large writes)
+//
+binary_file_shared_writer* binary_file_shared_writer_open(binary_file file, i64 ring_size);
+byte* binary_file_shared_writer_reserve(i64 length, binary_file_shared_writer* writer);
+void binary_file_shared_writer_commit(byte* record, i64 length, binary_file_shared_writer* writer);
+bool binary_file_shared_writer_write(const void* data, i64 length, binary_file_shared_writer* writer);
+bool binary_file_shared_writer_flush(binary_file_shared_writer* writer);
+bool binary_file_shared_writer_close(binary_file_shared_writer* writer);
+
+//
+// Prototypes: Statistics (per binary file and in total, only counted when BINARY_FILE_STATS is defined)
+//
+bool binary_file_stats_get(binary_file_stats* stats);
+bool binary_file_stats_get_file(binary_file_stats* stats, binary_file file);
+void binary_file_stats_reset(void);
+i64 binary_file_stats_get_percentile(const binary_file_stats* stats, binary_file_stats_operation operation, f64 percentile);
+i64 binary_file_stats_export(c8* buffer, i64 capacity, const binary_file_stats* stats);
+i64 binary_file_stats_start(void);
+void binary_file_stats_record(binary_file_stats_operation operation, i64 asked, i64 done, i64 start, binary_file file);
+void binary_file_stats_forget(binary_file file);
+size_t binary_file_stats_fread(void* data, size_t size, size_t count, binary_file file);
+size_t binary_file_stats_fwrite(const void* data, size_t size, size_t count, binary_file file);
+bool binary_file_stats_seek(file_size offset, int origin, binary_file file);
+int binary_file_stats_fclose(binary_file file);
+
+//
+// Prototypes: Thread pool
+//
+binary_file_thread_pool* binary_file_thread_pool_create(i32 thread_count);
+bool binary_file_thread_pool_submit(binary_file_task_function function, void* argument, binary_file_thread_pool* pool);
+void binary_file_thread_pool_wait(binary_file_thread_pool* pool);
+void binary_file_thread_pool_destroy(binary_file_thread_pool* pool);
+
+//
+// Prototypes: Asynchronous binary file I/O
+//
+binary_file_async* binary_file_async_create(i32 queue_depth, i32 thread_count);
+bool binary_file_async_read(void* data, i64 length, file_size offset, binary_file file, u64 user_data, binary_file_async* async);
+bool binary_file_async_write(void* data, i64 length, file_size offset, binary_file file, u64 user_data, binary_file_async* async);
+i64 binary_file_async_submit(binary_file_async* async);
+i64 binary_file_async_reap(binary_file_async_completion* completions, i64 max_count, i64 min_count, binary_file_async* async);
+bool binary_file_async_is_uring(binary_file_async* async);
+void binary_file_async_close(binary_file_async* async);
+
+//
+// Prototypes: Pipeline (a file copied or transformed chunk by chunk on a thread pool, reads, transforms and writes overlapping)
+//
+i64 binary_file_transform(binary_file_transform_function transform, void* user_data, const binary_file_pipeline_options* options, binary_file input, binary_file output);
+i64 binary_file_copy(binary_file input, binary_file output);
+
+//
+// Implementations: Platform
+//
+
+// Seek in a binary file with a 64-bit offset. Note: the regular fseek() supports only file sizes up to 2GB. These support up to 8 Exabytes.
+bool binary_file_platform_seek(file_size offset, int origin, binary_file file)
+{
+#ifdef _WIN32
+	return (_fseeki64(file, offset, origin) == 0);
+#else
+	return (fseeko(file, (off_t)offset, origin) == 0);
+#endif
+}
+// Get the current position in a binary file with a 64-bit offset. Returns -1 on failure.
+file_size binary_file_platform_tell(binary_file file)
+{
+#ifdef _WIN32
+	return _ftelli64(file);
+#else
+	return (file_size)ftello(file);
+#endif
+}
+// Read up to 'length' bytes at 'offset' without using or moving the stream position. Returns the number of bytes read (less at the end of the file), or -1 on failure.
+// Note: This bypasses the stdio buffer. Call fflush() first if data was just written through the stream.
+i64 binary_file_platform_pread(void* data, i64 length, file_size offset, binary_file file)
+{
+	BINARY_FILE_STATS_START(start);
+	i64 total = 0;
+#ifdef _WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+	while (total < length)
+	{
+		DWORD chunk = (length - total > 0x40000000) ? 0x40000000 : (DWORD)(length - total);
+		OVERLAPPED overlapped = { 0 };
+		overlapped.Offset = (DWORD)((offset + total) & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+		DWORD read = 0;
+		if (!ReadFile(handle, (byte*)data + total, chunk, &read, &overlapped))
+		{
+			if (GetLastError() != ERROR_HANDLE_EOF)
+				total = -1; // Failure
+			break;
+		}
+		if (read == 0)
+			break; // End of the file
+		total += read;
+	}
+#else
+	int descriptor = fileno(file);
+	while (total < length)
+	{
+		ssize_t read = pread(descriptor, (byte*)data + total, (size_t)(length - total), (off_t)(offset + total));
+		if (read < 0)
+		{
+			total = -1; // Failure
+			break;
+		}
+		if (read == 0)
+			break; // End of the file
+		total += read;
+	}
+#endif
+	BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_READ, length, total, start, file);
+	return total;
+}
+// Write 'length' bytes at 'offset' without using or moving the stream position. Returns the number of bytes written, or -1 on failure.
+// Note: This bypasses the stdio buffer. Call fflush() first if data was just written through the stream.
+i64 binary_file_platform_pwrite(const void* data, i64 length, file_size offset, binary_file file)
+{
+	BINARY_FILE_STATS_START(start);
+	i64 total = 0;
+#ifdef _WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+	while (total < length)
+	{
+		DWORD chunk = (length - total > 0x40000000) ? 0x40000000 : (DWORD)(length - total);
+		OVERLAPPED overlapped = { 0 };
+		overlapped.Offset = (DWORD)((offset + total) & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+		DWORD written = 0;
+		if (!WriteFile(handle, (const byte*)data + total, chunk, &written, &overlapped))
+		{
+			total = -1; // Failure
+			break;
+		}
+		total += written;
+	}
+#else
+	int descriptor = fileno(file);
+	while (total < length)
+	{
+		ssize_t written = pwrite(descriptor, (const byte*)data + total, (size_t)(length - total), (off_t)(offset + total));
+		if (written < 0)
+		{
+			total = -1; // Failure
+			break;
+		}
+		total += written;
+	}
+#endif
+	BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_WRITE, length, total, start, file);
+	return total;
+}
+// Read or write the segments at 'offset' with readv()/writev() calls of up to BINARY_FILE_SEGMENTS_BATCH segments. Returns the number of bytes done, or -1 on failure.
+// Note: Windows has no vectored I/O for buffered files, so there each segment is one pread()/pwrite().
+i64 binary_file_platform_transfer_segments(const binary_file_segment* segments, i64 count, file_size offset, bool writing, binary_file file)
+{
+	i64 total = 0;
+#ifdef _WIN32
+	for (i64 i = 0; i < count; i++)
+	{
+		i64 done = writing ? binary_file_platform_pwrite(segments[i].data, segments[i].length, offset + total, file)
+			: binary_file_platform_pread(segments[i].data, segments[i].length, offset + total, file);
+		if (done < 0)
+			return -1; // Failure
+		total += done;
+		if (done < segments[i].length)
+			break; // End of the file
+	}
+#else
+	BINARY_FILE_STATS_START(start);
+	int descriptor = fileno(file);
+	i64 index = 0;	// First segment not done yet
+	i64 skip = 0;	// Bytes of that segment already done
+	while (index < count)
+	{
+		struct iovec vectors[BINARY_FILE_SEGMENTS_BATCH];
+		int used = 0;
+		for (i64 i = index; i < count && used < BINARY_FILE_SEGMENTS_BATCH; i++, used++)
+		{
+			i64 done = (i == index) ? skip : 0;
+			vectors[used].iov_base = (byte*)segments[i].data + done;
+			vectors[used].iov_len = (size_t)(segments[i].length - done);
+		}
+
+		ssize_t done = writing ? pwritev(descriptor, vectors, used, (off_t)(offset + total))
+			: preadv(descriptor, vectors, used, (off_t)(offset + total));
+		if (done < 0)
+		{
+			total = -1; // Failure
+			break;
+		}
+		total += done;
+
+		// Step past the segments that are done
+		skip += done;
+		while (index < count && skip >= segments[index].length)
+		{
+			skip -= segments[index].length;
+			index++;
+		}
+		if (done == 0 && index < count)
+			break; // End of the file
+	}
+	BINARY_FILE_STATS_RECORD(writing ? BINARY_FILE_STATS_WRITE : BINARY_FILE_STATS_READ, binary_file_get_segments_length(segments, count), total, start, file);
+#endif
+	return total;
+}
+// Read up to the total length of the segments at 'offset' into the segments, in order, without using or moving the stream position.
+// Returns the number of bytes read (less at the end of the file), or -1 on failure.
+// Note: This bypasses the stdio buffer. Call fflush() first if data was just written through the stream.
+i64 binary_file_platform_preadv(const binary_file_segment* segments, i64 count, file_size offset, binary_file file)
+{
+	return binary_file_platform_transfer_segments(segments, count, offset, false, file);
+}
+// Write the segments, in order, at 'offset' without using or moving the stream position. Returns the number of bytes written, or -1 on failure.
+// Note: This bypasses the stdio buffer. Call fflush() first if data was just written through the stream.
+i64 binary_file_platform_pwritev(const binary_file_segment* segments, i64 count, file_size offset, binary_file file)
+{
+	return binary_file_platform_transfer_segments(segments, count, offset, true, file);
+}
+// Get the length of an open binary file from the file system (fstat). Returns -1 on failure.
+// Note: Data still in the stdio buffer is not counted. Call fflush() first if data was just written through the stream.
+file_size binary_file_platform_get_length(binary_file file)
+{
+#ifdef _WIN32
+	struct _stat64 status;
+	if (_fstat64(_fileno(file), &status) != 0)
+		return -1; // Failure
+#else
+	struct stat status;
+	if (fstat(fileno(file), &status) != 0)
+		return -1; // Failure
+#endif
+	return (file_size)status.st_size;
+}
+// Get the length of a binary file by name from the file system (stat) without opening it. Returns -1 if the binary file is not found.
+file_size binary_file_platform_get_length_path(str filename)
+{
+#ifdef _WIN32
+	struct _stat64 status;
+	if (_stat64((const char*)filename, &status) != 0)
+		return -1; // Failure
+#else
+	struct stat status;
+	if (stat((const char*)filename, &status) != 0)
+		return -1; // Failure
+#endif
+	return (file_size)status.st_size;
+}
+// Get the lengths of 'count' binary files from the file system in one call. 'directory' may be NULL, otherwise the names are relative to it and it is only resolved once.
+// Writes -1 for files that are not found. Returns the number of files found, or -1 if the directory can not be opened.
+i64 binary_file_platform_get_lengths(str directory, str* filenames, i64 count, file_size* lengths)
+{
+	i64 found = 0;
+#ifdef _WIN32
+	char path[MAX_PATH];
+	for (i64 i = 0; i < count; i++)
+	{
+		const char* name = (const char*)filenames[i];
+		if (directory != NULL)
+		{
+			int written = snprintf(path, sizeof(path), "%s\\%s", (const char*)directory, name);
+			if (written < 0 || written >= (int)sizeof(path))
+			{
+				lengths[i] = -1; // Path too long
+				continue;
+			}
+			name = path;
+		}
+
+		struct _stat64 status;
+		lengths[i] = (_stat64(name, &status) == 0) ? (file_size)status.st_size : -1;
+		if (lengths[i] >= 0)
+			found++;
+	}
+#else
+	int directory_descriptor = AT_FDCWD;
+	if (directory != NULL)
+	{
+		directory_descriptor = open((const char*)directory, O_RDONLY | O_DIRECTORY);
+		if (directory_descriptor < 0)
+			return -1; // The directory is not found
+	}
+
+	for (i64 i = 0; i < count; i++)
+	{
+		struct stat status;
+		lengths[i] = (fstatat(directory_descriptor, (const char*)filenames[i], &status, 0) == 0) ? (file_size)status.st_size : -1;
+		if (lengths[i] >= 0)
+			found++;
+	}
+
+	if (directory != NULL)
+		close(directory_descriptor);
+#endif
+	return found;
+}
+// Cut (or extend with zeros) an open binary file to 'length' bytes. Pending buffered writes are flushed first.
+bool binary_file_platform_truncate(file_size length, binary_file file)
+{
+	if (fflush(file) != 0)
+		return false; // Failure
+#ifdef _WIN32
+	return (_chsize_s(_fileno(file), length) == 0);
+#else
+	return (ftruncate(fileno(file), (off_t)length) == 0);
+#endif
+}
+// Write pending buffered data of a binary file and wait until the file data is on the storage device (fdatasync)
+bool binary_file_platform_sync(binary_file file)
+{
+	if (fflush(file) != 0)
+		return false; // Failure
+#ifdef _WIN32
+	return FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(file))) != 0;
+#elif defined(__APPLE__)
+	return (fsync(fileno(file)) == 0);
+#else
+	return (fdatasync(fileno(file)) == 0);
+#endif
+}
+// Get a monotonic time stamp in microseconds
+i64 binary_file_platform_get_time_us(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (i64)(counter.QuadPart / frequency.QuadPart * 1000000 + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (i64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+// Get a monotonic time stamp in nanoseconds
+i64 binary_file_platform_get_time_ns(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (i64)(counter.QuadPart / frequency.QuadPart * 1000000000 + counter.QuadPart % frequency.QuadPart * 1000000000 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (i64)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+// Map a binary file read-only into memory. Fills in 'data' and 'length' of 'map'. Returns false if the file does not exist or can not be mapped.
+bool binary_file_platform_map(str filename, binary_file_map* map)
+{
+#ifdef _WIN32
+	map->file_handle = CreateFileA((const char*)filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (map->file_handle == INVALID_HANDLE_VALUE)
+		return false; // The binary file is not found
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(map->file_handle, &length))
+	{
+		CloseHandle(map->file_handle);
+		return false; // Failure
+	}
+	map->length = length.QuadPart;
+
+	if (map->length > 0) // An empty file can not be mapped
+	{
+		map->mapping_handle = CreateFileMappingA(map->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (map->mapping_handle != NULL)
+			map->data = (byte*)MapViewOfFile(map->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		if (map->data == NULL)
+		{
+			if (map->mapping_handle != NULL)
+				CloseHandle(map->mapping_handle);
+			CloseHandle(map->file_handle);
+			return false; // Failure
+		}
+	}
+#else
+	int descriptor = open((const char*)filename, O_RDONLY);
+	if (descriptor < 0)
+		return false; // The binary file is not found
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0)
+	{
+		close(descriptor);
+		return false; // Failure
+	}
+	map->length = (file_size)status.st_size;
+
+	if (map->length > 0) // An empty file can not be mapped
+	{
+		void* data = mmap(NULL, (size_t)map->length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			close(descriptor);
+			return false; // Failure
+		}
+		map->data = (byte*)data;
+	}
+
+	close(descriptor); // The mapping stays valid after the descriptor is closed
+#endif
+	return true; // Success
+}
+// Unmap a binary file mapped with binary_file_platform_map(..)
+void binary_file_platform_unmap(binary_file_map* map)
+{
+#ifdef _WIN32
+	if (map->data != NULL)
+		UnmapViewOfFile(map->data);
+	if (map->mapping_handle != NULL)
+		CloseHandle(map->mapping_handle);
+	CloseHandle(map->file_handle);
+#else
+	if (map->data != NULL)
+		munmap(map->data, (size_t)map->length);
+#endif
+}
+
+// Get the number of logical processors. Returns 1 if it can not be found.
+i32 binary_file_platform_get_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? (i32)info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (i32)count : 1;
+#endif
+}
+// Start of a thread created by binary_file_platform_thread_start(..). Runs the task and frees it.
+#ifdef _WIN32
+DWORD WINAPI binary_file_platform_thread_entry(LPVOID parameter)
+#else
+void* binary_file_platform_thread_entry(void* parameter)
+#endif
+{
+	binary_file_task task = *(binary_file_task*)parameter;
+	free(parameter);
+
+	task.function(task.argument);
+
+#ifdef _WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+// Start a thread running 'function(argument)'. Returns false if the thread could not be created.
+bool binary_file_platform_thread_start(binary_file_thread* thread, binary_file_task_function function, void* argument)
+{
+	binary_file_task* task = (binary_file_task*)malloc(sizeof(binary_file_task));
+	if (task == NULL)
+		return false;
+	task->function = function;
+	task->argument = argument;
+
+#ifdef _WIN32
+	*thread = CreateThread(NULL, 0, binary_file_platform_thread_entry, task, 0, NULL);
+	if (*thread == NULL)
+	{
+		free(task);
+		return false; // Failure
+	}
+#else
+	if (pthread_create(thread, NULL, binary_file_platform_thread_entry, task) != 0)
+	{
+		free(task);
+		return false; // Failure
+	}
+#endif
+	return true; // Success
+}
+// Wait for a thread to finish
+void binary_file_platform_thread_join(binary_file_thread thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+// Initialize a mutex
+void binary_file_platform_mutex_init(binary_file_mutex* mutex)
+{
+#ifdef _WIN32
+	InitializeSRWLock(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif
+}
+// Destroy a mutex
+void binary_file_platform_mutex_destroy(binary_file_mutex* mutex)
+{
+#ifdef _WIN32
+	(void)mutex; // Slim reader/writer locks need no cleanup
+#else
+	pthread_mutex_destroy(mutex);
+#endif
+}
+// Lock a mutex
+void binary_file_platform_mutex_lock(binary_file_mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+// Unlock a mutex
+void binary_file_platform_mutex_unlock(binary_file_mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+// Initialize a condition variable
+void binary_file_platform_condition_init(binary_file_condition* condition)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(condition);
+#else
+	pthread_cond_init(condition, NULL);
+#endif
+}
+// Destroy a condition variable
+void binary_file_platform_condition_destroy(binary_file_condition* condition)
+{
+#ifdef _WIN32
+	(void)condition; // Condition variables need no cleanup
+#else
+	pthread_cond_destroy(condition);
+#endif
+}
+// Wait on a condition variable. 'mutex' must be locked and is locked again on return.
+void binary_file_platform_condition_wait(binary_file_condition* condition, binary_file_mutex* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+// Wait on a condition variable for at most 'microseconds'. 'mutex' must be locked and is locked again on return. Returns false on timeout.
+bool binary_file_platform_condition_wait_timeout(binary_file_condition* condition, binary_file_mutex* mutex, i64 microseconds)
+{
+#ifdef _WIN32
+	return SleepConditionVariableSRW(condition, mutex, (DWORD)((microseconds + 999) / 1000), 0) != 0;
+#else
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += microseconds / 1000000;
+	deadline.tv_nsec += (microseconds % 1000000) * 1000;
+	if (deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	return (pthread_cond_timedwait(condition, mutex, &deadline) == 0);
+#endif
+}
+// Wake one thread waiting on a condition variable
+void binary_file_platform_condition_signal(binary_file_condition* condition)
+{
+#ifdef _WIN32
+	WakeConditionVariable(condition);
+#else
+	pthread_cond_signal(condition);
+#endif
+}
+// Wake all threads waiting on a condition variable
+void binary_file_platform_condition_broadcast(binary_file_condition* condition)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
+// Atomically read a 64-bit value (sequentially consistent)
+u64 binary_file_platform_atomic_load_u64(volatile u64* value)
+{
+#ifdef _WIN32
+	return (u64)InterlockedCompareExchange64((volatile LONG64*)value, 0, 0);
+#else
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+// Atomically write a 64-bit value (sequentially consistent)
+void binary_file_platform_atomic_store_u64(u64 data, volatile u64* value)
+{
+#ifdef _WIN32
+	InterlockedExchange64((volatile LONG64*)value, (LONG64)data);
+#else
+	__atomic_store_n(value, data, __ATOMIC_SEQ_CST);
+#endif
+}
+// Atomically add to a 64-bit value
+void binary_file_platform_atomic_add_u64(u64 data, volatile u64* value)
+{
+#ifdef _WIN32
+	InterlockedExchangeAdd64((volatile LONG64*)value, (LONG64)data);
+#else
+	__atomic_fetch_add(value, data, __ATOMIC_SEQ_CST);
+#endif
+}
+// Atomically replace a 64-bit value with 'desired' if it still is 'expected'. Returns false if another thread changed it first.
+bool binary_file_platform_atomic_compare_exchange_u64(u64 expected, u64 desired, volatile u64* value)
+{
+#ifdef _WIN32
+	return (u64)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)desired, (LONG64)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+// Atomically read a 32-bit value (sequentially consistent)
+u32 binary_file_platform_atomic_load_u32(volatile u32* value)
+{
+#ifdef _WIN32
+	return (u32)InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+#else
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+// Atomically write a 32-bit value (sequentially consistent)
+void binary_file_platform_atomic_store_u32(u32 data, volatile u32* value)
+{
+#ifdef _WIN32
+	InterlockedExchange((volatile LONG*)value, (LONG)data);
+#else
+	__atomic_store_n(value, data, __ATOMIC_SEQ_CST);
+#endif
+}
+// Give the rest of this thread's time slice to another thread
+void binary_file_platform_yield(void)
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+// Allocate memory aligned to 'alignment' bytes (a power of two). Free it with binary_file_platform_aligned_free(..). Returns NULL if out of memory.
+void* binary_file_platform_aligned_alloc(i64 size, i64 alignment)
+{
+#ifdef _WIN32
+	return _aligned_malloc((size_t)size, (size_t)alignment);
+#else
+	void* memory = NULL;
+	if (posix_memalign(&memory, (size_t)alignment, (size_t)size) != 0)
+		return NULL; // Out of memory
+	return memory;
+#endif
+}
+// Free memory from binary_file_platform_aligned_alloc(..)
+void binary_file_platform_aligned_free(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+// Tell the operating system that a file is read from start to end, so it reads further ahead. Only a hint.
+void binary_file_platform_advise_sequential(binary_file file)
+{
+#if defined(__APPLE__)
+	fcntl(fileno(file), F_RDAHEAD, 1);
+#elif !defined(_WIN32)
+	posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+	(void)file; // Windows has no hint for an open file
+#endif
+}
+// Ask the operating system to start reading 'length' bytes at 'offset' into the page cache in the background. Only a hint.
+void binary_file_platform_prefetch(file_size offset, i64 length, binary_file file)
+{
+#if defined(__APPLE__)
+	struct radvisory advice;
+	advice.ra_offset = (off_t)offset;
+	advice.ra_count = (int)length;
+	fcntl(fileno(file), F_RDADVISE, &advice);
+#elif !defined(_WIN32)
+	posix_fadvise(fileno(file), (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+#else
+	(void)offset; // Windows has no hint for an open file
+	(void)length;
+	(void)file;
+#endif
+}
+// Open a binary file for I/O that bypasses the page cache (O_DIRECT, F_NOCACHE on Apple, FILE_FLAG_NO_BUFFERING on Windows). Writing truncates the file.
+// Sets 'direct' to false if the file system does not support it and the file was opened normally. Returns NULL if the file can not be opened.
+// Note: Only use positional reads and writes on it, with offsets, lengths and memory aligned to BINARY_FILE_DIRECT_ALIGNMENT.
+binary_file binary_file_platform_open_direct(str filename, bool writing, bool* direct)
+{
+	*direct = true;
+#ifdef _WIN32
+	HANDLE handle = CreateFileA((const char*)filename, writing ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL,
+		writing ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return NULL; // Failure
+	int descriptor = _open_osfhandle((intptr_t)handle, writing ? _O_RDWR : _O_RDONLY);
+	if (descriptor < 0)
+	{
+		CloseHandle(handle);
+		return NULL; // Failure
+	}
+	binary_file file = _fdopen(descriptor, writing ? "wb" : "rb");
+	if (file == NULL)
+		_close(descriptor);
+	return file;
+#else
+	int flags = writing ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+	int descriptor = -1;
+#ifdef O_DIRECT
+	descriptor = open((const char*)filename, flags | O_DIRECT, 0644);
+#endif
+	if (descriptor < 0)
+	{
+		*direct = false;
+		descriptor = open((const char*)filename, flags, 0644);
+		if (descriptor < 0)
+			return NULL; // Failure
+#ifdef __APPLE__
+		*direct = (fcntl(descriptor, F_NOCACHE, 1) != -1);
+#endif
+	}
+	binary_file file = fdopen(descriptor, writing ? "wb" : "rb");
+	if (file == NULL)
+		close(descriptor);
+	return file;
+#endif
+}
+// Copy up to 'length' bytes at 'input_offset' in one binary file to 'output_offset' in another inside the kernel (copy_file_range), without moving either position.
+// Returns the number of bytes copied. Less than 'length' (0 where the system can not do it, or between these files) means the rest must be copied another way.
+i64 binary_file_platform_copy_range(file_size input_offset, file_size output_offset, i64 length, binary_file input, binary_file output)
+{
+	i64 total = 0;
+#ifdef BINARY_FILE_COPY_RANGE
+	int input_descriptor = fileno(input);
+	int output_descriptor = fileno(output);
+	while (total < length)
+	{
+		loff_t from = (loff_t)(input_offset + total);
+		loff_t to = (loff_t)(output_offset + total);
+		size_t chunk = (length - total > 0x40000000) ? 0x40000000 : (size_t)(length - total);
+		ssize_t copied = copy_file_range(input_descriptor, &from, output_descriptor, &to, chunk, 0);
+		if (copied <= 0)
+			break; // Not supported between these files, or the end of the input
+		total += copied;
+	}
+#else
+	(void)input_offset; // Not supported
+	(void)output_offset;
+	(void)length;
+	(void)input;
+	(void)output;
+#endif
+	return total;
+}
+
+//
+// Implementations: Binary file
+//
+
+// Open a binary file for writing in truncate mode.
+binary_file binary_file_openfor_write_new(str filename)
+{
+	// Create a binary file. Truncate the file if it already exists.
+	binary_file file = fopen((const char*)filename, "wb");
+
+	return file;
+}
+// Open a binary file for writing in append mode.
+binary_file binary_file_openfor_write_append(str filename)
+{
 	// Open a binary file in append mode. Create if not exists.
 	binary_file file = fopen((const char*)filename, "ab");
 
-	return file;
+	return file;
+}
+// Open a binary file for reading in binary mode.
+binary_file binary_file_openfor_read(str filename)
+{
+	// Read a binary file in binary mode. Returns NULL if the file does not exist.
+	binary_file file = fopen((const char*)filename, "rb");
+
+	return file;
+}
+// Get the length of a binary file. Note: This function returns -1 if the binary file is not found
+file_size binary_file_get_length(str filename)
+{
+	return binary_file_platform_get_length_path(filename); // Asks the file system, the file is not opened
+}
+// Get the length of an already open binary file. Does not seek and does not change the current position. Returns -1 on failure.
+// Note: Data still in the stdio buffer of a file opened for writing is not counted until it is flushed.
+file_size binary_file_get_open_length(binary_file file)
+{
+	return binary_file_platform_get_length(file);
+}
+// Get the lengths of many binary files in one call, e.g. a whole directory before loading it. 'directory' may be NULL, otherwise 'filenames' are relative to it.
+// Note: 'lengths' gets -1 for each file that is not found. Returns the number of files found, or -1 if the directory is not found.
+i64 binary_file_get_lengths(str directory, str* filenames, i64 count, file_size* lengths)
+{
+	return binary_file_platform_get_lengths(directory, filenames, count, lengths);
+}
+// Write 'i8' data to a binary file
+bool binary_file_write_i8(i8 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(i8), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i16' data to a binary file
+bool binary_file_write_i16(i16 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(i16), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i32' data to a binary file
+bool binary_file_write_i32(i32 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(i32), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i64' data to a binary file
+bool binary_file_write_i64(i64 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(i64), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u8' data to a binary file
+bool binary_file_write_u8(u8 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(u8), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u16' data to a binary file
+bool binary_file_write_u16(u16 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(u16), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u32' data to a binary file
+bool binary_file_write_u32(u32 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(u32), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u64' data to a binary file
+bool binary_file_write_u64(u64 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(u64), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'f32' data to a binary file
+bool binary_file_write_f32(f32 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(f32), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'f64' data to a binary file
+bool binary_file_write_f64(f64 data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(f64), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'bool' data to a binary file. Note this writes 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_write_bool(bool data, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(&data, sizeof(bool), 1, file) != 1)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'byte'(s) data to a binary file
+bool binary_file_write_byte(byte* data, i64 length, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(data, sizeof(byte), length, file) != (size_t)length)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'str' data to a binary file
+bool binary_file_write_str(str text, binary_file file)
+{
+	// Write the text and its null terminator in one go
+	size_t length = strlen((const char*)text) + 1;
+	if (BINARY_FILE_FWRITE(text, sizeof(c8), length, file) != length)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'elements'(s) data to a binary file (as typical fwrite())
+bool binary_file_write_elements(void* data, i64 size, i64 count, binary_file file)
+{
+	if (BINARY_FILE_FWRITE(data, size, count, file) != (size_t)count)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Read 'i8' data from a binary file
+bool binary_file_read_i8(i8* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(i8), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i16' data from a binary file
+bool binary_file_read_i16(i16* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(i16), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i32' data from a binary file
+bool binary_file_read_i32(i32* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(i32), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i64' data from a binary file
+bool binary_file_read_i64(i64* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(i64), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u8' data from a binary file
+bool binary_file_read_u8(u8* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(u8), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u16' data from a binary file
+bool binary_file_read_u16(u16* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(u16), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u32' data from a binary file
+bool binary_file_read_u32(u32* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(u32), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u64' data from a binary file
+bool binary_file_read_u64(u64* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(u64), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'f32' data from a binary file
+bool binary_file_read_f32(f32* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(f32), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'f64' data from a binary file
+bool binary_file_read_f64(f64* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(f64), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'bool' data from a binary file. Note this reads 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_read_bool(bool* data, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(bool), 1, file) != 1)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'byte'(s) data from a binary file
+bool binary_file_read_byte(byte* data, i64 length, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, sizeof(byte), length, file) != (size_t)length)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'str' data from a binary file. We need to use 'in_temp' in order to resize the allocated memory then return the string.
+// Note: 'in_temp' is required to use malloc() on the user side before using this function. It is freed if the read fails.
+// Note: The file is scanned forward in growing chunks, so the cost is only the length of the string (not the rest of the file).
+str binary_file_read_str(binary_file file, str in_temp)
+{
+	// Store file position
+	i64 file_position = binary_file_platform_tell(file);
+	if (file_position < 0)
+	{
+		free(in_temp);
+		return NULL; // Failure
+	}
+
+	i64 capacity = 0;
+	i64 length = 0;
+	while (true)
+	{
+		// Grow the string so the next chunk fits
+		if (length == capacity)
+		{
+			capacity = (capacity == 0) ? BINARY_FILE_STR_CHUNK_SIZE : capacity * 2;
+			str temp = (str)realloc(in_temp, capacity * sizeof(c8));
+			if (temp == NULL)
+			{
+				free(in_temp);
+				binary_file_platform_seek(file_position, SEEK_SET, file);
+				return NULL;
+			}
+			in_temp = temp;
+		}
+
+		// Read the next chunk straight into the string
+		i64 read = (i64)BINARY_FILE_FREAD(in_temp + length, sizeof(c8), capacity - length, file);
+		if (read == 0)
+			break; // Reached the end of the file without finding '\0'
+
+		// Search for the first '\0' in the chunk
+		i64 terminator = binary_file_find_zero(in_temp + length, read);
+		if (terminator < 0)
+		{
+			length += read;
+			continue;
+		}
+		length += terminator;
+
+		// Step back to just after the null terminator (the rest of the chunk is still in the stdio buffer)
+		if (!binary_file_platform_seek(file_position + length + 1, SEEK_SET, file))
+			break; // Failure
+
+		// Shrink the string to fit. Keep the larger block if shrinking fails.
+		str temp = (str)realloc(in_temp, (length + 1) * sizeof(c8));
+		if (temp != NULL)
+			in_temp = temp;
+
+		return in_temp;
+	}
+
+	// Did not find '\0'. Restore file position.
+	free(in_temp);
+	binary_file_platform_seek(file_position, SEEK_SET, file);
+	return NULL;
+}
+// Read 'str' data from a binary file into 'buffer' that can hold 'capacity' bytes (including the null terminator).
+// Returns the length of the string, or -1 if no '\0' was found or the string does not fit. The file position is restored on failure.
+// Note: Use this to reuse one allocation when reading many strings, e.g. a whole string table.
+i64 binary_file_read_str_into(str buffer, i64 capacity, binary_file file)
+{
+	// Store file position
+	i64 file_position = binary_file_platform_tell(file);
+	if (file_position < 0)
+		return -1; // Failure
+
+	i64 length = 0;
+	while (length < capacity)
+	{
+		// Read the next chunk straight into the buffer
+		i64 chunk = capacity - length;
+		if (chunk > BINARY_FILE_STR_CHUNK_SIZE)
+			chunk = BINARY_FILE_STR_CHUNK_SIZE;
+		i64 read = (i64)BINARY_FILE_FREAD(buffer + length, sizeof(c8), chunk, file);
+		if (read == 0)
+			break; // Reached the end of the file without finding '\0'
+
+		// Search for the first '\0' in the chunk
+		i64 terminator = binary_file_find_zero(buffer + length, read);
+		if (terminator < 0)
+		{
+			length += read;
+			continue;
+		}
+		length += terminator;
+
+		// Step back to just after the null terminator
+		if (!binary_file_platform_seek(file_position + length + 1, SEEK_SET, file))
+			break; // Failure
+
+		return length;
+	}
+
+	// Did not find '\0', the string is too long for the buffer or the seek failed. Restore file position.
+	binary_file_platform_seek(file_position, SEEK_SET, file);
+	return -1;
+}
+// Read 'elements'(s) data from a binary file
+bool binary_file_read_elements(void* data, i64 size, i64 count, binary_file file)
+{
+	if (BINARY_FILE_FREAD(data, size, count, file) != (size_t)count)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Seek to the beginning of a binary file
+bool binary_file_set_position_begin(binary_file file)
+{
+	return BINARY_FILE_SEEK(0, SEEK_SET, file); // Returns true if the seek was successful
+}
+// Seek to an absolute position in a binary file
+bool binary_file_set_position(file_size position, binary_file file)
+{
+	return BINARY_FILE_SEEK(position, SEEK_SET, file); // Returns true if the seek was successful
+}
+// Seek to a relative position in a binary file
+bool binary_file_set_position_relative(file_size position, binary_file file)
+{
+	return BINARY_FILE_SEEK(position, SEEK_CUR, file); // Returns true if the seek was successful
+}
+// Seek to the end of a binary file
+bool binary_file_set_position_end(binary_file file)
+{
+	return BINARY_FILE_SEEK(0, SEEK_END, file); // Returns true if the seek was successful
+}
+// Get the current position in a binary file
+file_size binary_file_get_position(binary_file file)
+{
+	return binary_file_platform_tell(file);
+}
+// Get the number of bytes from the current position to the end of a binary file. Returns -1 if it can not be found.
+i64 binary_file_get_remaining(binary_file file)
+{
+	file_size position = binary_file_platform_tell(file);
+	if (position < 0)
+		return -1; // Failure
+
+	file_size length = binary_file_platform_get_length(file);
+	if (length < 0)
+	{
+		// A custom stream (compressed, direct) has no file descriptor: seek to the end and back
+		if (!binary_file_platform_seek(0, SEEK_END, file))
+			return -1; // Failure
+		length = binary_file_platform_tell(file);
+		if (!binary_file_platform_seek(position, SEEK_SET, file) || length < 0)
+			return -1; // Failure
+	}
+
+	return (length > position) ? (i64)(length - position) : 0;
+}
+// Close a binary file
+void binary_file_close(binary_file file)
+{
+	BINARY_FILE_FCLOSE(file);
+}
+// Close a binary file. Returns false if the data still buffered (or, for a compressed or direct stream, its last block) could not be written.
+bool binary_file_close_checked(binary_file file)
+{
+	return (BINARY_FILE_FCLOSE(file) == 0);
+}
+
+//
+// Implementations: Positional binary file
+//
+// Note: These use pread()/pwrite() on POSIX, so several threads can read and write different offsets of one open binary file without a lock.
+//       They bypass the stdio buffer: call fflush() after writing through the stream before reading the same bytes back with these.
+//       On Windows the OS file pointer of the handle is moved, so do not mix these with the stream functions on the same binary file there.
+//
+
+// Write 'i8' data to a binary file at 'offset'
+bool binary_file_write_i8_at(i8 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(i8), offset, file) != sizeof(i8))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i16' data to a binary file at 'offset'
+bool binary_file_write_i16_at(i16 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(i16), offset, file) != sizeof(i16))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i32' data to a binary file at 'offset'
+bool binary_file_write_i32_at(i32 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(i32), offset, file) != sizeof(i32))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'i64' data to a binary file at 'offset'
+bool binary_file_write_i64_at(i64 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(i64), offset, file) != sizeof(i64))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u8' data to a binary file at 'offset'
+bool binary_file_write_u8_at(u8 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(u8), offset, file) != sizeof(u8))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u16' data to a binary file at 'offset'
+bool binary_file_write_u16_at(u16 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(u16), offset, file) != sizeof(u16))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u32' data to a binary file at 'offset'
+bool binary_file_write_u32_at(u32 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(u32), offset, file) != sizeof(u32))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'u64' data to a binary file at 'offset'
+bool binary_file_write_u64_at(u64 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(u64), offset, file) != sizeof(u64))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'f32' data to a binary file at 'offset'
+bool binary_file_write_f32_at(f32 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(f32), offset, file) != sizeof(f32))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'f64' data to a binary file at 'offset'
+bool binary_file_write_f64_at(f64 data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(f64), offset, file) != sizeof(f64))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'bool' data to a binary file at 'offset'. Note this writes 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_write_bool_at(bool data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(&data, sizeof(bool), offset, file) != sizeof(bool))
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'byte'(s) data to a binary file at 'offset'
+bool binary_file_write_byte_at(byte* data, i64 length, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(data, length, offset, file) != length)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Write 'elements'(s) data to a binary file at 'offset'
+bool binary_file_write_elements_at(void* data, i64 size, i64 count, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pwrite(data, size * count, offset, file) != size * count)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Read 'i8' data from a binary file at 'offset'
+bool binary_file_read_i8_at(i8* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(i8), offset, file) != sizeof(i8))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i16' data from a binary file at 'offset'
+bool binary_file_read_i16_at(i16* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(i16), offset, file) != sizeof(i16))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i32' data from a binary file at 'offset'
+bool binary_file_read_i32_at(i32* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(i32), offset, file) != sizeof(i32))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'i64' data from a binary file at 'offset'
+bool binary_file_read_i64_at(i64* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(i64), offset, file) != sizeof(i64))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u8' data from a binary file at 'offset'
+bool binary_file_read_u8_at(u8* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(u8), offset, file) != sizeof(u8))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u16' data from a binary file at 'offset'
+bool binary_file_read_u16_at(u16* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(u16), offset, file) != sizeof(u16))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u32' data from a binary file at 'offset'
+bool binary_file_read_u32_at(u32* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(u32), offset, file) != sizeof(u32))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'u64' data from a binary file at 'offset'
+bool binary_file_read_u64_at(u64* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(u64), offset, file) != sizeof(u64))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'f32' data from a binary file at 'offset'
+bool binary_file_read_f32_at(f32* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(f32), offset, file) != sizeof(f32))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'f64' data from a binary file at 'offset'
+bool binary_file_read_f64_at(f64* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(f64), offset, file) != sizeof(f64))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'bool' data from a binary file at 'offset'. Note this reads 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_read_bool_at(bool* data, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, sizeof(bool), offset, file) != sizeof(bool))
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'byte'(s) data from a binary file at 'offset'
+bool binary_file_read_byte_at(byte* data, i64 length, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, length, offset, file) != length)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+// Read 'elements'(s) data from a binary file at 'offset'
+bool binary_file_read_elements_at(void* data, i64 size, i64 count, file_size offset, binary_file file)
+{
+	if (binary_file_platform_pread(data, size * count, offset, file) != size * count)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+
+//
+// Implementations: Scatter/gather
+//
+// Note: A segment is a pointer and a length. The segments of one call are laid out one after the other in the binary file,
+//       so a record made of a header, a string and an array is written or read with one call and no staging copy.
+//       Small records (less than BINARY_FILE_SEGMENTS_VECTOR_SIZE) are copied into the stdio buffer, which costs no system call
+//       until the buffer is full. Larger ones flush the stream and go to the file with one writev()/readv() at the stream position,
+//       except on the compressed and direct streams, which have no file descriptor and always take the stdio path.
+//       The '_at' versions always use pwritev()/preadv() and have the same rules as the positional functions.
+//
+
+// Get the total length of the segments. Returns -1 if a length is negative or the total does not fit in 'i64'.
+i64 binary_file_get_segments_length(const binary_file_segment* segments, i64 count)
+{
+	i64 total = 0;
+	for (i64 i = 0; i < count; i++)
+	{
+		if (segments[i].length < 0 || segments[i].length > INT64_MAX - total)
+			return -1; // Failure
+		total += segments[i].length;
+	}
+	return total;
+}
+// Write or read the segments at the stream position and move it past them. Returns true if all of them were done.
+bool binary_file_transfer_segments(const binary_file_segment* segments, i64 count, bool writing, binary_file file)
+{
+	i64 total = binary_file_get_segments_length(segments, count);
+	if (total < 0 || count < 0)
+		return false; // Failure
+
+	// Small, or a custom stream (compressed, direct) that has no file descriptor: through the stdio buffer
+	bool buffered = (total < BINARY_FILE_SEGMENTS_VECTOR_SIZE);
+#ifdef BINARY_FILE_STREAM_COOKIE
+	buffered = buffered || (fileno(file) < 0);
+#endif
+	if (buffered)
+	{
+		for (i64 i = 0; i < count; i++)
+		{
+			if (segments[i].length == 0)
+				continue;
+			size_t done = writing ? BINARY_FILE_FWRITE(segments[i].data, 1, (size_t)segments[i].length, file)
+				: BINARY_FILE_FREAD(segments[i].data, 1, (size_t)segments[i].length, file);
+			if (done != (size_t)segments[i].length)
+				return false; // Something went wrong while trying to read or write the data
+		}
+		return true; // Success
+	}
+
+	// Large: one vectored call at the stream position, then step the stream past it
+	file_size position = binary_file_platform_tell(file);
+	if (position < 0 || fflush(file) != 0)
+		return false; // Failure
+
+	i64 done = writing ? binary_file_platform_pwritev(segments, count, position, file) : binary_file_platform_preadv(segments, count, position, file);
+	if (done != total)
+	{
+		binary_file_platform_seek(position, SEEK_SET, file);
+		return false; // Something went wrong while trying to read or write the data
+	}
+
+	return binary_file_platform_seek(position + total, SEEK_SET, file);
+}
+// Write the segments to a binary file, one after the other
+bool binary_file_write_segments(const binary_file_segment* segments, i64 count, binary_file file)
+{
+	return binary_file_transfer_segments(segments, count, true, file);
+}
+// Read one contiguous part of a binary file into the segments, filling them in order
+bool binary_file_read_segments(const binary_file_segment* segments, i64 count, binary_file file)
+{
+	return binary_file_transfer_segments(segments, count, false, file);
+}
+// Write the segments to a binary file at 'offset', one after the other
+bool binary_file_write_segments_at(const binary_file_segment* segments, i64 count, file_size offset, binary_file file)
+{
+	i64 total = binary_file_get_segments_length(segments, count);
+	if (total < 0 || binary_file_platform_pwritev(segments, count, offset, file) != total)
+		return false; // Something went wrong while trying to write the data
+
+	return true; // Success
+}
+// Read the contiguous part of a binary file at 'offset' into the segments, filling them in order
+bool binary_file_read_segments_at(const binary_file_segment* segments, i64 count, file_size offset, binary_file file)
+{
+	i64 total = binary_file_get_segments_length(segments, count);
+	if (total < 0 || binary_file_platform_preadv(segments, count, offset, file) != total)
+		return false; // Something went wrong while trying to read the data
+
+	return true; // Success
+}
+
+//
+// Implementations: Byte order
+//
+
+#ifdef BINARY_FILE_LITTLE_ENDIAN
+#define binary_file_to_le_u16(data) (data)
+#define binary_file_to_le_u32(data) (data)
+#define binary_file_to_le_u64(data) (data)
+#define binary_file_to_be_u16(data) binary_file_swap_u16(data)
+#define binary_file_to_be_u32(data) binary_file_swap_u32(data)
+#define binary_file_to_be_u64(data) binary_file_swap_u64(data)
+#else
+#define binary_file_to_le_u16(data) binary_file_swap_u16(data)
+#define binary_file_to_le_u32(data) binary_file_swap_u32(data)
+#define binary_file_to_le_u64(data) binary_file_swap_u64(data)
+#define binary_file_to_be_u16(data) (data)
+#define binary_file_to_be_u32(data) (data)
+#define binary_file_to_be_u64(data) (data)
+#endif
+
+// Reverse the byte order of a 16-bit value
+u16 binary_file_swap_u16(u16 data)
+{
+#ifdef _MSC_VER
+	return _byteswap_ushort(data);
+#else
+	return __builtin_bswap16(data);
+#endif
+}
+// Reverse the byte order of a 32-bit value
+u32 binary_file_swap_u32(u32 data)
+{
+#ifdef _MSC_VER
+	return _byteswap_ulong(data);
+#else
+	return __builtin_bswap32(data);
+#endif
+}
+// Reverse the byte order of a 64-bit value
+u64 binary_file_swap_u64(u64 data)
+{
+#ifdef _MSC_VER
+	return _byteswap_uint64(data);
+#else
+	return __builtin_bswap64(data);
+#endif
+}
+// Reverse the byte order of 'count' elements of 'size' bytes from 'source' into 'destination'. They may be the same buffer.
+// Note: Sizes 2, 4 and 8 use 32 bytes per step with AVX2 or 16 bytes per step with SSSE3 when the compiler targets them.
+void binary_file_swap_elements(void* destination, const void* source, i64 size, i64 count)
+{
+	byte* to = (byte*)destination;
+	const byte* from = (const byte*)source;
+	i64 length = size * count;
+	i64 i = 0;
+
+	if (size == 1)
+	{
+		if (to != from)
+			memmove(to, from, length);
+		return; // Single bytes have no byte order
+	}
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+	if (size == 2 || size == 4 || size == 8)
+	{
+		__m128i order;
+		if (size == 2)
+			order = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		else if (size == 4)
+			order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+		else
+			order = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+#if defined(__AVX2__)
+		__m256i order_wide = _mm256_broadcastsi128_si256(order);
+		for (; i + 32 <= length; i += 32)
+			_mm256_storeu_si256((__m256i*)(to + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(from + i)), order_wide));
+#endif
+		for (; i + 16 <= length; i += 16)
+			_mm_storeu_si128((__m128i*)(to + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(from + i)), order));
+	}
+#endif
+
+	// Remaining elements one by one
+	for (; i < length; i += size)
+	{
+		if (size == 2)
+		{
+			u16 data;
+			memcpy(&data, from + i, sizeof(data));
+			data = binary_file_swap_u16(data);
+			memcpy(to + i, &data, sizeof(data));
+		}
+		else if (size == 4)
+		{
+			u32 data;
+			memcpy(&data, from + i, sizeof(data));
+			data = binary_file_swap_u32(data);
+			memcpy(to + i, &data, sizeof(data));
+		}
+		else if (size == 8)
+		{
+			u64 data;
+			memcpy(&data, from + i, sizeof(data));
+			data = binary_file_swap_u64(data);
+			memcpy(to + i, &data, sizeof(data));
+		}
+		else
+		{
+			for (i64 j = 0; j < size / 2; j++) // Other sizes byte by byte (works in place)
+			{
+				byte first = from[i + j];
+				byte last = from[i + size - 1 - j];
+				to[i + j] = last;
+				to[i + size - 1 - j] = first;
+			}
+			if (size % 2 != 0)
+				to[i + size / 2] = from[i + size / 2];
+		}
+	}
+}
+// Write 'elements'(s) data to a binary file with the byte order reversed. The elements are swapped in blocks through a small buffer, 'data' is not changed.
+bool binary_file_write_elements_swapped(void* data, i64 size, i64 count, binary_file file)
+{
+	byte buffer[4096];
+	if (size > (i64)sizeof(buffer))
+	{
+		// Elements larger than the buffer: write each one from its last byte to its first, one buffer at a time
+		for (i64 i = 0; i < count; i++)
+		{
+			const byte* element = (const byte*)data + i * size;
+			for (i64 done = 0; done < size; done += sizeof(buffer))
+			{
+				i64 length = (size - done < (i64)sizeof(buffer)) ? size - done : (i64)sizeof(buffer);
+				for (i64 j = 0; j < length; j++)
+					buffer[j] = element[size - 1 - done - j];
+				if (!binary_file_write_byte(buffer, length, file))
+					return false; // Something went wrong while trying to write the data
+			}
+		}
+		return true; // Success
+	}
+
+	i64 block = sizeof(buffer) / size;
+	for (i64 i = 0; i < count; i += block)
+	{
+		i64 elements = (count - i < block) ? count - i : block;
+		binary_file_swap_elements(buffer, (const byte*)data + i * size, size, elements);
+		if (!binary_file_write_elements(buffer, size, elements, file))
+			return false; // Something went wrong while trying to write the data
+	}
+
+	return true; // Success
+}
+// Write 'i16' data to a binary file in little-endian byte order
+bool binary_file_write_i16_le(i16 data, binary_file file)
+{
+	u16 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u16(binary_file_to_le_u16(bits), file);
+}
+// Write 'i32' data to a binary file in little-endian byte order
+bool binary_file_write_i32_le(i32 data, binary_file file)
+{
+	u32 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u32(binary_file_to_le_u32(bits), file);
+}
+// Write 'i64' data to a binary file in little-endian byte order
+bool binary_file_write_i64_le(i64 data, binary_file file)
+{
+	u64 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u64(binary_file_to_le_u64(bits), file);
+}
+// Write 'u16' data to a binary file in little-endian byte order
+bool binary_file_write_u16_le(u16 data, binary_file file)
+{
+	return binary_file_write_u16(binary_file_to_le_u16(data), file);
+}
+// Write 'u32' data to a binary file in little-endian byte order
+bool binary_file_write_u32_le(u32 data, binary_file file)
+{
+	return binary_file_write_u32(binary_file_to_le_u32(data), file);
+}
+// Write 'u64' data to a binary file in little-endian byte order
+bool binary_file_write_u64_le(u64 data, binary_file file)
+{
+	return binary_file_write_u64(binary_file_to_le_u64(data), file);
+}
+// Write 'f32' data to a binary file in little-endian byte order
+bool binary_file_write_f32_le(f32 data, binary_file file)
+{
+	u32 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u32(binary_file_to_le_u32(bits), file);
+}
+// Write 'f64' data to a binary file in little-endian byte order
+bool binary_file_write_f64_le(f64 data, binary_file file)
+{
+	u64 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u64(binary_file_to_le_u64(bits), file);
+}
+// Write 'elements'(s) data to a binary file in little-endian byte order
+bool binary_file_write_elements_le(void* data, i64 size, i64 count, binary_file file)
+{
+#ifdef BINARY_FILE_LITTLE_ENDIAN
+	return binary_file_write_elements(data, size, count, file); // Already in the host byte order
+#else
+	return binary_file_write_elements_swapped(data, size, count, file);
+#endif
+}
+// Write 'i16' data to a binary file in big-endian byte order
+bool binary_file_write_i16_be(i16 data, binary_file file)
+{
+	u16 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u16(binary_file_to_be_u16(bits), file);
+}
+// Write 'i32' data to a binary file in big-endian byte order
+bool binary_file_write_i32_be(i32 data, binary_file file)
+{
+	u32 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u32(binary_file_to_be_u32(bits), file);
+}
+// Write 'i64' data to a binary file in big-endian byte order
+bool binary_file_write_i64_be(i64 data, binary_file file)
+{
+	u64 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u64(binary_file_to_be_u64(bits), file);
+}
+// Write 'u16' data to a binary file in big-endian byte order
+bool binary_file_write_u16_be(u16 data, binary_file file)
+{
+	return binary_file_write_u16(binary_file_to_be_u16(data), file);
+}
+// Write 'u32' data to a binary file in big-endian byte order
+bool binary_file_write_u32_be(u32 data, binary_file file)
+{
+	return binary_file_write_u32(binary_file_to_be_u32(data), file);
+}
+// Write 'u64' data to a binary file in big-endian byte order
+bool binary_file_write_u64_be(u64 data, binary_file file)
+{
+	return binary_file_write_u64(binary_file_to_be_u64(data), file);
+}
+// Write 'f32' data to a binary file in big-endian byte order
+bool binary_file_write_f32_be(f32 data, binary_file file)
+{
+	u32 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u32(binary_file_to_be_u32(bits), file);
+}
+// Write 'f64' data to a binary file in big-endian byte order
+bool binary_file_write_f64_be(f64 data, binary_file file)
+{
+	u64 bits;
+	memcpy(&bits, &data, sizeof(bits));
+	return binary_file_write_u64(binary_file_to_be_u64(bits), file);
+}
+// Write 'elements'(s) data to a binary file in big-endian byte order
+bool binary_file_write_elements_be(void* data, i64 size, i64 count, binary_file file)
+{
+#ifndef BINARY_FILE_LITTLE_ENDIAN
+	return binary_file_write_elements(data, size, count, file); // Already in the host byte order
+#else
+	return binary_file_write_elements_swapped(data, size, count, file);
+#endif
+}
+// Read 'i16' data from a binary file in little-endian byte order
+bool binary_file_read_i16_le(i16* data, binary_file file)
+{
+	u16 bits;
+	if (!binary_file_read_u16(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_le_u16(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'i32' data from a binary file in little-endian byte order
+bool binary_file_read_i32_le(i32* data, binary_file file)
+{
+	u32 bits;
+	if (!binary_file_read_u32(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_le_u32(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'i64' data from a binary file in little-endian byte order
+bool binary_file_read_i64_le(i64* data, binary_file file)
+{
+	u64 bits;
+	if (!binary_file_read_u64(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_le_u64(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'u16' data from a binary file in little-endian byte order
+bool binary_file_read_u16_le(u16* data, binary_file file)
+{
+	if (!binary_file_read_u16(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_le_u16(*data);
+	return true; // Success
+}
+// Read 'u32' data from a binary file in little-endian byte order
+bool binary_file_read_u32_le(u32* data, binary_file file)
+{
+	if (!binary_file_read_u32(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_le_u32(*data);
+	return true; // Success
+}
+// Read 'u64' data from a binary file in little-endian byte order
+bool binary_file_read_u64_le(u64* data, binary_file file)
+{
+	if (!binary_file_read_u64(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_le_u64(*data);
+	return true; // Success
+}
+// Read 'f32' data from a binary file in little-endian byte order
+bool binary_file_read_f32_le(f32* data, binary_file file)
+{
+	u32 bits;
+	if (!binary_file_read_u32(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_le_u32(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'f64' data from a binary file in little-endian byte order
+bool binary_file_read_f64_le(f64* data, binary_file file)
+{
+	u64 bits;
+	if (!binary_file_read_u64(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_le_u64(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'elements'(s) data from a binary file in little-endian byte order. The whole array is swapped in one pass after reading.
+bool binary_file_read_elements_le(void* data, i64 size, i64 count, binary_file file)
+{
+	if (!binary_file_read_elements(data, size, count, file))
+		return false; // Something went wrong while trying to read the data
+
+#ifndef BINARY_FILE_LITTLE_ENDIAN
+	binary_file_swap_elements(data, data, size, count);
+#endif
+	return true; // Success
+}
+// Read 'i16' data from a binary file in big-endian byte order
+bool binary_file_read_i16_be(i16* data, binary_file file)
+{
+	u16 bits;
+	if (!binary_file_read_u16(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_be_u16(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'i32' data from a binary file in big-endian byte order
+bool binary_file_read_i32_be(i32* data, binary_file file)
+{
+	u32 bits;
+	if (!binary_file_read_u32(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_be_u32(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'i64' data from a binary file in big-endian byte order
+bool binary_file_read_i64_be(i64* data, binary_file file)
+{
+	u64 bits;
+	if (!binary_file_read_u64(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_be_u64(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'u16' data from a binary file in big-endian byte order
+bool binary_file_read_u16_be(u16* data, binary_file file)
+{
+	if (!binary_file_read_u16(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_be_u16(*data);
+	return true; // Success
+}
+// Read 'u32' data from a binary file in big-endian byte order
+bool binary_file_read_u32_be(u32* data, binary_file file)
+{
+	if (!binary_file_read_u32(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_be_u32(*data);
+	return true; // Success
+}
+// Read 'u64' data from a binary file in big-endian byte order
+bool binary_file_read_u64_be(u64* data, binary_file file)
+{
+	if (!binary_file_read_u64(data, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_to_be_u64(*data);
+	return true; // Success
+}
+// Read 'f32' data from a binary file in big-endian byte order
+bool binary_file_read_f32_be(f32* data, binary_file file)
+{
+	u32 bits;
+	if (!binary_file_read_u32(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_be_u32(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'f64' data from a binary file in big-endian byte order
+bool binary_file_read_f64_be(f64* data, binary_file file)
+{
+	u64 bits;
+	if (!binary_file_read_u64(&bits, file))
+		return false; // Something went wrong while trying to read the data
+
+	bits = binary_file_to_be_u64(bits);
+	memcpy(data, &bits, sizeof(bits));
+	return true; // Success
+}
+// Read 'elements'(s) data from a binary file in big-endian byte order. The whole array is swapped in one pass after reading.
+bool binary_file_read_elements_be(void* data, i64 size, i64 count, binary_file file)
+{
+	if (!binary_file_read_elements(data, size, count, file))
+		return false; // Something went wrong while trying to read the data
+
+#ifdef BINARY_FILE_LITTLE_ENDIAN
+	binary_file_swap_elements(data, data, size, count);
+#endif
+	return true; // Success
+}
+
+//
+// Implementations: String scanning and string tables
+//
+
+// Get the index of the lowest set bit in a non-zero mask
+i32 binary_file_lowest_bit(u32 mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (i32)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+// Find the first '\0' in 'data'. Returns its index, or -1 if there is none.
+// Note: Checks 32 bytes per step with AVX2 or 16 bytes per step with SSE2, otherwise one byte at a time.
+i64 binary_file_find_zero(const byte* data, i64 length)
+{
+	i64 i = 0;
+#if defined(__AVX2__)
+	const __m256i zero_wide = _mm256_setzero_si256();
+	for (; i + 32 <= length; i += 32)
+	{
+		u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), zero_wide));
+		if (mask != 0)
+			return i + binary_file_lowest_bit(mask);
+	}
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16)
+	{
+		u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), zero));
+		if (mask != 0)
+			return i + binary_file_lowest_bit(mask);
+	}
+#endif
+	for (; i < length; i++)
+	{
+		if (data[i] == '\0')
+			return i;
+	}
+
+	return -1; // Did not find '\0'
+}
+// Find every '\0' in 'data' and store their indexes in 'positions' (may be NULL to only count them). Returns the number found.
+// Note: Checks 32 bytes per step with AVX2 or 16 bytes per step with SSE2, otherwise one byte at a time.
+i64 binary_file_find_zeros(const byte* data, i64 length, i64* positions)
+{
+	i64 count = 0;
+	i64 i = 0;
+#if defined(__AVX2__)
+	const __m256i zero_wide = _mm256_setzero_si256();
+	for (; i + 32 <= length; i += 32)
+	{
+		u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), zero_wide));
+		for (; mask != 0; mask &= mask - 1) // Visit each set bit
+		{
+			if (positions != NULL)
+				positions[count] = i + binary_file_lowest_bit(mask);
+			count++;
+		}
+	}
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16)
+	{
+		u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), zero));
+		for (; mask != 0; mask &= mask - 1) // Visit each set bit
+		{
+			if (positions != NULL)
+				positions[count] = i + binary_file_lowest_bit(mask);
+			count++;
+		}
+	}
+#endif
+	for (; i < length; i++)
+	{
+		if (data[i] == '\0')
+		{
+			if (positions != NULL)
+				positions[count] = i;
+			count++;
+		}
+	}
+
+	return count;
+}
+// Read a block of up to 'length' bytes and split it into all the null terminated strings it contains. One allocation holds all the strings.
+// A string cut off at the end of the block is left in the file for the next call. Returns NULL if no complete string was found or on failure (the file position is restored).
+binary_file_str_table* binary_file_read_str_table(i64 length, binary_file file)
+{
+	if (length <= 0)
+		return NULL; // Nothing to read
+
+	file_size file_position = binary_file_platform_tell(file);
+	if (file_position < 0)
+		return NULL; // Failure
+
+	binary_file_str_table* table = (binary_file_str_table*)calloc(1, sizeof(binary_file_str_table));
+	if (table == NULL)
+		return NULL;
+	table->data = (byte*)malloc(length);
+	if (table->data == NULL)
+	{
+		free(table);
+		return NULL;
+	}
+
+	// Read the whole block
+	i64 read = (i64)BINARY_FILE_FREAD(table->data, sizeof(byte), length, file);
+
+	// Count the strings, then find them
+	i64 count = binary_file_find_zeros(table->data, read, NULL);
+	if (count > 0)
+		table->offsets = (i64*)malloc(count * sizeof(i64));
+	if (table->offsets == NULL)
+	{
+		binary_file_str_table_free(table);
+		binary_file_platform_seek(file_position, SEEK_SET, file);
+		return NULL; // No complete string in the block, or out of memory
+	}
+	binary_file_find_zeros(table->data, read, table->offsets);
+
+	// Turn the terminator positions into string starts
+	table->length = table->offsets[count - 1] + 1;
+	for (i64 i = count - 1; i > 0; i--)
+		table->offsets[i] = table->offsets[i - 1] + 1;
+	table->offsets[0] = 0;
+	table->count = count;
+
+	// Leave the cut off string for the next call
+	if (table->length != read && !binary_file_platform_seek(file_position + table->length, SEEK_SET, file))
+	{
+		binary_file_str_table_free(table);
+		return NULL; // Failure
+	}
+
+	return table;
+}
+// Get string number 'index' of a string table. The string points into the table and is valid until the table is freed.
+str binary_file_str_table_get(i64 index, binary_file_str_table* table)
+{
+	return table->data + table->offsets[index];
+}
+// Get the length of string number 'index' of a string table (without the null terminator)
+i64 binary_file_str_table_get_length(i64 index, binary_file_str_table* table)
+{
+	i64 end = (index + 1 < table->count) ? table->offsets[index + 1] : table->length;
+	return end - table->offsets[index] - 1;
+}
+// Free a string table and all its strings
+void binary_file_str_table_free(binary_file_str_table* table)
+{
+	if (table == NULL)
+		return;
+
+	free(table->offsets);
+	free(table->data);
+	free(table);
+}
+
+//
+// Implementations: Arena and strings read into an arena
+//
+// Note: An arena hands out memory by moving a pointer forward in a block. Nothing is freed one by one;
+//       binary_file_arena_reset() takes everything back at once and keeps the blocks, so a loop that reads
+//       strings and resets the arena after each batch stops calling malloc() once the blocks are in place.
+//       Strings are read straight into the free end of the current block, so there is no copy either.
+//
+
+// Allocate a new arena block that can hold at least 'capacity' bytes
+binary_file_arena_block* binary_file_arena_block_create(i64 capacity)
+{
+	i64 header = (i64)((sizeof(binary_file_arena_block) + BINARY_FILE_ARENA_ALIGNMENT - 1) & ~(size_t)(BINARY_FILE_ARENA_ALIGNMENT - 1));
+	if (capacity < 0 || capacity > INT64_MAX - header || (u64)(capacity + header) > (u64)SIZE_MAX)
+		return NULL; // Too large
+
+	binary_file_arena_block* block = (binary_file_arena_block*)malloc((size_t)(header + capacity));
+	if (block == NULL)
+		return NULL; // Out of memory
+
+	block->next = NULL;
+	block->capacity = capacity;
+	block->data = (byte*)block + header;
+	return block;
+}
+// Create an arena that allocates blocks of 'block_size' bytes (0 for the default). Returns NULL on failure.
+binary_file_arena* binary_file_arena_create(i64 block_size)
+{
+	if (block_size < 0)
+		return NULL; // Failure
+	if (block_size == 0)
+		block_size = BINARY_FILE_ARENA_BLOCK_SIZE;
+
+	binary_file_arena* arena = (binary_file_arena*)calloc(1, sizeof(binary_file_arena));
+	if (arena == NULL)
+		return NULL; // Out of memory
+
+	arena->first = binary_file_arena_block_create(block_size);
+	if (arena->first == NULL)
+	{
+		free(arena);
+		return NULL; // Out of memory
+	}
+	arena->current = arena->first;
+	arena->block_size = block_size;
+	return arena;
+}
+// Allocate 'size' bytes from an arena, aligned to BINARY_FILE_ARENA_ALIGNMENT. Returns NULL on failure.
+void* binary_file_arena_alloc(i64 size, binary_file_arena* arena)
+{
+	arena->used = (arena->used + BINARY_FILE_ARENA_ALIGNMENT - 1) & ~(i64)(BINARY_FILE_ARENA_ALIGNMENT - 1);
+
+	i64 available;
+	byte* data = binary_file_arena_reserve(size, &available, arena);
+	if (data == NULL)
+		return NULL; // Out of memory
+
+	arena->used += size;
+	return data;
+}
+// Get at least 'size' free bytes at the end of an arena without taking them. 'available' gets the number of free bytes.
+// Commit the bytes that were used with binary_file_arena_commit(). Returns NULL on failure.
+// Note: The memory of a reservation that moved to a new block is not copied, and the old one stays valid until a reset.
+byte* binary_file_arena_reserve(i64 size, i64* available, binary_file_arena* arena)
+{
+	if (size < 0)
+		return NULL; // Failure
+
+	binary_file_arena_block* block = arena->current;
+	if (block->capacity - arena->used >= size)
+	{
+		*available = block->capacity - arena->used;
+		return block->data + arena->used; // Fits in the current block
+	}
+
+	// Move on to the next block (one kept from before a reset), or put a new block in front of it
+	binary_file_arena_block* next = block->next;
+	if (next == NULL || next->capacity < size)
+	{
+		binary_file_arena_block* created = binary_file_arena_block_create((size > arena->block_size) ? size : arena->block_size);
+		if (created == NULL)
+			return NULL; // Out of memory
+
+		created->next = next;
+		block->next = created;
+		next = created;
+	}
+	arena->current = next;
+	arena->used = 0;
+
+	*available = next->capacity;
+	return next->data;
+}
+// Take 'size' bytes of the last reservation from an arena
+void binary_file_arena_commit(i64 size, binary_file_arena* arena)
+{
+	arena->used += size;
+}
+// Free everything allocated from an arena at once. The blocks are kept and used again.
+void binary_file_arena_reset(binary_file_arena* arena)
+{
+	arena->current = arena->first;
+	arena->used = 0;
+}
+// Destroy an arena and free all its blocks
+void binary_file_arena_destroy(binary_file_arena* arena)
+{
+	if (arena == NULL)
+		return;
+
+	binary_file_arena_block* block = arena->first;
+	while (block != NULL)
+	{
+		binary_file_arena_block* next = block->next;
+		free(block);
+		block = next;
+	}
+	free(arena);
+}
+// Read a null terminated 'str' from a binary file into an arena. Returns the string, or NULL on failure (the file position is restored).
+str binary_file_read_str_arena(binary_file_arena* arena, binary_file file)
+{
+	// Store file position
+	i64 file_position = binary_file_platform_tell(file);
+	if (file_position < 0)
+		return NULL; // Failure
+
+	i64 available;
+	str text = (str)binary_file_arena_reserve(BINARY_FILE_STR_CHUNK_SIZE, &available, arena);
+	if (text == NULL)
+		return NULL; // Out of memory
+
+	i64 length = 0;
+	for (;;)
+	{
+		// Read the next chunk straight into the arena
+		i64 chunk = available - length;
+		if (chunk > BINARY_FILE_STR_CHUNK_SIZE)
+			chunk = BINARY_FILE_STR_CHUNK_SIZE;
+		i64 read = (i64)BINARY_FILE_FREAD(text + length, sizeof(c8), chunk, file);
+		if (read == 0)
+			break; // Reached the end of the file without finding '\0'
+
+		// Search for the first '\0' in the chunk
+		i64 terminator = binary_file_find_zero((byte*)text + length, read);
+		if (terminator >= 0)
+		{
+			length += terminator;
+
+			// Step back to just after the null terminator
+			if (!binary_file_platform_seek(file_position + length + 1, SEEK_SET, file))
+				return NULL; // Failure
+
+			binary_file_arena_commit(length + 1, arena);
+			return text;
+		}
+		length += read;
+
+		// The free end of the block is full. Continue in a block twice the size.
+		if (length == available)
+		{
+			str larger = (str)binary_file_arena_reserve(available * 2, &available, arena);
+			if (larger == NULL)
+				break; // Out of memory
+			memcpy(larger, text, (size_t)length);
+			text = larger;
+		}
+	}
+
+	// Did not find '\0'. Restore file position.
+	binary_file_platform_seek(file_position, SEEK_SET, file);
+	return NULL;
+}
+// Read a length prefixed blob from a binary file into an arena. Returns the blob, or NULL on failure (the file position is restored). 'length' gets the number of bytes.
+// Note: A zero length blob returns a valid 1 byte block.
+byte* binary_file_read_blob_arena(i64* length, binary_file_arena* arena, binary_file file)
+{
+	file_size file_position = binary_file_platform_tell(file);
+
+	// A blob larger than a block gets a block of its own that stays in the arena, so check it against the rest of the file first
+	u64 size;
+	i64 remaining = 0;
+	if (!binary_file_read_varint_u64(&size, file) || size > (u64)INT64_MAX - 1
+		|| ((i64)size >= arena->block_size && ((remaining = binary_file_get_remaining(file)) < 0 || size > (u64)remaining)))
+	{
+		binary_file_platform_seek(file_position, SEEK_SET, file);
+		return NULL; // Failure or longer than the rest of the file
+	}
+
+	i64 available;
+	byte* data = binary_file_arena_reserve((i64)size + 1, &available, arena);
+	if (data == NULL || !binary_file_read_byte(data, (i64)size, file))
+	{
+		binary_file_platform_seek(file_position, SEEK_SET, file);
+		return NULL; // Out of memory, or something went wrong while trying to read the data
+	}
+
+	binary_file_arena_commit((i64)size + 1, arena);
+	*length = (i64)size;
+	return data;
+}
+// Read a length prefixed 'str' from a binary file into an arena. Returns the null terminated string, or NULL on failure (the file position is restored).
+str binary_file_read_str_prefixed_arena(binary_file_arena* arena, binary_file file)
+{
+	i64 length;
+	str text = (str)binary_file_read_blob_arena(&length, arena, file);
+	if (text == NULL)
+		return NULL; // Something went wrong while trying to read the data
+
+	text[length] = '\0';
+	return text;
+}
+
+//
+// Implementations: Variable length integers and length prefixed strings/blobs
+//
+// Note: A varint stores 7 bits per byte, lowest bits first, with the high bit set on every byte but the last (LEB128). Values below 128 take 1 byte, a u64 takes at most 10.
+//       Signed values are zigzag encoded first (0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...) so small negative numbers stay small.
+//       A blob or prefixed string is a varint length followed by the bytes, so a reader can skip it with one relative seek.
+//
+
+#define BINARY_FILE_VARINT_MAX 10 // Bytes needed for a 64-bit varint
+#define BINARY_FILE_BLOB_CHECKED_SIZE (64 * 1024) // Longer blobs are checked against the rest of the file before memory is allocated for them
+#define binary_file_zigzag_encode(data) (((u64)(data) << 1) ^ (0 - ((u64)(data) >> 63)))
+#define binary_file_zigzag_decode(data) ((i64)(((data) >> 1) ^ (0 - ((data) & 1))))
+
+// Encode 'data' as a varint into 'buffer' (room for BINARY_FILE_VARINT_MAX bytes). Returns the number of bytes used.
+i32 binary_file_encode_varint(u64 data, byte* buffer)
+{
+	i32 length = 0;
+	while (data >= 0x80)
+	{
+		buffer[length++] = (byte)(data | 0x80);
+		data >>= 7;
+	}
+	buffer[length++] = (byte)data;
+
+	return length;
+}
+// Decode a varint from the first 'length' bytes of 'data'. Returns the number of bytes used, or 0 if the varint is cut off or too long.
+i32 binary_file_decode_varint(const byte* data, i64 length, u64* value)
+{
+	u64 result = 0;
+	for (i32 i = 0; i < BINARY_FILE_VARINT_MAX && i < length; i++)
+	{
+		result |= (u64)(data[i] & 0x7F) << (7 * i);
+		if ((data[i] & 0x80) == 0)
+		{
+			if (i == BINARY_FILE_VARINT_MAX - 1 && data[i] > 1)
+				return 0; // More than 64 bits
+			*value = result;
+			return i + 1;
+		}
+	}
+
+	return 0; // Cut off or too long
+}
+// Write 'u32' data to a binary file as a varint (1 to 5 bytes)
+bool binary_file_write_varint_u32(u32 data, binary_file file)
+{
+	return binary_file_write_varint_u64(data, file);
+}
+// Write 'u64' data to a binary file as a varint (1 to 10 bytes)
+bool binary_file_write_varint_u64(u64 data, binary_file file)
+{
+	byte buffer[BINARY_FILE_VARINT_MAX];
+	return binary_file_write_byte(buffer, binary_file_encode_varint(data, buffer), file);
+}
+// Write 'i32' data to a binary file as a zigzag varint (1 to 5 bytes)
+bool binary_file_write_varint_i32(i32 data, binary_file file)
+{
+	return binary_file_write_varint_u64(binary_file_zigzag_encode((i64)data), file);
+}
+// Write 'i64' data to a binary file as a zigzag varint (1 to 10 bytes)
+bool binary_file_write_varint_i64(i64 data, binary_file file)
+{
+	return binary_file_write_varint_u64(binary_file_zigzag_encode(data), file);
+}
+// Write 'byte'(s) data to a binary file with a varint length prefix. The data may contain zeros.
+bool binary_file_write_blob(byte* data, i64 length, binary_file file)
+{
+	if (length < 0)
+		return false; // Invalid length
+
+	if (!binary_file_write_varint_u64((u64)length, file))
+		return false; // Something went wrong while trying to write the data
+
+	return binary_file_write_byte(data, length, file);
+}
+// Write 'str' data to a binary file with a varint length prefix (no null terminator)
+bool binary_file_write_str_prefixed(str text, binary_file file)
+{
+	return binary_file_write_blob(text, strlen((const char*)text), file);
+}
+// Read a varint as 'u32' data from a binary file. Fails if the value does not fit in 32 bits.
+bool binary_file_read_varint_u32(u32* data, binary_file file)
+{
+	u64 value;
+	if (!binary_file_read_varint_u64(&value, file) || value > 0xFFFFFFFFull)
+		return false; // Something went wrong while trying to read the data
+
+	*data = (u32)value;
+	return true; // Success
+}
+// Read a varint as 'u64' data from a binary file. Counted as one read call of the bytes it took.
+bool binary_file_read_varint_u64(u64* data, binary_file file)
+{
+	BINARY_FILE_STATS_START(start);
+	u64 result = 0;
+	i64 length = 0; // Bytes read
+	bool ok = false;
+	while (length < BINARY_FILE_VARINT_MAX)
+	{
+		int next = getc(file);
+		if (next == EOF)
+			break; // Something went wrong while trying to read the data
+
+		result |= (u64)(next & 0x7F) << (7 * length);
+		length++;
+		if ((next & 0x80) == 0)
+		{
+			ok = (length < BINARY_FILE_VARINT_MAX || next <= 1); // Not more than 64 bits
+			break;
+		}
+	}
+	BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_READ, (ok || length == BINARY_FILE_VARINT_MAX) ? length : length + 1, length, start, file); // Short if it ran into the end
+
+	if (!ok)
+		return false; // Something went wrong while trying to read the data (or too long)
+	*data = result;
+	return true; // Success
+}
+// Read a zigzag varint as 'i32' data from a binary file. Fails if the value does not fit in 32 bits.
+bool binary_file_read_varint_i32(i32* data, binary_file file)
+{
+	i64 value;
+	if (!binary_file_read_varint_i64(&value, file) || value < INT32_MIN || value > INT32_MAX)
+		return false; // Something went wrong while trying to read the data
+
+	*data = (i32)value;
+	return true; // Success
+}
+// Read a zigzag varint as 'i64' data from a binary file
+bool binary_file_read_varint_i64(i64* data, binary_file file)
+{
+	u64 value;
+	if (!binary_file_read_varint_u64(&value, file))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_zigzag_decode(value);
+	return true; // Success
+}
+// Read the length prefix of a blob and check that the blob fits in the rest of the binary file, so a corrupt length can not ask for more memory than the file holds
+bool binary_file_read_blob_size(u64* size, binary_file file)
+{
+	if (!binary_file_read_varint_u64(size, file))
+		return false; // Something went wrong while trying to read the data
+	if (*size <= BINARY_FILE_BLOB_CHECKED_SIZE)
+		return true; // Small enough to allocate without asking the file system
+
+	i64 remaining = binary_file_get_remaining(file);
+	return (remaining >= 0 && *size <= (u64)remaining);
+}
+// Read a length prefixed blob from a binary file. Returns a malloc()'ed block the user must free(), or NULL on failure (the file position is restored). 'length' gets the number of bytes.
+// Note: A zero length blob returns a valid 1 byte block.
+byte* binary_file_read_blob(i64* length, binary_file file)
+{
+	file_size file_position = binary_file_platform_tell(file);
+
+	u64 size;
+	byte* data = NULL;
+	if (!binary_file_read_blob_size(&size, file) || (data = (byte*)malloc((size_t)size + 1)) == NULL || !binary_file_read_byte(data, (i64)size, file))
+	{
+		free(data);
+		binary_file_platform_seek(file_position, SEEK_SET, file);
+		return NULL; // Failure, out of memory or longer than the rest of the file
+	}
+
+	*length = (i64)size;
+	return data;
+}
+// Read a length prefixed blob from a binary file into 'buffer' that can hold 'capacity' bytes. Returns the length, or -1 on failure or if it does not fit (the file position is restored).
+i64 binary_file_read_blob_into(byte* buffer, i64 capacity, binary_file file)
+{
+	file_size file_position = binary_file_platform_tell(file);
+
+	u64 size;
+	if (!binary_file_read_varint_u64(&size, file) || size > (u64)capacity || !binary_file_read_byte(buffer, (i64)size, file))
+	{
+		binary_file_platform_seek(file_position, SEEK_SET, file);
+		return -1; // Failure or too large for the buffer
+	}
+
+	return (i64)size;
+}
+// Read a length prefixed 'str' from a binary file. Returns a malloc()'ed null terminated string the user must free(), or NULL on failure (the file position is restored).
+str binary_file_read_str_prefixed(binary_file file)
+{
+	i64 length;
+	str text = binary_file_read_blob(&length, file);
+	if (text == NULL)
+		return NULL; // Something went wrong while trying to read the data
+
+	text[length] = '\0';
+	return text;
+}
+// Read a length prefixed 'str' from a binary file into 'buffer' that can hold 'capacity' bytes (including the null terminator that is added).
+// Returns the length of the string, or -1 on failure or if it does not fit (the file position is restored).
+i64 binary_file_read_str_prefixed_into(str buffer, i64 capacity, binary_file file)
+{
+	if (capacity <= 0)
+		return -1; // No room for the null terminator
+
+	i64 length = binary_file_read_blob_into(buffer, capacity - 1, file);
+	if (length < 0)
+		return -1; // Failure or too large for the buffer
+
+	buffer[length] = '\0';
+	return length;
+}
+// Skip a length prefixed blob or string without reading it (one varint read and one relative seek)
+bool binary_file_skip_blob(binary_file file)
+{
+	u64 size;
+	if (!binary_file_read_varint_u64(&size, file) || size > (u64)INT64_MAX)
+		return false; // Something went wrong while trying to read the data
+
+	return binary_file_set_position_relative((file_size)size, file);
+}
+// Write 'u64' data to a buffered writer as a varint (1 to 10 bytes)
+bool binary_file_writer_write_varint_u64(u64 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < BINARY_FILE_VARINT_MAX && !binary_file_writer_reserve(BINARY_FILE_VARINT_MAX, writer))
+		return false; // Something went wrong while trying to write the data
+
+	writer->used += binary_file_encode_varint(data, writer->buffer + writer->used);
+
+	return true; // Success
+}
+// Write 'i64' data to a buffered writer as a zigzag varint (1 to 10 bytes)
+bool binary_file_writer_write_varint_i64(i64 data, binary_file_writer* writer)
+{
+	return binary_file_writer_write_varint_u64(binary_file_zigzag_encode(data), writer);
+}
+// Write 'byte'(s) data to a buffered writer with a varint length prefix
+bool binary_file_writer_write_blob(byte* data, i64 length, binary_file_writer* writer)
+{
+	if (length < 0 || !binary_file_writer_write_varint_u64((u64)length, writer))
+		return false; // Something went wrong while trying to write the data
+
+	return binary_file_writer_write_byte(data, length, writer);
+}
+// Read a varint as 'u64' data from a memory mapped binary file
+bool binary_file_map_read_varint_u64(u64* data, binary_file_map* map)
+{
+	if (map->position >= map->length)
+		return false; // No data left in the file
+
+	i32 used = binary_file_decode_varint(map->data + map->position, map->length - map->position, data);
+	if (used == 0)
+		return false; // Cut off or too long
+
+	map->position += used;
+	return true; // Success
+}
+// Read a zigzag varint as 'i64' data from a memory mapped binary file
+bool binary_file_map_read_varint_i64(i64* data, binary_file_map* map)
+{
+	u64 value;
+	if (!binary_file_map_read_varint_u64(&value, map))
+		return false; // Something went wrong while trying to read the data
+
+	*data = binary_file_zigzag_decode(value);
+	return true; // Success
+}
+// Read a length prefixed blob from a memory mapped binary file. Returns a pointer into the mapping (no copy), or NULL on failure. 'length' gets the number of bytes.
+const byte* binary_file_map_read_blob(i64* length, binary_file_map* map)
+{
+	file_size position = map->position;
+
+	u64 size;
+	if (!binary_file_map_read_varint_u64(&size, map) || size > (u64)(map->length - map->position))
+	{
+		map->position = position;
+		return NULL; // Failure or cut off
+	}
+
+	*length = (i64)size;
+	return binary_file_map_read_byte((i64)size, map);
+}
+
+//
+// Implementations: Bit packing
+//
+// Note: Bit 'i' of a packed stream is bit (i % 8) of byte (i / 8). A bool array of 'count' entries takes (count + 7) / 8 bytes, 8 times less than binary_file_write_bool(..).
+//
+
+// Pack 'count' bools into bits (8 per byte) in 'packed' that holds (count + 7) / 8 bytes. Unused bits of the last byte are 0.
+// Note: Packs 32 bools per step with AVX2 or 16 per step with SSE2 (movemask), otherwise 8 per step with a multiply.
+void binary_file_pack_bools(const bool* data, i64 count, byte* packed)
+{
+	const byte* from = (const byte*)data;
+	i64 i = 0;
+#if defined(__AVX2__)
+	const __m256i zero_wide = _mm256_setzero_si256();
+	for (; i + 32 <= count; i += 32)
+	{
+		u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(from + i)), zero_wide));
+		packed[i / 8 + 0] = (byte)mask;
+		packed[i / 8 + 1] = (byte)(mask >> 8);
+		packed[i / 8 + 2] = (byte)(mask >> 16);
+		packed[i / 8 + 3] = (byte)(mask >> 24);
+	}
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		u32 mask = (u32)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(from + i)), zero));
+		packed[i / 8 + 0] = (byte)mask;
+		packed[i / 8 + 1] = (byte)(mask >> 8);
+	}
+#endif
+#ifdef BINARY_FILE_LITTLE_ENDIAN
+	for (; i + 8 <= count; i += 8)
+	{
+		u64 bools;
+		memcpy(&bools, from + i, sizeof(bools));
+#if defined(__BMI2__)
+		packed[i / 8] = (byte)_pext_u64(bools, 0x0101010101010101ull);
+#else
+		packed[i / 8] = (byte)(((bools & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56); // Gathers the lowest bit of each byte into the top byte
+#endif
+	}
+#endif
+	if (i < count)
+	{
+		byte last = 0;
+		for (i64 bit = 0; i + bit < count; bit++)
+		{
+			if (from[i + bit])
+				last |= (byte)(1 << (bit % 8));
+			if (bit % 8 == 7)
+			{
+				packed[(i + bit) / 8] = last;
+				last = 0;
+			}
+		}
+		if (count % 8 != 0)
+			packed[count / 8] = last;
+	}
+}
+// Unpack 'count' bools from bits (8 per byte) in 'packed'
+// Note: Unpacks 8 bools per step with BMI2 (pdep) or a multiply.
+void binary_file_unpack_bools(const byte* packed, i64 count, bool* data)
+{
+	byte* to = (byte*)data;
+	i64 i = 0;
+#ifdef BINARY_FILE_LITTLE_ENDIAN
+	for (; i + 8 <= count; i += 8)
+	{
+#if defined(__BMI2__)
+		u64 bools = _pdep_u64(packed[i / 8], 0x0101010101010101ull);
+#else
+		u64 bools = (((packed[i / 8] * 0x0101010101010101ull) & 0x8040201008040201ull) + 0x7F7F7F7F7F7F7F7Full) >> 7; // Spreads bit 'n' to the top of byte 'n'
+		bools &= 0x0101010101010101ull;
+#endif
+		memcpy(to + i, &bools, sizeof(bools));
+	}
+#endif
+	for (; i < count; i++)
+		to[i] = (packed[i / 8] >> (i % 8)) & 1;
+}
+// Write 'count' bools to a binary file packed into bits ((count + 7) / 8 bytes)
+bool binary_file_write_bools_packed(const bool* data, i64 count, binary_file file)
+{
+	byte packed[BINARY_FILE_BIT_BUFFER_SIZE];
+	const i64 block = sizeof(packed) * 8;
+	for (i64 i = 0; i < count; i += block)
+	{
+		i64 bools = (count - i < block) ? count - i : block;
+		binary_file_pack_bools(data + i, bools, packed);
+		if (!binary_file_write_byte(packed, (bools + 7) / 8, file))
+			return false; // Something went wrong while trying to write the data
+	}
+
+	return true; // Success
+}
+// Read 'count' bools packed into bits ((count + 7) / 8 bytes) from a binary file
+bool binary_file_read_bools_packed(bool* data, i64 count, binary_file file)
+{
+	byte packed[BINARY_FILE_BIT_BUFFER_SIZE];
+	const i64 block = sizeof(packed) * 8;
+	for (i64 i = 0; i < count; i += block)
+	{
+		i64 bools = (count - i < block) ? count - i : block;
+		if (!binary_file_read_byte(packed, (bools + 7) / 8, file))
+			return false; // Something went wrong while trying to read the data
+		binary_file_unpack_bools(packed, bools, data + i);
+	}
+
+	return true; // Success
+}
+// Create a bit writer on top of an open binary file. Note: Call binary_file_bit_writer_close(..) before writing to the file in any other way.
+binary_file_bit_writer* binary_file_bit_writer_open(binary_file file)
+{
+	binary_file_bit_writer* writer = (binary_file_bit_writer*)calloc(1, sizeof(binary_file_bit_writer));
+	if (writer == NULL)
+		return NULL;
+
+	writer->file = file;
+
+	return writer;
+}
+// Write the lowest 'width' bits (1 to 64) of 'data' to a bit writer
+bool binary_file_bit_writer_write_bits(u64 data, i32 width, binary_file_bit_writer* writer)
+{
+	if (width <= 0 || width > 64)
+		return false; // Invalid width
+
+	if (width > 56) // Would not fit next to the pending bits, write it in two halves
+	{
+		if (!binary_file_bit_writer_write_bits(data & 0xFFFFFFFFull, 32, writer))
+			return false; // Something went wrong while trying to write the data
+		return binary_file_bit_writer_write_bits(data >> 32, width - 32, writer);
+	}
+
+	data &= ((u64)1 << width) - 1;
+	writer->bits |= data << writer->bit_count;
+	writer->bit_count += width;
+
+	// Move the whole bytes to the buffer
+	while (writer->bit_count >= 8)
+	{
+		if (writer->used == BINARY_FILE_BIT_BUFFER_SIZE)
+		{
+			if (!binary_file_write_byte(writer->buffer, writer->used, writer->file))
+				return false; // Something went wrong while trying to write the data
+			writer->used = 0;
+		}
+		writer->buffer[writer->used++] = (byte)writer->bits;
+		writer->bits >>= 8;
+		writer->bit_count -= 8;
+	}
+
+	return true; // Success
+}
+// Write 'bool' data to a bit writer as a single bit
+bool binary_file_bit_writer_write_bool(bool data, binary_file_bit_writer* writer)
+{
+	return binary_file_bit_writer_write_bits(data ? 1 : 0, 1, writer);
+}
+// Write 'count' bools to a bit writer, one bit each. Whole bytes are packed in bulk.
+bool binary_file_bit_writer_write_bools(const bool* data, i64 count, binary_file_bit_writer* writer)
+{
+	byte packed[512];
+	const i64 block = sizeof(packed) * 8;
+	for (i64 i = 0; i + 8 <= count; )
+	{
+		i64 bools = (count - i < block) ? (count - i) / 8 * 8 : block;
+		binary_file_pack_bools(data + i, bools, packed);
+		for (i64 j = 0; j < bools / 8; j++)
+		{
+			if (!binary_file_bit_writer_write_bits(packed[j], 8, writer))
+				return false; // Something went wrong while trying to write the data
+		}
+		i += bools;
+	}
+
+	// The last bools that do not fill a byte
+	for (i64 i = count / 8 * 8; i < count; i++)
+	{
+		if (!binary_file_bit_writer_write_bool(data[i], writer))
+			return false; // Something went wrong while trying to write the data
+	}
+
+	return true; // Success
+}
+// Pad the pending bits of a bit writer with zeros to a whole byte and write everything to the file
+bool binary_file_bit_writer_flush(binary_file_bit_writer* writer)
+{
+	if (writer->bit_count > 0 && !binary_file_bit_writer_write_bits(0, 8 - writer->bit_count, writer))
+		return false; // Something went wrong while trying to write the data
+
+	BINARY_FILE_STATS_TIME(start);
+	if (writer->used > 0 && !binary_file_write_byte(writer->buffer, writer->used, writer->file))
+		return false; // Something went wrong while trying to write the data
+	if (writer->used > 0)
+		BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_FLUSH, writer->used, writer->used, start, writer->file);
+	writer->used = 0;
+
+	return true; // Success
+}
+// Flush and free a bit writer. Note: The binary file itself is not closed.
+bool binary_file_bit_writer_close(binary_file_bit_writer* writer)
+{
+	if (writer == NULL)
+		return false;
+
+	bool flushed = binary_file_bit_writer_flush(writer);
+	free(writer);
+
+	return flushed;
+}
+// Create a bit reader on top of an open binary file. The reader reads ahead; closing it moves the file back to just after the last byte used.
+binary_file_bit_reader* binary_file_bit_reader_open(binary_file file)
+{
+	binary_file_bit_reader* reader = (binary_file_bit_reader*)calloc(1, sizeof(binary_file_bit_reader));
+	if (reader == NULL)
+		return NULL;
+
+	reader->file = file;
+
+	return reader;
+}
+// Read 'width' bits (1 to 64) from a bit reader into the lowest bits of 'data'
+bool binary_file_bit_reader_read_bits(u64* data, i32 width, binary_file_bit_reader* reader)
+{
+	if (width <= 0 || width > 64)
+		return false; // Invalid width
+
+	if (width > 56) // Would not fit next to the pending bits, read it in two halves
+	{
+		u64 low, high;
+		if (!binary_file_bit_reader_read_bits(&low, 32, reader) || !binary_file_bit_reader_read_bits(&high, width - 32, reader))
+			return false; // Something went wrong while trying to read the data
+		*data = low | (high << 32);
+		return true; // Success
+	}
+
+	// Pull in whole bytes until there are enough bits
+	while (reader->bit_count < width)
+	{
+		if (reader->used == reader->length)
+		{
+			reader->length = (i64)BINARY_FILE_FREAD(reader->buffer, sizeof(byte), BINARY_FILE_BIT_BUFFER_SIZE, reader->file);
+			reader->used = 0;
+			if (reader->length == 0)
+				return false; // Something went wrong while trying to read the data
+		}
+		reader->bits |= (u64)reader->buffer[reader->used++] << reader->bit_count;
+		reader->bit_count += 8;
+	}
+
+	*data = reader->bits & (((u64)1 << width) - 1);
+	reader->bits >>= width;
+	reader->bit_count -= width;
+
+	return true; // Success
+}
+// Read a single bit from a bit reader as 'bool' data
+bool binary_file_bit_reader_read_bool(bool* data, binary_file_bit_reader* reader)
+{
+	u64 bit;
+	if (!binary_file_bit_reader_read_bits(&bit, 1, reader))
+		return false; // Something went wrong while trying to read the data
+
+	*data = (bit != 0);
+	return true; // Success
+}
+// Read 'count' bools from a bit reader, one bit each. Whole bytes are unpacked in bulk.
+bool binary_file_bit_reader_read_bools(bool* data, i64 count, binary_file_bit_reader* reader)
+{
+	byte packed[512];
+	const i64 block = sizeof(packed) * 8;
+	for (i64 i = 0; i + 8 <= count; )
+	{
+		i64 bools = (count - i < block) ? (count - i) / 8 * 8 : block;
+		for (i64 j = 0; j < bools / 8; j++)
+		{
+			u64 bits;
+			if (!binary_file_bit_reader_read_bits(&bits, 8, reader))
+				return false; // Something went wrong while trying to read the data
+			packed[j] = (byte)bits;
+		}
+		binary_file_unpack_bools(packed, bools, data + i);
+		i += bools;
+	}
+
+	// The last bools that do not fill a byte
+	for (i64 i = count / 8 * 8; i < count; i++)
+	{
+		if (!binary_file_bit_reader_read_bool(&data[i], reader))
+			return false; // Something went wrong while trying to read the data
+	}
+
+	return true; // Success
+}
+// Skip the rest of the current byte of a bit reader (the padding written by binary_file_bit_writer_flush(..))
+void binary_file_bit_reader_align(binary_file_bit_reader* reader)
+{
+	reader->bits >>= reader->bit_count % 8;
+	reader->bit_count -= reader->bit_count % 8;
+}
+// Free a bit reader and move the file back to just after the last byte used. Note: The binary file itself is not closed.
+bool binary_file_bit_reader_close(binary_file_bit_reader* reader)
+{
+	if (reader == NULL)
+		return false;
+
+	i64 unused = (reader->length - reader->used) + reader->bit_count / 8;
+	bool moved = (unused == 0) || binary_file_set_position_relative(-unused, reader->file);
+	free(reader);
+
+	return moved;
+}
+
+//
+// Implementations: Block compression and compressed streams
+//
+// Note: A compressed stream file looks like this (all numbers little-endian):
+//         Header:   u32 magic "BFLZ", u32 version, u32 block size
+//         Blocks:   u32 stored size (top bit set if the block is stored uncompressed), stored bytes
+//         Index:    u64 file offset of every block
+//         Trailer:  u64 uncompressed length, u64 block count, u32 block size, u32 magic "BFLZ"
+//       Every block but the last holds 'block size' uncompressed bytes, so a position maps straight to a block and the reader only decompresses that block.
+//       The blocks use the LZ4 block format: a token with 4-bit literal and match lengths, the literals, a 16-bit match offset and length extensions in 255 steps.
+//
+
+#define BINARY_FILE_LZ_MAGIC 0x5A4C4642u				// "BFLZ"
+#define BINARY_FILE_LZ_VERSION 1
+#define BINARY_FILE_LZ_STORED 0x80000000u				// Block is stored uncompressed
+#define BINARY_FILE_LZ_HASH_BITS 14
+#define BINARY_FILE_LZ_MIN_MATCH 4
+#define BINARY_FILE_LZ_MAX_OFFSET 65535
+#define BINARY_FILE_LZ_TRAILER_SIZE (8 + 8 + 4 + 4)
+
+// Get the largest compressed size of 'length' bytes (incompressible data grows a little)
+i64 binary_file_lz_bound(i64 length)
+{
+	return length + length / 255 + 16;
+}
+// Write a literal or match length extension (the part above 15) in 255 steps. Returns the new output position, or -1 if it does not fit.
+i64 binary_file_lz_write_length(i64 length, byte* destination, i64 position, i64 capacity)
+{
+	for (; length >= 255; length -= 255)
+	{
+		if (position >= capacity)
+			return -1; // Does not fit
+		destination[position++] = 255;
+	}
+	if (position >= capacity)
+		return -1; // Does not fit
+	destination[position++] = (byte)length;
+
+	return position;
+}
+// Compress 'length' bytes from 'source' into 'destination'. Returns the compressed size, or 0 if it does not fit in 'capacity' (store the data uncompressed then).
+i64 binary_file_lz_compress(const byte* source, i64 length, byte* destination, i64 capacity)
+{
+	i32 table[1 << BINARY_FILE_LZ_HASH_BITS];		// Last position of each hashed 4-byte sequence
+	memset(table, 0, sizeof(table));
+
+	i64 output = 0;
+	i64 anchor = 0;									// Start of the literals not written yet
+	i64 position = 0;
+	i64 match_limit = length - 12;					// The last bytes are always literals (as in LZ4)
+	i64 misses = 0;
+
+	while (position < match_limit)
+	{
+		u32 sequence;
+		memcpy(&sequence, source + position, sizeof(sequence));
+		u32 hash = (sequence * 2654435761u) >> (32 - BINARY_FILE_LZ_HASH_BITS);
+		i64 candidate = table[hash];
+		table[hash] = (i32)position;
+
+		u32 found;
+		memcpy(&found, source + candidate, sizeof(found));
+		if (candidate >= position || position - candidate > BINARY_FILE_LZ_MAX_OFFSET || found != sequence)
+		{
+			position += 1 + (misses++ >> 6);			// Step faster through data that does not compress
+			continue;
+		}
+		misses = 0;
+
+		// Extend the match
+		i64 match_length = BINARY_FILE_LZ_MIN_MATCH;
+		while (position + match_length < length - 5 && source[candidate + match_length] == source[position + match_length])
+			match_length++;
+
+		// Token, literals, offset and match length
+		i64 literals = position - anchor;
+		if (output >= capacity)
+			return 0; // Does not fit
+		i64 token = output++;
+		destination[token] = (byte)(((literals >= 15) ? 15 : literals) << 4);
+		if (literals >= 15 && (output = binary_file_lz_write_length(literals - 15, destination, output, capacity)) < 0)
+			return 0; // Does not fit
+		if (output + literals + 2 > capacity)
+			return 0; // Does not fit
+		memcpy(destination + output, source + anchor, literals);
+		output += literals;
+		destination[output++] = (byte)(position - candidate);
+		destination[output++] = (byte)((position - candidate) >> 8);
+		i64 extra = match_length - BINARY_FILE_LZ_MIN_MATCH;
+		destination[token] |= (byte)((extra >= 15) ? 15 : extra);
+		if (extra >= 15 && (output = binary_file_lz_write_length(extra - 15, destination, output, capacity)) < 0)
+			return 0; // Does not fit
+
+		position += match_length;
+		anchor = position;
+	}
+
+	// The last literals
+	i64 literals = length - anchor;
+	if (output >= capacity)
+		return 0; // Does not fit
+	destination[output++] = (byte)(((literals >= 15) ? 15 : literals) << 4);
+	if (literals >= 15 && (output = binary_file_lz_write_length(literals - 15, destination, output, capacity)) < 0)
+		return 0; // Does not fit
+	if (output + literals > capacity)
+		return 0; // Does not fit
+	memcpy(destination + output, source + anchor, literals);
+	output += literals;
+
+	return output;
+}
+// Decompress 'length' bytes from 'source' into 'destination'. Returns the decompressed size, or -1 if the data is corrupt or does not fit in 'capacity'.
+i64 binary_file_lz_decompress(const byte* source, i64 length, byte* destination, i64 capacity)
+{
+	i64 input = 0;
+	i64 output = 0;
+
+	while (input < length)
+	{
+		byte token = source[input++];
+
+		// Literals
+		i64 literals = token >> 4;
+		if (literals == 15)
+		{
+			byte more;
+			do
+			{
+				if (input >= length)
+					return -1; // Corrupt
+				more = source[input++];
+				literals += more;
+			} while (more == 255);
+		}
+		if (literals > length - input || literals > capacity - output)
+			return -1; // Corrupt
+		memcpy(destination + output, source + input, literals);
+		input += literals;
+		output += literals;
+
+		if (input == length)
+			break; // The last sequence has no match
+
+		// Match
+		if (length - input < 2)
+			return -1; // Corrupt
+		i64 offset = source[input] | ((i64)source[input + 1] << 8);
+		input += 2;
+		i64 match_length = (token & 15);
+		if (match_length == 15)
+		{
+			byte more;
+			do
+			{
+				if (input >= length)
+					return -1; // Corrupt
+				more = source[input++];
+				match_length += more;
+			} while (more == 255);
+		}
+		match_length += BINARY_FILE_LZ_MIN_MATCH;
+		if (offset == 0 || offset > output || match_length > capacity - output)
+			return -1; // Corrupt
+
+		// Copy byte by byte when the match overlaps what it writes
+		const byte* from = destination + output - offset;
+		if (offset >= match_length)
+			memcpy(destination + output, from, match_length);
+		else
+		{
+			for (i64 i = 0; i < match_length; i++)
+				destination[output + i] = from[i];
+		}
+		output += match_length;
+	}
+
+	return output;
+}
+// Free a compressed stream, its buffers and its parallel state (not the file)
+void binary_file_lz_stream_free(binary_file_lz_stream* stream)
+{
+	if (stream->pool != NULL)
+	{
+		binary_file_thread_pool_wait(stream->pool);
+		binary_file_thread_pool_destroy(stream->pool);
+	}
+	if (stream->slots != NULL)
+	{
+		for (i32 i = 0; i < stream->slot_count; i++)
+		{
+			free(stream->slots[i].block);
+			free(stream->slots[i].compressed);
+		}
+		free(stream->slots);
+		binary_file_platform_mutex_destroy(&stream->mutex);
+		binary_file_platform_condition_destroy(&stream->slot_changed);
+	}
+	free(stream->offsets);
+	free(stream->compressed);
+	free(stream->block);
+	free(stream);
+}
+// Create a compressed stream with room for one block
+binary_file_lz_stream* binary_file_lz_stream_create(binary_file file, bool writing, i64 block_size)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)calloc(1, sizeof(binary_file_lz_stream));
+	if (stream == NULL)
+		return NULL;
+
+	stream->file = file;
+	stream->writing = writing;
+	stream->block_size = block_size;
+	stream->block_index = -1;
+	stream->compressed_capacity = binary_file_lz_bound(block_size);
+	stream->block = (byte*)malloc(block_size);
+	stream->compressed = (byte*)malloc(stream->compressed_capacity);
+	if (stream->block == NULL || stream->compressed == NULL)
+	{
+		binary_file_lz_stream_free(stream);
+		return NULL;
+	}
+
+	return stream;
+}
+// Write one block of a compressed stream to the file. 'compressed_size' is 0 if the block is stored uncompressed.
+bool binary_file_lz_stream_put_block(const byte* block, i64 block_used, const byte* compressed, i64 compressed_size, binary_file_lz_stream* stream)
+{
+	// Remember where the block starts
+	if (stream->block_count == stream->offsets_capacity)
+	{
+		i64 capacity = (stream->offsets_capacity == 0) ? 64 : stream->offsets_capacity * 2;
+		u64* offsets = (u64*)realloc(stream->offsets, capacity * sizeof(u64));
+		if (offsets == NULL)
+			return false; // Out of memory
+		stream->offsets = offsets;
+		stream->offsets_capacity = capacity;
+	}
+	file_size offset = binary_file_platform_tell(stream->file);
+	if (offset < 0)
+		return false; // Failure
+	stream->offsets[stream->block_count] = (u64)offset;
+
+	bool written = (compressed_size > 0)
+		? binary_file_write_u32_le((u32)compressed_size, stream->file) && binary_file_write_byte((byte*)compressed, compressed_size, stream->file)
+		: binary_file_write_u32_le((u32)block_used | BINARY_FILE_LZ_STORED, stream->file) && binary_file_write_byte((byte*)block, block_used, stream->file);
+	if (!written)
+		return false; // Something went wrong while trying to write the data
+
+	stream->block_count++;
+	stream->length += block_used;
+
+	return true; // Success
+}
+// Compress the filled block of a compressed stream and write it to the file
+bool binary_file_lz_stream_write_block(binary_file_lz_stream* stream)
+{
+	if (stream->block_used == 0)
+		return true; // Nothing to write
+
+	// Store the block uncompressed if compressing does not make it smaller
+	i64 size = binary_file_lz_compress(stream->block, stream->block_used, stream->compressed, stream->block_used - 1);
+	if (!binary_file_lz_stream_put_block(stream->block, stream->block_used, stream->compressed, size, stream))
+		return false; // Something went wrong while trying to write the data
+
+	stream->block_used = 0;
+
+	return true; // Success
+}
+// Write the block index and the trailer of a compressed stream
+bool binary_file_lz_stream_write_index(binary_file_lz_stream* stream)
+{
+	for (i64 i = 0; i < stream->block_count; i++)
+	{
+		if (!binary_file_write_u64_le(stream->offsets[i], stream->file))
+			return false; // Something went wrong while trying to write the data
+	}
+
+	return binary_file_write_u64_le((u64)stream->length, stream->file)
+		&& binary_file_write_u64_le((u64)stream->block_count, stream->file)
+		&& binary_file_write_u32_le((u32)stream->block_size, stream->file)
+		&& binary_file_write_u32_le(BINARY_FILE_LZ_MAGIC, stream->file);
+}
+// Read and decompress block number 'index' of a compressed stream into 'block', using 'compressed' as room for the stored bytes. Returns the uncompressed length, or -1 on failure.
+// Note: Only reads the file with positional reads, so threads can decompress different blocks at once.
+i64 binary_file_lz_stream_decode_block(i64 index, byte* block, byte* compressed, binary_file_lz_stream* stream)
+{
+	u32 stored;
+	if (!binary_file_read_u32_at(&stored, (file_size)stream->offsets[index], stream->file))
+		return -1; // Something went wrong while trying to read the data
+	stored = binary_file_to_le_u32(stored);
+
+	i64 expected = (index == stream->block_count - 1) ? stream->length - index * stream->block_size : stream->block_size;
+	i64 size = stored & ~BINARY_FILE_LZ_STORED;
+	file_size offset = (file_size)stream->offsets[index] + sizeof(u32);
+	if (stored & BINARY_FILE_LZ_STORED)
+	{
+		if (size != expected || !binary_file_read_byte_at(block, size, offset, stream->file))
+			return -1; // Corrupt, or something went wrong while trying to read the data
+	}
+	else
+	{
+		if (size > stream->compressed_capacity || !binary_file_read_byte_at(compressed, size, offset, stream->file))
+			return -1; // Corrupt, or something went wrong while trying to read the data
+		if (binary_file_lz_decompress(compressed, size, block, stream->block_size) != expected)
+			return -1; // Corrupt
+	}
+
+	return expected;
+}
+// Read and decompress block number 'index' of a compressed stream into its block buffer
+bool binary_file_lz_stream_read_block(i64 index, binary_file_lz_stream* stream)
+{
+	i64 length = binary_file_lz_stream_decode_block(index, stream->block, stream->compressed, stream);
+	if (length < 0)
+		return false; // Failure
+
+	stream->block_index = index;
+	stream->block_used = length;
+
+	return true; // Success
+}
+// Thread pool task of a parallel compressed stream: compress (writing) or read and decompress (reading) the block of one slot
+void binary_file_lz_slot_work(void* argument)
+{
+	binary_file_lz_slot* slot = (binary_file_lz_slot*)argument;
+	binary_file_lz_stream* stream = slot->stream;
+
+	i32 state = BINARY_FILE_LZ_SLOT_DONE;
+	if (stream->writing)
+		slot->compressed_size = binary_file_lz_compress(slot->block, slot->block_used, slot->compressed, slot->block_used - 1);
+	else
+	{
+		slot->block_used = binary_file_lz_stream_decode_block(slot->index, slot->block, slot->compressed, stream);
+		if (slot->block_used < 0)
+			state = BINARY_FILE_LZ_SLOT_FAILED;
+	}
+
+	binary_file_platform_mutex_lock(&stream->mutex);
+	slot->state = state;
+	binary_file_platform_condition_broadcast(&stream->slot_changed);
+	binary_file_platform_mutex_unlock(&stream->mutex);
+}
+// I/O thread of a parallel compressed stream being written: writes the compressed blocks in order as they finish
+void binary_file_lz_io_thread(void* argument)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)argument;
+
+	binary_file_platform_mutex_lock(&stream->mutex);
+	for (;;)
+	{
+		binary_file_lz_slot* slot = &stream->slots[stream->next_write % stream->slot_count];
+		while (slot->state != BINARY_FILE_LZ_SLOT_DONE && !(stream->closing && stream->next_write == stream->next_submit))
+			binary_file_platform_condition_wait(&stream->slot_changed, &stream->mutex);
+		if (slot->state != BINARY_FILE_LZ_SLOT_DONE)
+			break; // Closing and every block is written
+		binary_file_platform_mutex_unlock(&stream->mutex);
+
+		// After a failure the blocks are only released, so the writer does not wait forever
+		bool failed = stream->failed;
+		if (!failed && !binary_file_lz_stream_put_block(slot->block, slot->block_used, slot->compressed, slot->compressed_size, stream))
+			failed = true;
+
+		binary_file_platform_mutex_lock(&stream->mutex);
+		stream->failed = failed;
+		slot->state = BINARY_FILE_LZ_SLOT_FREE;
+		stream->next_write++;
+		binary_file_platform_condition_broadcast(&stream->slot_changed);
+	}
+	binary_file_platform_mutex_unlock(&stream->mutex);
+}
+// Hand the filled block of a parallel compressed stream to the thread pool. Waits while all slots are in flight.
+bool binary_file_lz_parallel_push(binary_file_lz_stream* stream)
+{
+	if (stream->block_used == 0)
+		return true; // Nothing to write
+
+	binary_file_platform_mutex_lock(&stream->mutex);
+	binary_file_lz_slot* slot = &stream->slots[stream->next_submit % stream->slot_count];
+	while (slot->state != BINARY_FILE_LZ_SLOT_FREE && !stream->failed)
+		binary_file_platform_condition_wait(&stream->slot_changed, &stream->mutex);
+	if (stream->failed)
+	{
+		binary_file_platform_mutex_unlock(&stream->mutex);
+		return false; // Something went wrong while trying to write the data
+	}
+
+	// Swap buffers with the slot instead of copying the block
+	byte* block = slot->block;
+	slot->block = stream->block;
+	slot->block_used = stream->block_used;
+	slot->index = stream->next_submit++;
+	slot->state = BINARY_FILE_LZ_SLOT_BUSY;
+	stream->block = block;
+	stream->block_used = 0;
+	binary_file_platform_mutex_unlock(&stream->mutex);
+
+	if (!binary_file_thread_pool_submit(binary_file_lz_slot_work, slot, stream->pool))
+		binary_file_lz_slot_work(slot); // Compress on this thread instead
+
+	return true; // Success
+}
+// Get the slot holding the decompressed block number 'index' of a parallel compressed stream being read, and start decompressing the blocks after it. Returns NULL on failure.
+binary_file_lz_slot* binary_file_lz_parallel_fetch(i64 index, binary_file_lz_stream* stream)
+{
+	i64 last = index + stream->slot_count - 1;
+	if (last > stream->block_count - 1)
+		last = stream->block_count - 1;
+
+	// Read ahead: every block from 'index' on gets a slot unless it already has one
+	for (i64 i = index; i <= last; i++)
+	{
+		binary_file_lz_slot* slot = &stream->slots[i % stream->slot_count];
+
+		binary_file_platform_mutex_lock(&stream->mutex);
+		while (slot->state == BINARY_FILE_LZ_SLOT_BUSY && slot->index != i)
+			binary_file_platform_condition_wait(&stream->slot_changed, &stream->mutex);
+		bool queued = (slot->index == i && slot->state != BINARY_FILE_LZ_SLOT_FREE);
+		if (!queued)
+		{
+			slot->index = i;
+			slot->state = BINARY_FILE_LZ_SLOT_BUSY;
+		}
+		binary_file_platform_mutex_unlock(&stream->mutex);
+
+		if (!queued && !binary_file_thread_pool_submit(binary_file_lz_slot_work, slot, stream->pool))
+			binary_file_lz_slot_work(slot); // Decompress on this thread instead
+	}
+
+	// Wait for the block asked for
+	binary_file_lz_slot* slot = &stream->slots[index % stream->slot_count];
+	binary_file_platform_mutex_lock(&stream->mutex);
+	while (slot->state == BINARY_FILE_LZ_SLOT_BUSY)
+		binary_file_platform_condition_wait(&stream->slot_changed, &stream->mutex);
+	i32 state = slot->state;
+	if (state == BINARY_FILE_LZ_SLOT_FAILED)
+		slot->state = BINARY_FILE_LZ_SLOT_FREE; // Try again on the next read
+	binary_file_platform_mutex_unlock(&stream->mutex);
+
+	return (state == BINARY_FILE_LZ_SLOT_DONE) ? slot : NULL;
+}
+// Give a compressed stream a thread pool and 'slot_count' blocks in flight. Writing streams also get an I/O thread.
+bool binary_file_lz_parallel_start(i32 thread_count, i32 slot_count, binary_file_lz_stream* stream)
+{
+	stream->slots = (binary_file_lz_slot*)calloc(slot_count, sizeof(binary_file_lz_slot));
+	if (stream->slots == NULL)
+		return false; // Out of memory
+	stream->slot_count = slot_count;
+	binary_file_platform_mutex_init(&stream->mutex);
+	binary_file_platform_condition_init(&stream->slot_changed);
+
+	for (i32 i = 0; i < slot_count; i++)
+	{
+		binary_file_lz_slot* slot = &stream->slots[i];
+		slot->stream = stream;
+		slot->index = -1;
+		slot->block = (byte*)malloc(stream->block_size);
+		slot->compressed = (byte*)malloc(stream->compressed_capacity);
+		if (slot->block == NULL || slot->compressed == NULL)
+			return false; // Out of memory
+	}
+
+	stream->pool = binary_file_thread_pool_create(thread_count);
+	if (stream->pool == NULL)
+		return false; // Could not start any thread
+
+	if (stream->writing)
+	{
+		if (!binary_file_platform_thread_start(&stream->io_thread, binary_file_lz_io_thread, stream))
+			return false; // Could not start the I/O thread
+		stream->io_started = true;
+	}
+
+	return true; // Success
+}
+// Open the file of a compressed stream for writing and write the header. Returns NULL on failure.
+binary_file_lz_stream* binary_file_lz_stream_open_write(str filename, i64 block_size)
+{
+	if (block_size <= 0)
+		block_size = BINARY_FILE_LZ_BLOCK_SIZE;
+	if (block_size >= (i64)BINARY_FILE_LZ_STORED)
+		return NULL; // Block size too large
+
+	binary_file file = binary_file_openfor_write_new(filename);
+	if (file == NULL)
+		return NULL;
+
+	binary_file_lz_stream* stream = binary_file_lz_stream_create(file, true, block_size);
+	if (stream == NULL || !binary_file_write_u32_le(BINARY_FILE_LZ_MAGIC, file) || !binary_file_write_u32_le(BINARY_FILE_LZ_VERSION, file) || !binary_file_write_u32_le((u32)block_size, file))
+	{
+		if (stream != NULL)
+			binary_file_lz_stream_free(stream);
+		BINARY_FILE_FCLOSE(file);
+		return NULL;
+	}
+
+	return stream;
+}
+// Open the file of a compressed stream for reading, check the header and the trailer and load the block index. Returns NULL on failure.
+binary_file_lz_stream* binary_file_lz_stream_open_read(str filename)
+{
+	binary_file file = binary_file_openfor_read(filename);
+	if (file == NULL)
+		return NULL; // Return NULL if the binary file is not found
+
+	// Check the header and the trailer
+	u32 magic = 0, version = 0, block_size = 0, trailer_block_size = 0, trailer_magic = 0;
+	u64 length = 0, block_count = 0;
+	file_size file_length = binary_file_get_open_length(file);
+	bool valid = binary_file_read_u32_le(&magic, file) && binary_file_read_u32_le(&version, file) && binary_file_read_u32_le(&block_size, file)
+		&& file_length >= 12 + BINARY_FILE_LZ_TRAILER_SIZE
+		&& binary_file_set_position(file_length - BINARY_FILE_LZ_TRAILER_SIZE, file)
+		&& binary_file_read_u64_le(&length, file) && binary_file_read_u64_le(&block_count, file)
+		&& binary_file_read_u32_le(&trailer_block_size, file) && binary_file_read_u32_le(&trailer_magic, file);
+	valid = valid && magic == BINARY_FILE_LZ_MAGIC && trailer_magic == BINARY_FILE_LZ_MAGIC && version == BINARY_FILE_LZ_VERSION
+		&& block_size > 0 && block_size == trailer_block_size && block_size < BINARY_FILE_LZ_STORED
+		&& block_count == (length + block_size - 1) / block_size
+		&& block_count <= (u64)(file_length - 12 - BINARY_FILE_LZ_TRAILER_SIZE) / sizeof(u64);
+
+	binary_file_lz_stream* stream = valid ? binary_file_lz_stream_create(file, false, block_size) : NULL;
+	if (stream == NULL)
+	{
+		BINARY_FILE_FCLOSE(file);
+		return NULL; // Not a compressed stream, or out of memory
+	}
+	stream->length = (file_size)length;
+	stream->block_count = (i64)block_count;
+
+	// Load the block index
+	stream->offsets = (u64*)malloc((block_count > 0 ? block_count : 1) * sizeof(u64));
+	if (stream->offsets == NULL || !binary_file_set_position(file_length - BINARY_FILE_LZ_TRAILER_SIZE - (file_size)block_count * sizeof(u64), file)
+		|| !binary_file_read_elements_le(stream->offsets, sizeof(u64), (i64)block_count, file))
+	{
+		binary_file_lz_stream_free(stream);
+		BINARY_FILE_FCLOSE(file);
+		return NULL;
+	}
+
+	return stream;
+}
+// Close a parallel compressed stream being written: hand over the last block and wait for the I/O thread to write everything
+bool binary_file_lz_parallel_finish(binary_file_lz_stream* stream)
+{
+	bool ok = binary_file_lz_parallel_push(stream);
+
+	binary_file_platform_mutex_lock(&stream->mutex);
+	stream->closing = true;
+	binary_file_platform_condition_broadcast(&stream->slot_changed);
+	binary_file_platform_mutex_unlock(&stream->mutex);
+
+	binary_file_platform_thread_join(stream->io_thread);
+	stream->io_started = false;
+
+	return ok && !stream->failed;
+}
+#ifdef BINARY_FILE_STREAM_COOKIE
+// fopencookie() write callback: fill blocks and write (or hand over) each one when it is full
+ssize_t binary_file_lz_cookie_write(void* cookie, const char* data, size_t size)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)cookie;
+
+	size_t done = 0;
+	while (done < size)
+	{
+		i64 room = stream->block_size - stream->block_used;
+		i64 chunk = ((i64)(size - done) < room) ? (i64)(size - done) : room;
+		memcpy(stream->block + stream->block_used, data + done, chunk);
+		stream->block_used += chunk;
+		done += chunk;
+
+		if (stream->block_used == stream->block_size)
+		{
+			bool written = (stream->slots != NULL) ? binary_file_lz_parallel_push(stream) : binary_file_lz_stream_write_block(stream);
+			if (!written)
+				return -1; // Failure
+		}
+	}
+
+	return (ssize_t)size;
+}
+// fopencookie() read callback: decompress the block holding the position and copy from it
+ssize_t binary_file_lz_cookie_read(void* cookie, char* data, size_t size)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)cookie;
+
+	size_t done = 0;
+	while (done < size && stream->position < stream->length)
+	{
+		i64 index = stream->position / stream->block_size;
+		const byte* block;
+		i64 block_used;
+		if (stream->slots != NULL)
+		{
+			binary_file_lz_slot* slot = binary_file_lz_parallel_fetch(index, stream);
+			if (slot == NULL)
+				return (done > 0) ? (ssize_t)done : -1; // Failure
+			block = slot->block;
+			block_used = slot->block_used;
+		}
+		else
+		{
+			if (index != stream->block_index && !binary_file_lz_stream_read_block(index, stream))
+				return (done > 0) ? (ssize_t)done : -1; // Failure
+			block = stream->block;
+			block_used = stream->block_used;
+		}
+
+		i64 start = stream->position - index * stream->block_size;
+		i64 chunk = block_used - start;
+		if (chunk > (i64)(size - done))
+			chunk = (i64)(size - done);
+		memcpy(data + done, block + start, chunk);
+		stream->position += chunk;
+		done += chunk;
+	}
+
+	return (ssize_t)done;
+}
+// fopencookie() seek callback: any position when reading, only the current position when writing
+int binary_file_lz_cookie_seek(void* cookie, off64_t* position, int origin)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)cookie;
+
+	if (stream->writing)
+	{
+		file_size current;
+		if (stream->slots != NULL)
+		{
+			binary_file_platform_mutex_lock(&stream->mutex);
+			current = stream->next_submit * stream->block_size + stream->block_used;
+			binary_file_platform_mutex_unlock(&stream->mutex);
+		}
+		else
+			current = stream->length + stream->block_used;
+		if (!((origin == SEEK_CUR && *position == 0) || (origin == SEEK_SET && *position == current) || (origin == SEEK_END && *position == 0)))
+			return -1; // Compressed streams are written front to back
+		*position = current;
+		return 0;
+	}
+
+	file_size target = *position;
+	if (origin == SEEK_CUR)
+		target += stream->position;
+	else if (origin == SEEK_END)
+		target += stream->length;
+	if (target < 0)
+		return -1; // Before the beginning
+
+	stream->position = target;
+	*position = target;
+	return 0;
+}
+// fopencookie() close callback: write the last block, the index and the trailer, then close the real file
+int binary_file_lz_cookie_close(void* cookie)
+{
+	binary_file_lz_stream* stream = (binary_file_lz_stream*)cookie;
+
+	bool ok = true;
+	if (stream->writing)
+	{
+		ok = (stream->slots != NULL) ? binary_file_lz_parallel_finish(stream) : binary_file_lz_stream_write_block(stream);
+		ok = ok && binary_file_lz_stream_write_index(stream);
+	}
+
+	binary_file file = stream->file;
+	binary_file_lz_stream_free(stream); // Waits for blocks still being read ahead
+	ok = (BINARY_FILE_FCLOSE(file) == 0) && ok;
+
+	return ok ? 0 : -1;
+}
+#endif
+// Turn a compressed stream into a binary file whose reads and writes go through it. Frees the stream and closes its file on failure.
+binary_file binary_file_lz_stream_to_file(binary_file_lz_stream* stream)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	cookie_io_functions_t functions = { binary_file_lz_cookie_read, binary_file_lz_cookie_write, binary_file_lz_cookie_seek, binary_file_lz_cookie_close };
+	binary_file compressed = fopencookie(stream, stream->writing ? "wb" : "rb", functions);
+	if (compressed != NULL)
+		return compressed;
+#endif
+	if (stream->io_started)
+		binary_file_lz_parallel_finish(stream);
+	binary_file file = stream->file;
+	binary_file_lz_stream_free(stream);
+	BINARY_FILE_FCLOSE(file);
+	return NULL;
+}
+// Open a binary file for writing as a compressed stream (truncate mode). Use the normal write functions and binary_file_close_checked(..) on it,
+// which writes the last block and the block index and returns false if that failed (the file can not be opened then).
+// Data is compressed in blocks of 'block_size' bytes (0 = BINARY_FILE_LZ_BLOCK_SIZE). Only the current position can be asked for, seeking is not possible.
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms.
+binary_file binary_file_openfor_write_compressed(str filename, i64 block_size)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_lz_stream* stream = binary_file_lz_stream_open_write(filename, block_size);
+	if (stream == NULL)
+		return NULL;
+
+	return binary_file_lz_stream_to_file(stream);
+#else
+	(void)filename;
+	(void)block_size;
+	return NULL; // Not supported on this platform
+#endif
+}
+// Open a compressed stream for reading. Use the normal read functions, binary_file_set_position*(..) and binary_file_close(..) on it.
+// A seek only decompresses the block that holds the new position. Returns NULL if the file is not found or is not a compressed stream.
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms.
+binary_file binary_file_openfor_read_compressed(str filename)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_lz_stream* stream = binary_file_lz_stream_open_read(filename);
+	if (stream == NULL)
+		return NULL;
+
+	return binary_file_lz_stream_to_file(stream);
+#else
+	(void)filename;
+	return NULL; // Not supported on this platform
+#endif
+}
+// Open a binary file for writing as a compressed stream whose blocks are compressed on a thread pool and written in order by an I/O thread.
+// 'options' can be NULL for the defaults. At most 'max_in_flight' blocks are being compressed or waiting to be written, which bounds the memory used.
+// The file is the same format as binary_file_openfor_write_compressed(..) writes; close it with binary_file_close_checked(..) too.
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms.
+binary_file binary_file_openfor_write_compressed_parallel(str filename, const binary_file_lz_options* options)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_lz_options defaults = { 0, 0, 0 };
+	if (options == NULL)
+		options = &defaults;
+	i32 thread_count = (options->thread_count > 0) ? options->thread_count : binary_file_platform_get_cpu_count();
+	i32 max_in_flight = (options->max_in_flight > 0) ? options->max_in_flight : thread_count * 2;
+
+	binary_file_lz_stream* stream = binary_file_lz_stream_open_write(filename, options->block_size);
+	if (stream == NULL)
+		return NULL;
+	if (!binary_file_lz_parallel_start(thread_count, max_in_flight, stream))
+	{
+		binary_file file = stream->file;
+		binary_file_lz_stream_free(stream);
+		BINARY_FILE_FCLOSE(file);
+		return NULL;
+	}
+
+	return binary_file_lz_stream_to_file(stream);
+#else
+	(void)filename;
+	(void)options;
+	return NULL; // Not supported on this platform
+#endif
+}
+// Open a compressed stream for reading with blocks decompressed ahead of the position on a thread pool. 'options' can be NULL for the defaults.
+// Up to 'max_in_flight' blocks from the position on are decompressed at once ('block_size' is ignored, it comes from the file).
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms.
+binary_file binary_file_openfor_read_compressed_parallel(str filename, const binary_file_lz_options* options)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_lz_options defaults = { 0, 0, 0 };
+	if (options == NULL)
+		options = &defaults;
+	i32 thread_count = (options->thread_count > 0) ? options->thread_count : binary_file_platform_get_cpu_count();
+	i32 max_in_flight = (options->max_in_flight > 0) ? options->max_in_flight : thread_count * 2;
+
+	binary_file_lz_stream* stream = binary_file_lz_stream_open_read(filename);
+	if (stream == NULL)
+		return NULL;
+	if (!binary_file_lz_parallel_start(thread_count, max_in_flight, stream))
+	{
+		binary_file file = stream->file;
+		binary_file_lz_stream_free(stream);
+		BINARY_FILE_FCLOSE(file);
+		return NULL;
+	}
+
+	return binary_file_lz_stream_to_file(stream);
+#else
+	(void)filename;
+	(void)options;
+	return NULL; // Not supported on this platform
+#endif
+}
+
+//
+// Implementations: Direct I/O
+//
+// Note: A direct stream is a binary file (fopencookie()) whose data goes to the real file with aligned positional reads and
+//       writes only. Large transfers from and to aligned memory (e.g. buffers from a buffer pool) go straight between that
+//       memory and the storage device. Unaligned heads and tails, and small transfers, go through the aligned staging buffer.
+//       The last block written is padded, and the file is cut back to its real length on close.
+//
+
+// Create a pool of 'buffer_count' buffers of 'buffer_size' bytes (rounded up to BINARY_FILE_DIRECT_ALIGNMENT), all allocated up front and page aligned. Returns NULL if out of memory.
+binary_file_buffer_pool* binary_file_buffer_pool_create(i64 buffer_size, i32 buffer_count)
+{
+	if (buffer_size <= 0 || buffer_count <= 0)
+		return NULL; // Invalid size
+
+	binary_file_buffer_pool* pool = (binary_file_buffer_pool*)calloc(1, sizeof(binary_file_buffer_pool));
+	if (pool == NULL)
+		return NULL; // Out of memory
+	pool->buffer_size = (buffer_size + BINARY_FILE_DIRECT_ALIGNMENT - 1) & ~(i64)(BINARY_FILE_DIRECT_ALIGNMENT - 1);
+	pool->capacity = buffer_count;
+	pool->buffers = (byte**)malloc(buffer_count * sizeof(byte*));
+	if (pool->buffers == NULL)
+	{
+		free(pool);
+		return NULL; // Out of memory
+	}
+	binary_file_platform_mutex_init(&pool->mutex);
+	for (; pool->count < buffer_count; pool->count++)
+	{
+		pool->buffers[pool->count] = (byte*)binary_file_platform_aligned_alloc(pool->buffer_size, BINARY_FILE_DIRECT_ALIGNMENT);
+		if (pool->buffers[pool->count] == NULL)
+		{
+			binary_file_buffer_pool_destroy(pool);
+			return NULL; // Out of memory
+		}
+	}
+
+	return pool;
+}
+// Take a buffer from a pool (safe to call from many threads). Returns NULL if every buffer is in use.
+byte* binary_file_buffer_pool_acquire(binary_file_buffer_pool* pool)
+{
+	byte* buffer = NULL;
+	binary_file_platform_mutex_lock(&pool->mutex);
+	if (pool->count > 0)
+		buffer = pool->buffers[--pool->count];
+	binary_file_platform_mutex_unlock(&pool->mutex);
+
+	return buffer;
+}
+// Give a buffer back to the pool it came from (safe to call from many threads)
+void binary_file_buffer_pool_release(byte* buffer, binary_file_buffer_pool* pool)
+{
+	if (buffer == NULL)
+		return;
+
+	binary_file_platform_mutex_lock(&pool->mutex);
+	assert(pool->count < pool->capacity);
+	pool->buffers[pool->count++] = buffer;
+	binary_file_platform_mutex_unlock(&pool->mutex);
+}
+// Get the size of the buffers of a pool
+i64 binary_file_buffer_pool_get_buffer_size(binary_file_buffer_pool* pool)
+{
+	return pool->buffer_size;
+}
+// Free a pool and its buffers. Every buffer must have been released.
+void binary_file_buffer_pool_destroy(binary_file_buffer_pool* pool)
+{
+	if (pool == NULL)
+		return;
+
+	for (i32 i = 0; i < pool->count; i++)
+		binary_file_platform_aligned_free(pool->buffers[i]);
+	binary_file_platform_mutex_destroy(&pool->mutex);
+	free(pool->buffers);
+	free(pool);
+}
+// Check if a pointer and a length are both aligned for a direct transfer
+bool binary_file_direct_is_aligned(const void* data, i64 length)
+{
+	return ((((uintptr_t)data | (uintptr_t)length) & (BINARY_FILE_DIRECT_ALIGNMENT - 1)) == 0);
+}
+// Free a direct stream, giving its buffer back to its pool
+void binary_file_direct_stream_free(binary_file_direct_stream* stream)
+{
+	if (stream->pool != NULL)
+		binary_file_buffer_pool_release(stream->buffer, stream->pool);
+	else
+		binary_file_platform_aligned_free(stream->buffer);
+	free(stream);
+}
+// Open a direct stream and get its staging buffer from 'pool' (or allocate one if 'pool' is NULL or has no free buffer). Returns NULL on failure.
+binary_file_direct_stream* binary_file_direct_stream_open(str filename, bool writing, binary_file_buffer_pool* pool)
+{
+	binary_file_direct_stream* stream = (binary_file_direct_stream*)calloc(1, sizeof(binary_file_direct_stream));
+	if (stream == NULL)
+		return NULL; // Out of memory
+	stream->writing = writing;
+	if (pool != NULL && (stream->buffer = binary_file_buffer_pool_acquire(pool)) != NULL)
+	{
+		stream->pool = pool;
+		stream->capacity = pool->buffer_size;
+	}
+	else
+	{
+		stream->capacity = BINARY_FILE_DIRECT_BUFFER_SIZE;
+		stream->buffer = (byte*)binary_file_platform_aligned_alloc(stream->capacity, BINARY_FILE_DIRECT_ALIGNMENT);
+	}
+	if (stream->buffer != NULL)
+		stream->file = binary_file_platform_open_direct(filename, writing, &stream->direct);
+	if (stream->file == NULL)
+	{
+		if (stream->buffer == NULL)
+			free(stream);
+		else
+			binary_file_direct_stream_free(stream);
+		return NULL;
+	}
+	if (!writing)
+		stream->length = binary_file_platform_get_length(stream->file);
+
+	return stream;
+}
+#ifdef BINARY_FILE_STREAM_COOKIE
+// fopencookie() write callback: write aligned memory straight to the file, stage the rest and write it a full buffer at a time
+ssize_t binary_file_direct_cookie_write(void* cookie, const char* data, size_t size)
+{
+	binary_file_direct_stream* stream = (binary_file_direct_stream*)cookie;
+	const byte* bytes = (const byte*)data;
+	i64 remaining = (i64)size;
+
+	while (remaining > 0)
+	{
+		i64 chunk;
+		if (stream->used == 0 && remaining >= BINARY_FILE_DIRECT_ALIGNMENT && binary_file_direct_is_aligned(bytes, 0))
+		{
+			// Straight from the caller's memory
+			chunk = remaining & ~(i64)(BINARY_FILE_DIRECT_ALIGNMENT - 1);
+			if (binary_file_platform_pwrite(bytes, chunk, stream->buffer_offset, stream->file) != chunk)
+				return -1; // Something went wrong while trying to write the data
+			stream->buffer_offset += chunk;
+		}
+		else
+		{
+			chunk = stream->capacity - stream->used;
+			if (chunk > remaining)
+				chunk = remaining;
+			memcpy(stream->buffer + stream->used, bytes, chunk);
+			stream->used += chunk;
+			if (stream->used == stream->capacity)
+			{
+				if (binary_file_platform_pwrite(stream->buffer, stream->capacity, stream->buffer_offset, stream->file) != stream->capacity)
+					return -1; // Something went wrong while trying to write the data
+				stream->buffer_offset += stream->capacity;
+				stream->used = 0;
+			}
+		}
+		bytes += chunk;
+		remaining -= chunk;
+		stream->position += chunk;
+	}
+
+	return (ssize_t)size;
+}
+// fopencookie() read callback: read large aligned requests straight into the caller's memory, the rest through the staging buffer
+ssize_t binary_file_direct_cookie_read(void* cookie, char* data, size_t size)
+{
+	binary_file_direct_stream* stream = (binary_file_direct_stream*)cookie;
+	byte* bytes = (byte*)data;
+	i64 remaining = (i64)size;
+	i64 total = 0;
+
+	while (remaining > 0 && stream->position < stream->length)
+	{
+		i64 start = stream->position - stream->buffer_offset;
+		i64 chunk;
+		if (start >= 0 && start < stream->used)
+		{
+			// From the staging buffer
+			chunk = stream->used - start;
+			if (chunk > remaining)
+				chunk = remaining;
+			memcpy(bytes, stream->buffer + start, chunk);
+		}
+		else if (remaining >= BINARY_FILE_DIRECT_ALIGNMENT && binary_file_direct_is_aligned(bytes, stream->position))
+		{
+			// Straight into the caller's memory
+			chunk = binary_file_platform_pread(bytes, remaining & ~(i64)(BINARY_FILE_DIRECT_ALIGNMENT - 1), stream->position, stream->file);
+			if (chunk < 0)
+				return -1; // Something went wrong while trying to read the data
+			if (chunk == 0)
+				break; // End of the file
+		}
+		else
+		{
+			stream->buffer_offset = stream->position & ~(file_size)(BINARY_FILE_DIRECT_ALIGNMENT - 1);
+			stream->used = binary_file_platform_pread(stream->buffer, stream->capacity, stream->buffer_offset, stream->file);
+			if (stream->used < 0)
+			{
+				stream->used = 0;
+				return -1; // Something went wrong while trying to read the data
+			}
+			if (stream->position >= stream->buffer_offset + stream->used)
+				break; // End of the file
+			continue;
+		}
+		bytes += chunk;
+		remaining -= chunk;
+		total += chunk;
+		stream->position += chunk;
+	}
+
+	return (ssize_t)total;
+}
+// fopencookie() seek callback: any position when reading, only the current position when writing
+int binary_file_direct_cookie_seek(void* cookie, off64_t* position, int origin)
+{
+	binary_file_direct_stream* stream = (binary_file_direct_stream*)cookie;
+
+	if (stream->writing)
+	{
+		if (!((origin == SEEK_CUR && *position == 0) || (origin == SEEK_SET && *position == stream->position) || (origin == SEEK_END && *position == 0)))
+			return -1; // Direct streams are written front to back
+		*position = stream->position;
+		return 0;
+	}
+
+	file_size target = *position;
+	if (origin == SEEK_CUR)
+		target += stream->position;
+	else if (origin == SEEK_END)
+		target += stream->length;
+	if (target < 0)
+		return -1; // Before the beginning
+
+	stream->position = target;
+	*position = target;
+	return 0;
+}
+// fopencookie() close callback: write the padded last block, cut the file back to its length and close it
+int binary_file_direct_cookie_close(void* cookie)
+{
+	binary_file_direct_stream* stream = (binary_file_direct_stream*)cookie;
+
+	bool ok = true;
+	if (stream->writing && stream->used > 0)
+	{
+		i64 padded = (stream->used + BINARY_FILE_DIRECT_ALIGNMENT - 1) & ~(i64)(BINARY_FILE_DIRECT_ALIGNMENT - 1);
+		memset(stream->buffer + stream->used, 0, padded - stream->used);
+		ok = (binary_file_platform_pwrite(stream->buffer, padded, stream->buffer_offset, stream->file) == padded);
+		ok = ok && binary_file_platform_truncate(stream->position, stream->file);
+	}
+
+	binary_file file = stream->file;
+	binary_file_direct_stream_free(stream);
+	ok = (BINARY_FILE_FCLOSE(file) == 0) && ok;
+
+	return ok ? 0 : -1;
+}
+#endif
+// Turn a direct stream into a binary file whose reads and writes go through it. Frees the stream and closes its file on failure.
+binary_file binary_file_direct_stream_to_file(binary_file_direct_stream* stream)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	cookie_io_functions_t functions = { binary_file_direct_cookie_read, binary_file_direct_cookie_write, binary_file_direct_cookie_seek, binary_file_direct_cookie_close };
+	binary_file direct = fopencookie(stream, stream->writing ? "wb" : "rb", functions);
+	if (direct != NULL)
+		return direct;
+#endif
+	binary_file file = stream->file;
+	binary_file_direct_stream_free(stream);
+	BINARY_FILE_FCLOSE(file);
+	return NULL;
+}
+// Open a binary file for writing past the page cache (truncate mode). Use the normal write functions and binary_file_close_checked(..) on it,
+// which writes the unaligned tail and cuts the file back to its length, and returns false if that failed.
+// The staging buffer comes from 'pool' if it has a free one (NULL = allocate BINARY_FILE_DIRECT_BUFFER_SIZE). Only the current position can be asked for, seeking is not possible.
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms. Falls back to normal I/O on file systems without O_DIRECT.
+binary_file binary_file_openfor_write_direct(str filename, binary_file_buffer_pool* pool)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_direct_stream* stream = binary_file_direct_stream_open(filename, true, pool);
+	if (stream == NULL)
+		return NULL;
+
+	return binary_file_direct_stream_to_file(stream);
+#else
+	(void)filename;
+	(void)pool;
+	return NULL; // Not supported on this platform
+#endif
+}
+// Open a binary file for reading past the page cache. Use the normal read and seek functions and binary_file_close(..) on it.
+// The staging buffer comes from 'pool' if it has a free one (NULL = allocate BINARY_FILE_DIRECT_BUFFER_SIZE).
+// Note: Needs fopencookie() (glibc/Linux). Returns NULL on other platforms. Falls back to normal I/O on file systems without O_DIRECT.
+binary_file binary_file_openfor_read_direct(str filename, binary_file_buffer_pool* pool)
+{
+#ifdef BINARY_FILE_STREAM_COOKIE
+	binary_file_direct_stream* stream = binary_file_direct_stream_open(filename, false, pool);
+	if (stream == NULL)
+		return NULL;
+
+	return binary_file_direct_stream_to_file(stream);
+#else
+	(void)filename;
+	(void)pool;
+	return NULL; // Not supported on this platform
+#endif
+}
+
+//
+// Implementations: Memory mapped binary file
+//
+
+// Map a binary file read-only into memory. Returns NULL if the file does not exist or cannot be mapped.
+binary_file_map* binary_file_mapfor_read(str filename)
+{
+	binary_file_map* map = (binary_file_map*)calloc(1, sizeof(binary_file_map));
+	if (map == NULL)
+		return NULL;
+
+	if (!binary_file_platform_map(filename, map))
+	{
+		free(map);
+		return NULL; // Return NULL if the binary file is not found or can not be mapped
+	}
+
+	return map;
+}
+// Get the length of a memory mapped binary file
+file_size binary_file_map_get_length(binary_file_map* map)
+{
+	return map->length;
+}
+// Read 'byte'(s) from a memory mapped binary file. Returns a pointer into the mapping (no copy), or NULL if there are not enough bytes left.
+const byte* binary_file_map_read_byte(i64 length, binary_file_map* map)
+{
+	if (length < 0 || length > map->length - map->position)
+		return NULL; // Not enough data left in the file
+
+	const byte* data = map->data + map->position;
+	map->position += length;
+
+	return data; // Success
+}
+// Read 'elements'(s) from a memory mapped binary file. Returns a pointer into the mapping (no copy), or NULL if there are not enough elements left.
+// Note: The pointer is only aligned for the element type if the element offset in the file is aligned.
+const void* binary_file_map_read_elements(i64 size, i64 count, binary_file_map* map)
+{
+	if (size <= 0 || count < 0 || count > (map->length - map->position) / size)
+		return NULL; // Not enough data left in the file
+
+	return binary_file_map_read_byte(size * count, map);
+}
+// Read 'str' data from a memory mapped binary file. Returns a pointer to the null terminated string inside the mapping (no copy), or NULL if no '\0' was found.
+const c8* binary_file_map_read_str(binary_file_map* map)
+{
+	if (map->position >= map->length)
+		return NULL; // No data left in the file
+
+	const c8* text = map->data + map->position;
+	i64 terminator = binary_file_find_zero(text, map->length - map->position);
+	if (terminator < 0)
+		return NULL; // Did not find '\0'
+
+	map->position += terminator + 1;
+
+	return text; // Success
+}
+// Read 'i8' data from a memory mapped binary file
+bool binary_file_map_read_i8(i8* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(i8), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(i8));
+	return true; // Success
+}
+// Read 'i16' data from a memory mapped binary file
+bool binary_file_map_read_i16(i16* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(i16), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(i16));
+	return true; // Success
+}
+// Read 'i32' data from a memory mapped binary file
+bool binary_file_map_read_i32(i32* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(i32), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(i32));
+	return true; // Success
+}
+// Read 'i64' data from a memory mapped binary file
+bool binary_file_map_read_i64(i64* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(i64), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(i64));
+	return true; // Success
+}
+// Read 'u8' data from a memory mapped binary file
+bool binary_file_map_read_u8(u8* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(u8), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(u8));
+	return true; // Success
+}
+// Read 'u16' data from a memory mapped binary file
+bool binary_file_map_read_u16(u16* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(u16), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(u16));
+	return true; // Success
+}
+// Read 'u32' data from a memory mapped binary file
+bool binary_file_map_read_u32(u32* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(u32), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(u32));
+	return true; // Success
+}
+// Read 'u64' data from a memory mapped binary file
+bool binary_file_map_read_u64(u64* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(u64), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(u64));
+	return true; // Success
+}
+// Read 'f32' data from a memory mapped binary file
+bool binary_file_map_read_f32(f32* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(f32), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(f32));
+	return true; // Success
+}
+// Read 'f64' data from a memory mapped binary file
+bool binary_file_map_read_f64(f64* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(f64), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(f64));
+	return true; // Success
+}
+// Read 'bool' data from a memory mapped binary file. Note this reads 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_map_read_bool(bool* data, binary_file_map* map)
+{
+	const byte* source = binary_file_map_read_byte(sizeof(bool), map);
+	if (source == NULL)
+		return false; // Not enough data left in the file
+
+	memcpy(data, source, sizeof(bool));
+	return true; // Success
+}
+// Seek to the beginning of a memory mapped binary file
+bool binary_file_map_set_position_begin(binary_file_map* map)
+{
+	map->position = 0;
+	return true; // Success
+}
+// Seek to an absolute position in a memory mapped binary file. Returns false if the position is outside the file.
+bool binary_file_map_set_position(file_size position, binary_file_map* map)
+{
+	if (position < 0 || position > map->length)
+		return false; // Outside the file
+
+	map->position = position;
+	return true; // Success
+}
+// Seek to a relative position in a memory mapped binary file. Returns false if the position is outside the file.
+bool binary_file_map_set_position_relative(file_size position, binary_file_map* map)
+{
+	return binary_file_map_set_position(map->position + position, map);
+}
+// Seek to the end of a memory mapped binary file
+bool binary_file_map_set_position_end(binary_file_map* map)
+{
+	map->position = map->length;
+	return true; // Success
+}
+// Get the current position in a memory mapped binary file
+file_size binary_file_map_get_position(binary_file_map* map)
+{
+	return map->position;
+}
+// Unmap a memory mapped binary file. Pointers returned by the read functions are invalid afterwards.
+void binary_file_map_close(binary_file_map* map)
+{
+	if (map == NULL)
+		return;
+
+	binary_file_platform_unmap(map);
+
+	free(map);
+}
+
+//
+// Implementations: Buffered binary file writer
+//
+
+// Create a buffered writer on top of an open binary file. The scalar writes only store into a buffer of 'capacity' bytes; the file is written when the buffer is full, on flush and on close.
+binary_file_writer* binary_file_writer_open(binary_file file, i64 capacity)
+{
+	if (capacity <= 0)
+		return NULL; // Invalid capacity
+
+	binary_file_writer* writer = (binary_file_writer*)calloc(1, sizeof(binary_file_writer));
+	if (writer == NULL)
+		return NULL;
+
+	writer->buffer = (byte*)malloc(capacity);
+	if (writer->buffer == NULL)
+	{
+		free(writer);
+		return NULL;
+	}
+	writer->file = file;
+	writer->capacity = capacity;
+
+	return writer;
+}
+// Create a growable (arena-style) buffered writer. The buffer grows instead of being written when it is full, so the file is only written on flush and on close.
+binary_file_writer* binary_file_writer_open_growable(binary_file file, i64 initial_capacity)
+{
+	binary_file_writer* writer = binary_file_writer_open(file, initial_capacity);
+	if (writer == NULL)
+		return NULL;
+
+	writer->growable = true;
+
+	return writer;
+}
+// Make room for 'length' more bytes in the buffer. Flushes (or grows) the buffer if needed. Returns false if the bytes can not fit in the buffer.
+bool binary_file_writer_reserve(i64 length, binary_file_writer* writer)
+{
+	if (length <= writer->capacity - writer->used)
+		return true; // Already fits
+
+	if (writer->growable)
+	{
+		i64 capacity = writer->capacity * 2;
+		if (capacity < writer->used + length)
+			capacity = writer->used + length;
+
+		byte* buffer = (byte*)realloc(writer->buffer, capacity);
+		if (buffer == NULL)
+			return false; // Out of memory
+
+		writer->buffer = buffer;
+		writer->capacity = capacity;
+		return true; // Success
+	}
+
+	if (!binary_file_writer_flush(writer))
+		return false; // Something went wrong while trying to write the data
+
+	return (length <= writer->capacity);
+}
+// Write 'i8' data to a buffered writer
+bool binary_file_writer_write_i8(i8 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(i8) && !binary_file_writer_reserve(sizeof(i8), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(i8));
+	writer->used += sizeof(i8);
+
+	return true; // Success
+}
+// Write 'i16' data to a buffered writer
+bool binary_file_writer_write_i16(i16 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(i16) && !binary_file_writer_reserve(sizeof(i16), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(i16));
+	writer->used += sizeof(i16);
+
+	return true; // Success
+}
+// Write 'i32' data to a buffered writer
+bool binary_file_writer_write_i32(i32 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(i32) && !binary_file_writer_reserve(sizeof(i32), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(i32));
+	writer->used += sizeof(i32);
+
+	return true; // Success
+}
+// Write 'i64' data to a buffered writer
+bool binary_file_writer_write_i64(i64 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(i64) && !binary_file_writer_reserve(sizeof(i64), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(i64));
+	writer->used += sizeof(i64);
+
+	return true; // Success
+}
+// Write 'u8' data to a buffered writer
+bool binary_file_writer_write_u8(u8 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(u8) && !binary_file_writer_reserve(sizeof(u8), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(u8));
+	writer->used += sizeof(u8);
+
+	return true; // Success
+}
+// Write 'u16' data to a buffered writer
+bool binary_file_writer_write_u16(u16 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(u16) && !binary_file_writer_reserve(sizeof(u16), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(u16));
+	writer->used += sizeof(u16);
+
+	return true; // Success
+}
+// Write 'u32' data to a buffered writer
+bool binary_file_writer_write_u32(u32 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(u32) && !binary_file_writer_reserve(sizeof(u32), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(u32));
+	writer->used += sizeof(u32);
+
+	return true; // Success
+}
+// Write 'u64' data to a buffered writer
+bool binary_file_writer_write_u64(u64 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(u64) && !binary_file_writer_reserve(sizeof(u64), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(u64));
+	writer->used += sizeof(u64);
+
+	return true; // Success
+}
+// Write 'f32' data to a buffered writer
+bool binary_file_writer_write_f32(f32 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(f32) && !binary_file_writer_reserve(sizeof(f32), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(f32));
+	writer->used += sizeof(f32);
+
+	return true; // Success
+}
+// Write 'f64' data to a buffered writer
+bool binary_file_writer_write_f64(f64 data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(f64) && !binary_file_writer_reserve(sizeof(f64), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(f64));
+	writer->used += sizeof(f64);
+
+	return true; // Success
+}
+// Write 'bool' data to a buffered writer. Note this writes 'true' as '1' and 'false' as '0'. Not compacted.
+bool binary_file_writer_write_bool(bool data, binary_file_writer* writer)
+{
+	if (writer->capacity - writer->used < (i64)sizeof(bool) && !binary_file_writer_reserve(sizeof(bool), writer))
+		return false; // Something went wrong while trying to write the data
+
+	memcpy(writer->buffer + writer->used, &data, sizeof(bool));
+	writer->used += sizeof(bool);
+
+	return true; // Success
+}
+// Write 'byte'(s) data to a buffered writer. Blocks larger than the buffer are written straight to the file.
+bool binary_file_writer_write_byte(byte* data, i64 length, binary_file_writer* writer)
+{
+	if (!binary_file_writer_reserve(length, writer))
+	{
+		// Too large for the buffer. The buffer was flushed by the reserve so the order is kept.
+		if (writer->used != 0)
+			return false; // Something went wrong while trying to write the data
+
+		return binary_file_write_byte(data, length, writer->file);
+	}
+
+	memcpy(writer->buffer + writer->used, data, length);
+	writer->used += length;
+
+	return true; // Success
+}
+// Write 'str' data (with the null terminator) to a buffered writer
+bool binary_file_writer_write_str(str text, binary_file_writer* writer)
+{
+	return binary_file_writer_write_byte(text, strlen((const char*)text) + 1, writer);
+}
+// Write 'elements'(s) data to a buffered writer
+bool binary_file_writer_write_elements(void* data, i64 size, i64 count, binary_file_writer* writer)
+{
+	return binary_file_writer_write_byte((byte*)data, size * count, writer);
+}
+// Write the pending data of a buffered writer to the file
+bool binary_file_writer_flush(binary_file_writer* writer)
+{
+	if (writer->used == 0)
+		return true; // Nothing to write
+
+	BINARY_FILE_STATS_TIME(start);
+	if (!binary_file_write_byte(writer->buffer, writer->used, writer->file))
+		return false; // Something went wrong while trying to write the data
+	BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_FLUSH, writer->used, writer->used, start, writer->file);
+
+	writer->used = 0;
+
+	return true; // Success
+}
+// Flush and free a buffered writer. Note: The binary file itself is not closed.
+bool binary_file_writer_close(binary_file_writer* writer)
+{
+	if (writer == NULL)
+		return false;
+
+	bool flushed = binary_file_writer_flush(writer);
+
+	free(writer->buffer);
+	free(writer);
+
+	return flushed;
+}
+
+//
+// Implementations: Read-ahead binary file reader
+//
+// Note: The reader keeps two page aligned windows. While the caller reads from one, the prefetch thread fills the other
+//       with the bytes the caller is expected to read next, and the operating system is asked to read the window after that.
+//       When the caller seeks forward by the same distance at least twice in a row (a stride), only the pages read after each
+//       seek are read, and the operating system is asked for the pages a few strides ahead instead of the following window.
+//
+
+#define BINARY_FILE_READER_IDLE 0
+#define BINARY_FILE_READER_PENDING 1
+#define BINARY_FILE_READER_READY 2
+#define BINARY_FILE_READER_STRIDE_GAP (4 * BINARY_FILE_READER_ALIGNMENT)	// Smaller gaps are read through, as part of a window
+#define BINARY_FILE_READER_STRIDES_AHEAD 4					// Strided reads are hinted this many strides ahead
+
+// Prefetch thread of a read-ahead reader: fills the prefetch window while the caller reads from the current one
+void binary_file_reader_prefetcher(void* argument)
+{
+	binary_file_reader* reader = (binary_file_reader*)argument;
+
+	binary_file_platform_mutex_lock(&reader->mutex);
+	for (;;)
+	{
+		while (reader->prefetch_state != BINARY_FILE_READER_PENDING && !reader->stopping)
+			binary_file_platform_condition_wait(&reader->prefetch_changed, &reader->mutex);
+		if (reader->stopping)
+			break;
+		binary_file_platform_mutex_unlock(&reader->mutex);
+
+		i64 used = binary_file_platform_pread(reader->prefetch, reader->prefetch_length, reader->prefetch_offset, reader->file);
+
+		binary_file_platform_mutex_lock(&reader->mutex);
+		reader->prefetch_used = used;
+		reader->prefetch_state = BINARY_FILE_READER_READY;
+		binary_file_platform_condition_broadcast(&reader->prefetch_changed);
+	}
+	binary_file_platform_mutex_unlock(&reader->mutex);
+}
+// Check if the caller is seeking forward by the same distance, skipping at least BINARY_FILE_READER_STRIDE_GAP bytes each time
+bool binary_file_reader_is_strided(binary_file_reader* reader)
+{
+	return (reader->stride_hits >= 2 && reader->stride - reader->stride_read >= BINARY_FILE_READER_STRIDE_GAP);
+}
+// Get the page aligned range of a read of 'length' bytes at 'position', at most one window long
+void binary_file_reader_align(file_size position, i64 length, file_size* offset, i64* aligned_length, binary_file_reader* reader)
+{
+	*offset = position & ~(file_size)(BINARY_FILE_READER_ALIGNMENT - 1);
+	*aligned_length = (position - *offset + ((length > 0) ? length : 1) + BINARY_FILE_READER_ALIGNMENT - 1) & ~(i64)(BINARY_FILE_READER_ALIGNMENT - 1);
+	if (*aligned_length > reader->window_size)
+		*aligned_length = reader->window_size;
+}
+// Make the current window hold 'position', from the prefetch window if it does, then start prefetching the next one. Returns false at the end of the file or on failure.
+bool binary_file_reader_fill(file_size position, binary_file_reader* reader)
+{
+	bool prefetched = false;
+	binary_file_platform_mutex_lock(&reader->mutex);
+	while (reader->prefetch_state == BINARY_FILE_READER_PENDING)
+		binary_file_platform_condition_wait(&reader->prefetch_changed, &reader->mutex);
+	if (reader->prefetch_state == BINARY_FILE_READER_READY)
+	{
+		if (position >= reader->prefetch_offset && position < reader->prefetch_offset + reader->prefetch_used)
+		{
+			byte* window = reader->window;
+			reader->window = reader->prefetch;
+			reader->window_offset = reader->prefetch_offset;
+			reader->window_used = reader->prefetch_used;
+			reader->prefetch = window;
+			prefetched = true;
+		}
+		reader->prefetch_state = BINARY_FILE_READER_IDLE;
+	}
+	binary_file_platform_mutex_unlock(&reader->mutex);
+
+	bool strided = binary_file_reader_is_strided(reader);
+	if (!prefetched)
+	{
+		file_size offset;
+		i64 length;
+		binary_file_reader_align(position, strided ? reader->stride_read : reader->window_size, &offset, &length, reader);
+		i64 used = binary_file_platform_pread(reader->window, length, offset, reader->file);
+		reader->window_offset = offset;
+		reader->window_used = (used > 0) ? used : 0;
+		if (position >= offset + reader->window_used)
+			return false; // End of the file, or something went wrong while trying to read the data
+	}
+
+	if (strided)
+	{
+		// Only hint: a strided read is too small to be worth a hand-off to the prefetch thread
+		file_size ahead;
+		i64 ahead_length;
+		binary_file_reader_align(reader->seek_target + BINARY_FILE_READER_STRIDES_AHEAD * reader->stride, reader->stride_read, &ahead, &ahead_length, reader);
+		if (ahead < reader->length)
+			binary_file_platform_prefetch(ahead, ahead_length, reader->file);
+		return true; // Success
+	}
+
+	// Prefetch the next window, and hint at the window after that
+	file_size next = reader->window_offset + reader->window_used;
+	i64 next_length = reader->window_size;
+	file_size ahead = next + next_length;
+	if (next >= reader->length)
+		return true; // Nothing more to prefetch
+
+	binary_file_platform_mutex_lock(&reader->mutex);
+	reader->prefetch_offset = next;
+	reader->prefetch_length = next_length;
+	reader->prefetch_state = BINARY_FILE_READER_PENDING;
+	binary_file_platform_condition_signal(&reader->prefetch_changed);
+	binary_file_platform_mutex_unlock(&reader->mutex);
+	if (ahead < reader->length)
+		binary_file_platform_prefetch(ahead, next_length, reader->file);
+
+	return true; // Success
+}
+// Create a read-ahead reader on top of an open binary file, reading 'window_size' bytes at a time (rounded up to a page, 0 = BINARY_FILE_READER_WINDOW_SIZE).
+// The reader starts at the beginning of the file and does not use or move the file position. Returns NULL if out of memory.
+binary_file_reader* binary_file_reader_open(binary_file file, i64 window_size)
+{
+	if (file == NULL || window_size < 0)
+		return NULL;
+	if (window_size == 0)
+		window_size = BINARY_FILE_READER_WINDOW_SIZE;
+	window_size = (window_size + BINARY_FILE_READER_ALIGNMENT - 1) & ~(i64)(BINARY_FILE_READER_ALIGNMENT - 1);
+
+	binary_file_reader* reader = (binary_file_reader*)calloc(1, sizeof(binary_file_reader));
+	if (reader == NULL)
+		return NULL; // Out of memory
+	reader->file = file;
+	reader->length = binary_file_get_open_length(file);
+	reader->window_size = window_size;
+	reader->window = (byte*)binary_file_platform_aligned_alloc(window_size, BINARY_FILE_READER_ALIGNMENT);
+	reader->prefetch = (byte*)binary_file_platform_aligned_alloc(window_size, BINARY_FILE_READER_ALIGNMENT);
+	binary_file_platform_mutex_init(&reader->mutex);
+	binary_file_platform_condition_init(&reader->prefetch_changed);
+
+	if (reader->window == NULL || reader->prefetch == NULL || !binary_file_platform_thread_start(&reader->prefetcher, binary_file_reader_prefetcher, reader))
+	{
+		binary_file_platform_condition_destroy(&reader->prefetch_changed);
+		binary_file_platform_mutex_destroy(&reader->mutex);
+		binary_file_platform_aligned_free(reader->prefetch);
+		binary_file_platform_aligned_free(reader->window);
+		free(reader);
+		return NULL;
+	}
+	binary_file_platform_advise_sequential(file);
+
+	return reader;
+}
+// Read 'i8' data from a read-ahead reader
+bool binary_file_reader_read_i8(i8* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(i8) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(i8), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(i8));
+	reader->position += sizeof(i8);
+	reader->seek_read += sizeof(i8);
+
+	return true; // Success
+}
+// Read 'i16' data from a read-ahead reader
+bool binary_file_reader_read_i16(i16* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(i16) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(i16), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(i16));
+	reader->position += sizeof(i16);
+	reader->seek_read += sizeof(i16);
+
+	return true; // Success
+}
+// Read 'i32' data from a read-ahead reader
+bool binary_file_reader_read_i32(i32* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(i32) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(i32), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(i32));
+	reader->position += sizeof(i32);
+	reader->seek_read += sizeof(i32);
+
+	return true; // Success
+}
+// Read 'i64' data from a read-ahead reader
+bool binary_file_reader_read_i64(i64* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(i64) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(i64), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(i64));
+	reader->position += sizeof(i64);
+	reader->seek_read += sizeof(i64);
+
+	return true; // Success
+}
+// Read 'u8' data from a read-ahead reader
+bool binary_file_reader_read_u8(u8* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(u8) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(u8), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(u8));
+	reader->position += sizeof(u8);
+	reader->seek_read += sizeof(u8);
+
+	return true; // Success
+}
+// Read 'u16' data from a read-ahead reader
+bool binary_file_reader_read_u16(u16* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(u16) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(u16), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(u16));
+	reader->position += sizeof(u16);
+	reader->seek_read += sizeof(u16);
+
+	return true; // Success
+}
+// Read 'u32' data from a read-ahead reader
+bool binary_file_reader_read_u32(u32* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(u32) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(u32), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(u32));
+	reader->position += sizeof(u32);
+	reader->seek_read += sizeof(u32);
+
+	return true; // Success
+}
+// Read 'u64' data from a read-ahead reader
+bool binary_file_reader_read_u64(u64* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(u64) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(u64), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(u64));
+	reader->position += sizeof(u64);
+	reader->seek_read += sizeof(u64);
+
+	return true; // Success
+}
+// Read 'f32' data from a read-ahead reader
+bool binary_file_reader_read_f32(f32* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(f32) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(f32), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(f32));
+	reader->position += sizeof(f32);
+	reader->seek_read += sizeof(f32);
+
+	return true; // Success
+}
+// Read 'f64' data from a read-ahead reader
+bool binary_file_reader_read_f64(f64* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(f64) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(f64), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(f64));
+	reader->position += sizeof(f64);
+	reader->seek_read += sizeof(f64);
+
+	return true; // Success
+}
+// Read 'bool' data from a read-ahead reader
+bool binary_file_reader_read_bool(bool* data, binary_file_reader* reader)
+{
+	i64 start = reader->position - reader->window_offset;
+	if (start < 0 || start + (i64)sizeof(bool) > reader->window_used)
+		return binary_file_reader_read_byte((byte*)data, sizeof(bool), reader); // Not in the current window
+
+	memcpy(data, reader->window + start, sizeof(bool));
+	reader->position += sizeof(bool);
+	reader->seek_read += sizeof(bool);
+
+	return true; // Success
+}
+// Read 'byte'(s) data from a read-ahead reader
+bool binary_file_reader_read_byte(byte* data, i64 length, binary_file_reader* reader)
+{
+	reader->seek_read += length;
+	while (length > 0)
+	{
+		i64 start = reader->position - reader->window_offset;
+		if (start < 0 || start >= reader->window_used)
+		{
+			if (!binary_file_reader_fill(reader->position, reader))
+				return false; // Something went wrong while trying to read the data
+			start = reader->position - reader->window_offset;
+		}
+
+		i64 chunk = reader->window_used - start;
+		if (chunk > length)
+			chunk = length;
+		memcpy(data, reader->window + start, chunk);
+		data += chunk;
+		length -= chunk;
+		reader->position += chunk;
+	}
+
+	return true; // Success
+}
+// Read elements data from a read-ahead reader
+bool binary_file_reader_read_elements(void* data, i64 size, i64 count, binary_file_reader* reader)
+{
+	return binary_file_reader_read_byte((byte*)data, size * count, reader);
+}
+// Set the position of a read-ahead reader. Forward seeks by the same distance are detected as a stride.
+bool binary_file_reader_set_position(file_size position, binary_file_reader* reader)
+{
+	if (position < 0)
+		return false; // Invalid position
+
+	if (position > reader->seek_target && position - reader->seek_target == reader->stride)
+		reader->stride_hits++;
+	else
+	{
+		reader->stride = (position > reader->seek_target) ? position - reader->seek_target : 0;
+		reader->stride_hits = 1;
+	}
+	reader->stride_read = reader->seek_read;
+	reader->seek_read = 0;
+	reader->seek_target = position;
+	reader->position = position;
+
+	return true; // Success
+}
+// Move the position of a read-ahead reader relative to the current position
+bool binary_file_reader_set_position_relative(file_size position, binary_file_reader* reader)
+{
+	return binary_file_reader_set_position(reader->position + position, reader);
+}
+// Get the position of a read-ahead reader
+file_size binary_file_reader_get_position(binary_file_reader* reader)
+{
+	return reader->position;
+}
+// Stop the prefetch thread and free the read-ahead reader. Does not close the file.
+void binary_file_reader_close(binary_file_reader* reader)
+{
+	if (reader == NULL)
+		return;
+
+	binary_file_platform_mutex_lock(&reader->mutex);
+	reader->stopping = true;
+	binary_file_platform_condition_signal(&reader->prefetch_changed);
+	binary_file_platform_mutex_unlock(&reader->mutex);
+	binary_file_platform_thread_join(reader->prefetcher);
+
+	binary_file_platform_condition_destroy(&reader->prefetch_changed);
+	binary_file_platform_mutex_destroy(&reader->mutex);
+	binary_file_platform_aligned_free(reader->prefetch);
+	binary_file_platform_aligned_free(reader->window);
+	free(reader);
+}
+
+//
+// Implementations: Columnar binary file
+//
+// Note: A columnar file looks like this (all numbers little-endian):
+//         Header:   u32 magic "BFCL", u32 version
+//         Chunks:   for every group of 'group rows' rows, the values of column 0, then column 1, ... (each chunk is one column's values back to back,
+//                   starting at a multiple of BINARY_FILE_COLUMN_ALIGNMENT bytes)
+//         Footer:   u32 column count, u64 group rows, u64 row count, u64 element size of each column, u64 file offset of each chunk (group by group)
+//         Trailer:  u64 footer offset, u32 magic "BFCL"
+//       A scan of a few columns only reads their chunks, the other columns are never touched.
+//
+
+#define BINARY_FILE_COLUMN_MAGIC 0x4C434642u			// "BFCL"
+#define BINARY_FILE_COLUMN_VERSION 1
+#define BINARY_FILE_COLUMN_TRAILER_SIZE (8 + 4)
+
+// Open a columnar file for writing (truncate mode). Every column holds values of 'element_sizes[column]' bytes.
+// Rows are buffered and written as one chunk per column every 'group_rows' rows (0 = BINARY_FILE_COLUMN_GROUP_ROWS). Returns NULL on failure.
+binary_file_column_writer* binary_file_column_writer_open(str filename, i32 column_count, const i64* element_sizes, i64 group_rows)
+{
+	if (column_count <= 0)
+		return NULL; // No columns
+	if (group_rows <= 0)
+		group_rows = BINARY_FILE_COLUMN_GROUP_ROWS;
+
+	binary_file_column_writer* writer = (binary_file_column_writer*)calloc(1, sizeof(binary_file_column_writer));
+	if (writer == NULL)
+		return NULL;
+	writer->column_count = column_count;
+	writer->group_rows = group_rows;
+	writer->element_sizes = (i64*)malloc(column_count * sizeof(i64));
+	writer->buffers = (byte**)calloc(column_count, sizeof(byte*));
+	bool ok = (writer->element_sizes != NULL && writer->buffers != NULL);
+	for (i32 i = 0; ok && i < column_count; i++)
+	{
+		writer->element_sizes[i] = element_sizes[i];
+		writer->buffers[i] = (byte*)malloc(group_rows * element_sizes[i]);
+		ok = (element_sizes[i] > 0 && writer->buffers[i] != NULL);
+	}
+
+	if (ok)
+		writer->file = binary_file_openfor_write_new(filename);
+	if (!ok || writer->file == NULL || !binary_file_write_u32_le(BINARY_FILE_COLUMN_MAGIC, writer->file) || !binary_file_write_u32_le(BINARY_FILE_COLUMN_VERSION, writer->file))
+	{
+		if (writer->file != NULL)
+			binary_file_close(writer->file);
+		for (i32 i = 0; writer->buffers != NULL && i < column_count; i++)
+			free(writer->buffers[i]);
+		free(writer->buffers);
+		free(writer->element_sizes);
+		free(writer);
+		return NULL;
+	}
+
+	return writer;
+}
+// Write the buffered rows of a columnar file as one chunk per column
+bool binary_file_column_writer_flush_group(binary_file_column_writer* writer)
+{
+	if (writer->failed)
+		return false; // An earlier chunk could not be written
+	if (writer->used_rows == 0)
+		return true; // Nothing to write
+
+	// The buffers stay full after a failure, so the writer takes no more rows
+	writer->failed = true;
+
+	if (writer->group_count == writer->group_capacity)
+	{
+		i64 capacity = (writer->group_capacity == 0) ? 16 : writer->group_capacity * 2;
+		u64* offsets = (u64*)realloc(writer->offsets, capacity * writer->column_count * sizeof(u64));
+		if (offsets == NULL)
+			return false; // Out of memory
+		writer->offsets = offsets;
+		writer->group_capacity = capacity;
+	}
+
+	for (i32 i = 0; i < writer->column_count; i++)
+	{
+		file_size offset = binary_file_platform_tell(writer->file);
+		if (offset < 0)
+			return false; // Failure
+
+		// Pad so the chunk starts aligned
+		byte padding[BINARY_FILE_COLUMN_ALIGNMENT] = { 0 };
+		i64 pad = (BINARY_FILE_COLUMN_ALIGNMENT - offset % BINARY_FILE_COLUMN_ALIGNMENT) % BINARY_FILE_COLUMN_ALIGNMENT;
+		if ((pad > 0 && !binary_file_write_byte(padding, pad, writer->file))
+			|| !binary_file_write_byte(writer->buffers[i], writer->used_rows * writer->element_sizes[i], writer->file))
+			return false; // Something went wrong while trying to write the data
+		writer->offsets[writer->group_count * writer->column_count + i] = (u64)(offset + pad);
+	}
+
+	writer->group_count++;
+	writer->row_count += writer->used_rows;
+	writer->used_rows = 0;
+	writer->failed = false;
+
+	return true; // Success
+}
+// Write one row to a columnar file. 'values[column]' points to the value of each column.
+bool binary_file_column_writer_write_row(const void* const* values, binary_file_column_writer* writer)
+{
+	if (writer->failed)
+		return false; // An earlier chunk could not be written
+
+	for (i32 i = 0; i < writer->column_count; i++)
+		memcpy(writer->buffers[i] + writer->used_rows * writer->element_sizes[i], values[i], writer->element_sizes[i]);
+	writer->used_rows++;
+
+	if (writer->used_rows == writer->group_rows)
+		return binary_file_column_writer_flush_group(writer);
+
+	return true; // Success
+}
+// Write an array of records (structs) to a columnar file, splitting them into columns. 'field_offsets[column]' is the offset of each column's field in a record.
+bool binary_file_column_writer_write_records(const void* records, i64 record_size, const i64* field_offsets, i64 count, binary_file_column_writer* writer)
+{
+	const byte* record = (const byte*)records;
+	if (writer->failed)
+		return false; // An earlier chunk could not be written
+
+	i64 done = 0;
+	while (done < count)
+	{
+		i64 rows = writer->group_rows - writer->used_rows;
+		if (rows > count - done)
+			rows = count - done;
+
+		// Gather one column at a time, so each buffer is written front to back
+		for (i32 i = 0; i < writer->column_count; i++)
+		{
+			i64 size = writer->element_sizes[i];
+			byte* out = writer->buffers[i] + writer->used_rows * size;
+			const byte* in = record + done * record_size + field_offsets[i];
+			for (i64 j = 0; j < rows; j++)
+				memcpy(out + j * size, in + j * record_size, size);
+		}
+		writer->used_rows += rows;
+		done += rows;
+
+		if (writer->used_rows == writer->group_rows && !binary_file_column_writer_flush_group(writer))
+			return false; // Something went wrong while trying to write the data
+	}
+
+	return true; // Success
+}
+// Write the last rows and the footer of a columnar file, close it and free the writer. Returns false if anything could not be written.
+bool binary_file_column_writer_close(binary_file_column_writer* writer)
+{
+	if (writer == NULL)
+		return false;
+
+	bool ok = binary_file_column_writer_flush_group(writer);
+	file_size footer = binary_file_platform_tell(writer->file);
+	ok = ok && footer >= 0
+		&& binary_file_write_u32_le((u32)writer->column_count, writer->file)
+		&& binary_file_write_u64_le((u64)writer->group_rows, writer->file)
+		&& binary_file_write_u64_le((u64)writer->row_count, writer->file);
+	for (i32 i = 0; ok && i < writer->column_count; i++)
+		ok = binary_file_write_u64_le((u64)writer->element_sizes[i], writer->file);
+	ok = ok && (writer->group_count == 0 || binary_file_write_elements_le(writer->offsets, sizeof(u64), writer->group_count * writer->column_count, writer->file))
+		&& binary_file_write_u64_le((u64)footer, writer->file)
+		&& binary_file_write_u32_le(BINARY_FILE_COLUMN_MAGIC, writer->file);
+	ok = (BINARY_FILE_FCLOSE(writer->file) == 0) && ok;
+
+	for (i32 i = 0; i < writer->column_count; i++)
+		free(writer->buffers[i]);
+	free(writer->buffers);
+	free(writer->element_sizes);
+	free(writer->offsets);
+	free(writer);
+
+	return ok;
+}
+// Read 'length' bytes at 'offset' of a columnar file, from the mapped view or with a positional read
+bool binary_file_column_reader_read_at(void* data, i64 length, file_size offset, binary_file_column_reader* reader)
+{
+	if (reader->map != NULL)
+	{
+		if (offset < 0 || length > reader->map->length || offset > reader->map->length - length)
+			return false; // Outside the file
+		memcpy(data, reader->map->data + offset, length);
+		return true; // Success
+	}
+
+	return binary_file_read_byte_at((byte*)data, length, offset, reader->file);
+}
+// Open a columnar file for reading and load its footer. With 'mapped' the file is memory mapped, otherwise columns are read with positional reads.
+// Returns NULL if the file is not found or is not a columnar file.
+binary_file_column_reader* binary_file_column_reader_open(str filename, bool mapped)
+{
+	binary_file_column_reader* reader = (binary_file_column_reader*)calloc(1, sizeof(binary_file_column_reader));
+	if (reader == NULL)
+		return NULL;
+
+	file_size length;
+	if (mapped)
+	{
+		reader->map = binary_file_mapfor_read(filename);
+		length = (reader->map != NULL) ? reader->map->length : -1;
+	}
+	else
+	{
+		reader->file = binary_file_openfor_read(filename);
+		length = (reader->file != NULL) ? binary_file_get_open_length(reader->file) : -1;
+	}
+
+	// Check the header and the trailer, then read the fixed part of the footer
+	byte header[8], trailer[BINARY_FILE_COLUMN_TRAILER_SIZE], fixed[4 + 8 + 8];
+	u32 magic = 0, trailer_magic = 0, version = 0, column_count = 0;
+	u64 footer = 0, group_rows = 0, row_count = 0;
+	bool ok = length >= (file_size)(sizeof(header) + sizeof(fixed) + sizeof(trailer))
+		&& binary_file_column_reader_read_at(header, sizeof(header), 0, reader)
+		&& binary_file_column_reader_read_at(trailer, sizeof(trailer), length - sizeof(trailer), reader);
+	if (ok)
+	{
+		memcpy(&magic, header, 4);
+		memcpy(&version, header + 4, 4);
+		memcpy(&footer, trailer, 8);
+		memcpy(&trailer_magic, trailer + 8, 4);
+		magic = binary_file_to_le_u32(magic);
+		version = binary_file_to_le_u32(version);
+		footer = binary_file_to_le_u64(footer);
+		trailer_magic = binary_file_to_le_u32(trailer_magic);
+		ok = magic == BINARY_FILE_COLUMN_MAGIC && trailer_magic == BINARY_FILE_COLUMN_MAGIC && version == BINARY_FILE_COLUMN_VERSION
+			&& footer >= sizeof(header) && footer <= (u64)(length - sizeof(trailer) - sizeof(fixed))
+			&& binary_file_column_reader_read_at(fixed, sizeof(fixed), (file_size)footer, reader);
+	}
+	if (ok)
+	{
+		memcpy(&column_count, fixed, 4);
+		memcpy(&group_rows, fixed + 4, 8);
+		memcpy(&row_count, fixed + 12, 8);
+		column_count = binary_file_to_le_u32(column_count);
+		group_rows = binary_file_to_le_u64(group_rows);
+		row_count = binary_file_to_le_u64(row_count);
+		reader->column_count = (i32)column_count;
+		reader->group_rows = (i64)group_rows;
+		reader->row_count = (i64)row_count;
+		reader->group_count = (group_rows > 0) ? (i64)((row_count + group_rows - 1) / group_rows) : 0;
+
+		// The rest of the footer must fit between the fixed part and the trailer
+		u64 room = (u64)(length - sizeof(trailer)) - footer - sizeof(fixed);
+		ok = column_count > 0 && group_rows > 0 && column_count <= room / sizeof(u64)
+			&& (u64)reader->group_count <= (room / sizeof(u64) - column_count) / column_count;
+	}
+	if (ok)
+	{
+		i64 offset_count = reader->group_count * reader->column_count;
+		reader->element_sizes = (i64*)malloc(column_count * sizeof(i64));
+		reader->offsets = (u64*)malloc((offset_count > 0 ? offset_count : 1) * sizeof(u64));
+		ok = reader->element_sizes != NULL && reader->offsets != NULL
+			&& binary_file_column_reader_read_at(reader->element_sizes, column_count * sizeof(i64), (file_size)footer + sizeof(fixed), reader)
+			&& binary_file_column_reader_read_at(reader->offsets, offset_count * sizeof(u64), (file_size)footer + sizeof(fixed) + column_count * sizeof(i64), reader);
+		if (ok)
+		{
+#ifndef BINARY_FILE_LITTLE_ENDIAN
+			binary_file_swap_elements(reader->element_sizes, reader->element_sizes, sizeof(i64), column_count);
+			binary_file_swap_elements(reader->offsets, reader->offsets, sizeof(u64), offset_count);
+#endif
+			for (i32 i = 0; ok && i < reader->column_count; i++)
+				ok = reader->element_sizes[i] > 0;
+		}
+	}
+
+	if (!ok)
+	{
+		binary_file_column_reader_close(reader);
+		return NULL; // Not found, or not a columnar file
+	}
+
+	return reader;
+}
+// Get the number of rows in a columnar file
+i64 binary_file_column_reader_get_row_count(binary_file_column_reader* reader)
+{
+	return reader->row_count;
+}
+// Get the number of columns in a columnar file
+i32 binary_file_column_reader_get_column_count(binary_file_column_reader* reader)
+{
+	return reader->column_count;
+}
+// Get the size of one value of a column, or -1 if there is no such column
+i64 binary_file_column_reader_get_element_size(i32 column, binary_file_column_reader* reader)
+{
+	if (column < 0 || column >= reader->column_count)
+		return -1; // No such column
+
+	return reader->element_sizes[column];
+}
+// Read 'count' values of one column from row 'first_row' on. Only the chunks of that column that hold the rows are read.
+bool binary_file_column_reader_read(void* data, i32 column, i64 first_row, i64 count, binary_file_column_reader* reader)
+{
+	if (column < 0 || column >= reader->column_count || first_row < 0 || count < 0 || count > reader->row_count - first_row)
+		return false; // No such column or rows
+
+	i64 size = reader->element_sizes[column];
+	byte* out = (byte*)data;
+	while (count > 0)
+	{
+		i64 group = first_row / reader->group_rows;
+		i64 start = first_row - group * reader->group_rows;
+		i64 rows = reader->group_rows - start;
+		if (rows > count)
+			rows = count;
+
+		file_size offset = (file_size)reader->offsets[group * reader->column_count + column] + start * size;
+		if (!binary_file_column_reader_read_at(out, rows * size, offset, reader))
+			return false; // Something went wrong while trying to read the data
+
+		out += rows * size;
+		first_row += rows;
+		count -= rows;
+	}
+
+	return true; // Success
+}
+// Get the values of one column in the chunk holding 'row' without copying. Sets 'row_count' to the rows in the chunk from 'row' on.
+// Returns NULL if the reader is not mapped or there is no such column or row.
+const void* binary_file_column_reader_get_chunk(i32 column, i64 row, i64* row_count, binary_file_column_reader* reader)
+{
+	if (reader->map == NULL || column < 0 || column >= reader->column_count || row < 0 || row >= reader->row_count)
+		return NULL; // Not mapped, or no such column or row
+
+	i64 group = row / reader->group_rows;
+	i64 start = row - group * reader->group_rows;
+	i64 rows = ((group == reader->group_count - 1) ? reader->row_count - group * reader->group_rows : reader->group_rows) - start;
+	file_size offset = (file_size)reader->offsets[group * reader->column_count + column] + start * reader->element_sizes[column];
+	if (offset < 0 || offset > reader->map->length || rows * reader->element_sizes[column] > reader->map->length - offset)
+		return NULL; // Corrupt
+
+	*row_count = rows;
+	return reader->map->data + offset;
+}
+// Close a columnar file and free the reader
+void binary_file_column_reader_close(binary_file_column_reader* reader)
+{
+	if (reader == NULL)
+		return;
+
+	if (reader->map != NULL)
+		binary_file_map_close(reader->map);
+	if (reader->file != NULL)
+		binary_file_close(reader->file);
+	free(reader->element_sizes);
+	free(reader->offsets);
+	free(reader);
+}
+
+//
+// Implementations: Record file
+//
+// Note: A record file looks like this (all numbers little-endian):
+//         Header:   u32 magic "BFRC", u32 version
+//         Records:  u32 length, the record bytes
+//         Index:    u64 offset of every record's length prefix
+//         Trailer:  u64 record count, u32 magic "BFRI"
+//       The index is written on close. A file without one (the writer did not get to close it) is scanned on open,
+//       and binary_file_record_file_rebuild_index(..) scans it once and appends the index, cutting off a torn last record.
+//
+
+#define BINARY_FILE_RECORD_MAGIC 0x43524642u			// "BFRC"
+#define BINARY_FILE_RECORD_INDEX_MAGIC 0x49524642u	// "BFRI"
+#define BINARY_FILE_RECORD_VERSION 1
+#define BINARY_FILE_RECORD_HEADER_SIZE 8
+#define BINARY_FILE_RECORD_TRAILER_SIZE (8 + 4)
+#define BINARY_FILE_RECORD_SCAN_SLICE (8 * 1024 * 1024)	// Bytes each thread reads per step of an index rebuild
+#define BINARY_FILE_RECORD_BATCH_GAP 4096					// Batch reads merge records less than this apart into one read
+
+// Open a record file for writing (truncate mode). Returns NULL on failure.
+binary_file_record_writer* binary_file_record_writer_open(str filename)
+{
+	binary_file_record_writer* writer = (binary_file_record_writer*)calloc(1, sizeof(binary_file_record_writer));
+	if (writer == NULL)
+		return NULL;
+
+	writer->file = binary_file_openfor_write_new(filename);
+	if (writer->file == NULL || !binary_file_write_u32_le(BINARY_FILE_RECORD_MAGIC, writer->file) || !binary_file_write_u32_le(BINARY_FILE_RECORD_VERSION, writer->file))
+	{
+		if (writer->file != NULL)
+			binary_file_close(writer->file);
+		free(writer);
+		return NULL;
+	}
+	writer->position = BINARY_FILE_RECORD_HEADER_SIZE;
+
+	return writer;
+}
+// Append one record of 'length' bytes (less than 4GB) to a record file
+bool binary_file_record_writer_append(const void* data, i64 length, binary_file_record_writer* writer)
+{
+	if (length < 0 || length > (i64)UINT32_MAX)
+		return false; // Record too large
+
+	if (writer->count == writer->capacity)
+	{
+		i64 capacity = (writer->capacity == 0) ? 1024 : writer->capacity * 2;
+		u64* offsets = (u64*)realloc(writer->offsets, capacity * sizeof(u64));
+		if (offsets == NULL)
+			return false; // Out of memory
+		writer->offsets = offsets;
+		writer->capacity = capacity;
+	}
+
+	if (!binary_file_write_u32_le((u32)length, writer->file) || (length > 0 && !binary_file_write_byte((byte*)data, length, writer->file)))
+		return false; // Something went wrong while trying to write the data
+
+	writer->offsets[writer->count++] = (u64)writer->position;
+	writer->position += sizeof(u32) + length;
+
+	return true; // Success
+}
+// Get the number of records appended so far
+i64 binary_file_record_writer_get_count(binary_file_record_writer* writer)
+{
+	return writer->count;
+}
+// Write the index of a record file, close it and free the writer. Returns false if anything could not be written.
+bool binary_file_record_writer_close(binary_file_record_writer* writer)
+{
+	if (writer == NULL)
+		return false;
+
+	bool ok = (writer->count == 0 || binary_file_write_elements_le(writer->offsets, sizeof(u64), writer->count, writer->file))
+		&& binary_file_write_u64_le((u64)writer->count, writer->file)
+		&& binary_file_write_u32_le(BINARY_FILE_RECORD_INDEX_MAGIC, writer->file);
+	ok = (BINARY_FILE_FCLOSE(writer->file) == 0) && ok;
+
+	free(writer->offsets);
+	free(writer);
+
+	return ok;
+}
+// Load the index at the end of a record file. Returns false if there is no valid index.
+bool binary_file_record_load_index(file_size length, binary_file_record_file* records)
+{
+	u64 count;
+	u32 magic;
+	if (length < BINARY_FILE_RECORD_HEADER_SIZE + BINARY_FILE_RECORD_TRAILER_SIZE
+		|| !binary_file_read_u64_at(&count, length - BINARY_FILE_RECORD_TRAILER_SIZE, records->file)
+		|| !binary_file_read_u32_at(&magic, length - sizeof(u32), records->file))
+		return false; // No trailer
+	count = binary_file_to_le_u64(count);
+	if (binary_file_to_le_u32(magic) != BINARY_FILE_RECORD_INDEX_MAGIC
+		|| count > (u64)(length - BINARY_FILE_RECORD_HEADER_SIZE - BINARY_FILE_RECORD_TRAILER_SIZE) / (sizeof(u64) + sizeof(u32)))
+		return false; // No index
+
+	file_size data_end = length - BINARY_FILE_RECORD_TRAILER_SIZE - (file_size)count * sizeof(u64);
+	u64* offsets = (u64*)malloc((count > 0 ? count : 1) * sizeof(u64));
+	if (offsets == NULL || !binary_file_read_byte_at((byte*)offsets, (i64)count * sizeof(u64), data_end, records->file))
+	{
+		free(offsets);
+		return false; // Out of memory, or something went wrong while trying to read the data
+	}
+
+	// The records must follow each other inside the data
+	u64 expected = BINARY_FILE_RECORD_HEADER_SIZE;
+	for (u64 i = 0; i < count; i++)
+	{
+		offsets[i] = binary_file_to_le_u64(offsets[i]);
+		if (offsets[i] < expected || offsets[i] + sizeof(u32) > (u64)data_end)
+		{
+			free(offsets);
+			return false; // Corrupt index
+		}
+		expected = offsets[i] + sizeof(u32);
+	}
+
+	records->offsets = offsets;
+	records->count = (i64)count;
+	records->data_end = data_end;
+
+	return true; // Success
+}
+// Thread pool task of an index rebuild: read one slice of the file
+void binary_file_record_read_slice(void* argument)
+{
+	binary_file_record_slice* slice = (binary_file_record_slice*)argument;
+	slice->ok = binary_file_read_byte_at(slice->data, slice->length, slice->offset, slice->file);
+}
+// Find every record from the header up to 'end' by following the length prefixes. Stops at a record that runs past 'end' (a torn tail).
+// The file is read in windows of one slice per thread, read in parallel; records larger than a window are jumped over without reading them.
+bool binary_file_record_scan(file_size end, i32 thread_count, binary_file_record_file* records)
+{
+	if (thread_count <= 0)
+		thread_count = binary_file_platform_get_cpu_count();
+	i64 window = (i64)thread_count * BINARY_FILE_RECORD_SCAN_SLICE;
+
+	byte* buffer = (byte*)malloc(window);
+	binary_file_record_slice* slices = (binary_file_record_slice*)calloc(thread_count, sizeof(binary_file_record_slice));
+	binary_file_thread_pool* pool = (thread_count > 1) ? binary_file_thread_pool_create(thread_count) : NULL;
+	i64 capacity = 1024;
+	u64* offsets = (u64*)malloc(capacity * sizeof(u64));
+	bool ok = (buffer != NULL && slices != NULL && offsets != NULL);
+
+	i64 count = 0;
+	file_size position = BINARY_FILE_RECORD_HEADER_SIZE;
+	while (ok && position + (file_size)sizeof(u32) <= end)
+	{
+		// Read the next window, one slice per thread
+		i64 length = (end - position < window) ? (i64)(end - position) : window;
+		i64 slice_count = (length + BINARY_FILE_RECORD_SCAN_SLICE - 1) / BINARY_FILE_RECORD_SCAN_SLICE;
+		for (i64 i = 0; i < slice_count; i++)
+		{
+			binary_file_record_slice* slice = &slices[i];
+			slice->file = records->file;
+			slice->data = buffer + i * BINARY_FILE_RECORD_SCAN_SLICE;
+			slice->offset = position + i * BINARY_FILE_RECORD_SCAN_SLICE;
+			slice->length = (length - i * BINARY_FILE_RECORD_SCAN_SLICE < BINARY_FILE_RECORD_SCAN_SLICE) ? length - i * BINARY_FILE_RECORD_SCAN_SLICE : BINARY_FILE_RECORD_SCAN_SLICE;
+			if (pool == NULL || !binary_file_thread_pool_submit(binary_file_record_read_slice, slice, pool))
+				binary_file_record_read_slice(slice); // Read on this thread instead
+		}
+		if (pool != NULL)
+			binary_file_thread_pool_wait(pool);
+		for (i64 i = 0; i < slice_count; i++)
+			ok = ok && slices[i].ok;
+		if (!ok)
+			break; // Something went wrong while trying to read the data
+
+		// Follow the length prefixes through the window
+		i64 at = 0;
+		while (at + (i64)sizeof(u32) <= length)
+		{
+			u32 record_length;
+			memcpy(&record_length, buffer + at, sizeof(u32));
+			record_length = binary_file_to_le_u32(record_length);
+			if (position + at + (file_size)sizeof(u32) + record_length > end)
+			{
+				end = position + at; // Torn tail: the last record is not complete
+				break;
+			}
+
+			if (count == capacity)
+			{
+				u64* grown = (u64*)realloc(offsets, capacity * 2 * sizeof(u64));
+				if (grown == NULL)
+				{
+					ok = false;
+					break; // Out of memory
+				}
+				offsets = grown;
+				capacity *= 2;
+			}
+			offsets[count++] = (u64)(position + at);
+			at += sizeof(u32) + record_length;
+		}
+		position += at; // The next window starts at the first record not found yet
+	}
+
+	if (pool != NULL)
+		binary_file_thread_pool_destroy(pool);
+	free(slices);
+	free(buffer);
+	if (!ok)
+	{
+		free(offsets);
+		return false;
+	}
+
+	records->offsets = offsets;
+	records->count = count;
+	records->data_end = (count > 0) ? (file_size)offsets[count - 1] + sizeof(u32) + binary_file_record_file_get_length(count - 1, records) : BINARY_FILE_RECORD_HEADER_SIZE;
+
+	return true; // Success
+}
+// Open a record file for reading. Loads the index, or scans the records if the file has no index. Returns NULL if the file is not found or is not a record file.
+binary_file_record_file* binary_file_record_file_open(str filename)
+{
+	binary_file_record_file* records = (binary_file_record_file*)calloc(1, sizeof(binary_file_record_file));
+	if (records == NULL)
+		return NULL;
+
+	records->file = binary_file_openfor_read(filename);
+	u32 magic = 0, version = 0;
+	file_size length = (records->file != NULL) ? binary_file_get_open_length(records->file) : -1;
+	bool ok = length >= BINARY_FILE_RECORD_HEADER_SIZE
+		&& binary_file_read_u32_at(&magic, 0, records->file) && binary_file_read_u32_at(&version, sizeof(u32), records->file)
+		&& binary_file_to_le_u32(magic) == BINARY_FILE_RECORD_MAGIC && binary_file_to_le_u32(version) == BINARY_FILE_RECORD_VERSION;
+	ok = ok && (binary_file_record_load_index(length, records) || binary_file_record_scan(length, 0, records));
+
+	if (!ok)
+	{
+		binary_file_record_file_close(records);
+		return NULL; // Not found, or not a record file
+	}
+
+	return records;
+}
+// Get the number of records in a record file
+i64 binary_file_record_file_get_count(binary_file_record_file* records)
+{
+	return records->count;
+}
+// Get the length of record number 'index', or -1 if there is no such record
+i64 binary_file_record_file_get_length(i64 index, binary_file_record_file* records)
+{
+	if (index < 0 || index >= records->count)
+		return -1; // No such record
+
+	if (index + 1 < records->count)
+		return (i64)(records->offsets[index + 1] - records->offsets[index] - sizeof(u32));
+
+	u32 length;
+	if (!binary_file_read_u32_at(&length, (file_size)records->offsets[index], records->file))
+		return -1; // Something went wrong while trying to read the data
+	return (i64)binary_file_to_le_u32(length);
+}
+// Read record number 'index' into 'data' with one positional read. Returns the length of the record, or -1 if there is no such record or it does not fit in 'capacity'.
+i64 binary_file_record_file_read(void* data, i64 capacity, i64 index, binary_file_record_file* records)
+{
+	i64 length = binary_file_record_file_get_length(index, records);
+	if (length < 0 || length > capacity)
+		return -1; // No such record, or it does not fit
+
+	if (length > 0 && !binary_file_read_byte_at((byte*)data, length, (file_size)records->offsets[index] + sizeof(u32), records->file))
+		return -1; // Something went wrong while trying to read the data
+
+	return length;
+}
+// Read record number 'index' into a new buffer (free it with free()). Sets 'length' to the length of the record. Returns NULL on failure.
+byte* binary_file_record_file_read_new(i64* length, i64 index, binary_file_record_file* records)
+{
+	i64 record_length = binary_file_record_file_get_length(index, records);
+	if (record_length < 0)
+		return NULL; // No such record
+
+	byte* data = (byte*)malloc(record_length > 0 ? record_length : 1);
+	if (data == NULL)
+		return NULL; // Out of memory
+	if (binary_file_record_file_read(data, record_length, index, records) != record_length)
+	{
+		free(data);
+		return NULL; // Something went wrong while trying to read the data
+	}
+
+	*length = record_length;
+	return data;
+}
+// Order batch requests by file offset
+int binary_file_record_compare(const void* a, const void* b)
+{
+	u64 offset_a = ((const binary_file_record_request*)a)->offset;
+	u64 offset_b = ((const binary_file_record_request*)b)->offset;
+	return (offset_a > offset_b) - (offset_a < offset_b);
+}
+// Read many records at once. 'data[i]' gets a new buffer (free it with free()) and 'lengths[i]' the length of record 'indices[i]'.
+// The records are read in file order, and records close to each other are read with one positional read.
+// Returns false if any record could not be read (all buffers are freed and set to NULL then).
+bool binary_file_record_file_read_batch(const i64* indices, i64 count, byte** data, i64* lengths, binary_file_record_file* records)
+{
+	binary_file_record_request* requests = (binary_file_record_request*)malloc((count > 0 ? count : 1) * sizeof(binary_file_record_request));
+	if (requests == NULL)
+		return false; // Out of memory
+
+	bool ok = true;
+	for (i64 i = 0; i < count; i++)
+	{
+		data[i] = NULL;
+		lengths[i] = binary_file_record_file_get_length(indices[i], records);
+		ok = ok && lengths[i] >= 0;
+		requests[i].offset = ok ? records->offsets[indices[i]] : 0;
+		requests[i].slot = i;
+	}
+	if (ok)
+		qsort(requests, count, sizeof(binary_file_record_request), binary_file_record_compare);
+
+	byte* span = NULL;
+	i64 span_capacity = 0;
+	for (i64 first = 0; ok && first < count;)
+	{
+		// Group the following records while the gaps between them are small
+		file_size start = (file_size)requests[first].offset;
+		file_size stop = start + sizeof(u32) + lengths[requests[first].slot];
+		i64 last = first;
+		while (last + 1 < count && (file_size)requests[last + 1].offset <= stop + BINARY_FILE_RECORD_BATCH_GAP)
+		{
+			last++;
+			file_size next = (file_size)requests[last].offset + sizeof(u32) + lengths[requests[last].slot];
+			if (next > stop)
+				stop = next;
+		}
+
+		if (stop - start > span_capacity)
+		{
+			free(span);
+			span_capacity = (i64)(stop - start);
+			span = (byte*)malloc(span_capacity);
+		}
+		ok = (span != NULL) && binary_file_read_byte_at(span, (i64)(stop - start), start, records->file);
+
+		for (i64 i = first; ok && i <= last; i++)
+		{
+			i64 slot = requests[i].slot;
+			data[slot] = (byte*)malloc(lengths[slot] > 0 ? lengths[slot] : 1);
+			ok = (data[slot] != NULL);
+			if (ok)
+				memcpy(data[slot], span + (requests[i].offset - start) + sizeof(u32), lengths[slot]);
+		}
+		first = last + 1;
+	}
+
+	free(span);
+	free(requests);
+	if (!ok)
+	{
+		for (i64 i = 0; i < count; i++)
+		{
+			free(data[i]);
+			data[i] = NULL;
+		}
+	}
+
+	return ok;
+}
+// Scan a record file with 'thread_count' threads reading (0 = one per CPU) and write a fresh index at the end, cutting off a torn last record.
+// Returns the number of records, or -1 on failure.
+i64 binary_file_record_file_rebuild_index(str filename, i32 thread_count)
+{
+	binary_file_record_file records;
+	memset(&records, 0, sizeof(records));
+	records.file = binary_file_openfor_read(filename);
+	if (records.file == NULL)
+		return -1; // Not found
+
+	u32 magic = 0, version = 0;
+	file_size length = binary_file_get_open_length(records.file);
+	bool ok = length >= BINARY_FILE_RECORD_HEADER_SIZE
+		&& binary_file_read_u32_at(&magic, 0, records.file) && binary_file_read_u32_at(&version, sizeof(u32), records.file)
+		&& binary_file_to_le_u32(magic) == BINARY_FILE_RECORD_MAGIC && binary_file_to_le_u32(version) == BINARY_FILE_RECORD_VERSION;
+
+	// A valid index marks where the records end, otherwise scan to the end of the file
+	file_size end = length;
+	if (ok && binary_file_record_load_index(length, &records))
+	{
+		end = records.data_end;
+		free(records.offsets);
+		records.offsets = NULL;
+	}
+	ok = ok && binary_file_record_scan(end, thread_count, &records);
+	binary_file_close(records.file);
+
+	// Replace everything after the records with the new index
+	binary_file file = ok ? fopen((const char*)filename, "r+b") : NULL;
+	ok = (file != NULL) && binary_file_platform_truncate(records.data_end, file)
+		&& binary_file_set_position_end(file)
+		&& binary_file_write_elements_le(records.offsets, sizeof(u64), records.count, file)
+		&& binary_file_write_u64_le((u64)records.count, file)
+		&& binary_file_write_u32_le(BINARY_FILE_RECORD_INDEX_MAGIC, file);
+	if (file != NULL)
+		ok = (BINARY_FILE_FCLOSE(file) == 0) && ok;
+
+	free(records.offsets);
+	return ok ? records.count : -1;
+}
+// Close a record file and free it
+void binary_file_record_file_close(binary_file_record_file* records)
+{
+	if (records == NULL)
+		return;
+
+	if (records->file != NULL)
+		binary_file_close(records->file);
+	free(records->offsets);
+	free(records);
+}
+
+//
+// Implementations: Append log
+//
+// Note: An append log looks like this (all numbers little-endian):
+//         Header:   u32 magic "BFLG", u32 version
+//         Records:  u32 length, u32 CRC32C of the record bytes, the record bytes
+//       Appending threads only copy their framed record into a shared buffer. A flusher thread writes everything waiting
+//       with one write and one fdatasync (a group commit), after waiting up to 'max_delay_us' for more records to join.
+//       On open, the records are checked and the file is cut after the last complete one, so a crash mid-write leaves no torn tail.
+//
+
+#define BINARY_FILE_LOG_MAGIC 0x474C4642u				// "BFLG"
+#define BINARY_FILE_LOG_VERSION 1
+#define BINARY_FILE_LOG_HEADER_SIZE 8
+#define BINARY_FILE_LOG_FRAME_SIZE 8						// Length and CRC32C in front of every record
+
+// CRC32C (Castagnoli) table for the bytewise fallback
+const u32 binary_file_crc32c_table[256] =
+{
+	0x00000000u, 0xF26B8303u, 0xE13B70F7u, 0x1350F3F4u, 0xC79A971Fu, 0x35F1141Cu, 0x26A1E7E8u, 0xD4CA64EBu,
+	0x8AD958CFu, 0x78B2DBCCu, 0x6BE22838u, 0x9989AB3Bu, 0x4D43CFD0u, 0xBF284CD3u, 0xAC78BF27u, 0x5E133C24u,
+	0x105EC76Fu, 0xE235446Cu, 0xF165B798u, 0x030E349Bu, 0xD7C45070u, 0x25AFD373u, 0x36FF2087u, 0xC494A384u,
+	0x9A879FA0u, 0x68EC1CA3u, 0x7BBCEF57u, 0x89D76C54u, 0x5D1D08BFu, 0xAF768BBCu, 0xBC267848u, 0x4E4DFB4Bu,
+	0x20BD8EDEu, 0xD2D60DDDu, 0xC186FE29u, 0x33ED7D2Au, 0xE72719C1u, 0x154C9AC2u, 0x061C6936u, 0xF477EA35u,
+	0xAA64D611u, 0x580F5512u, 0x4B5FA6E6u, 0xB93425E5u, 0x6DFE410Eu, 0x9F95C20Du, 0x8CC531F9u, 0x7EAEB2FAu,
+	0x30E349B1u, 0xC288CAB2u, 0xD1D83946u, 0x23B3BA45u, 0xF779DEAEu, 0x05125DADu, 0x1642AE59u, 0xE4292D5Au,
+	0xBA3A117Eu, 0x4851927Du, 0x5B016189u, 0xA96AE28Au, 0x7DA08661u, 0x8FCB0562u, 0x9C9BF696u, 0x6EF07595u,
+	0x417B1DBCu, 0xB3109EBFu, 0xA0406D4Bu, 0x522BEE48u, 0x86E18AA3u, 0x748A09A0u, 0x67DAFA54u, 0x95B17957u,
+	0xCBA24573u, 0x39C9C670u, 0x2A993584u, 0xD8F2B687u, 0x0C38D26Cu, 0xFE53516Fu, 0xED03A29Bu, 0x1F682198u,
+	0x5125DAD3u, 0xA34E59D0u, 0xB01EAA24u, 0x42752927u, 0x96BF4DCCu, 0x64D4CECFu, 0x77843D3Bu, 0x85EFBE38u,
+	0xDBFC821Cu, 0x2997011Fu, 0x3AC7F2EBu, 0xC8AC71E8u, 0x1C661503u, 0xEE0D9600u, 0xFD5D65F4u, 0x0F36E6F7u,
+	0x61C69362u, 0x93AD1061u, 0x80FDE395u, 0x72966096u, 0xA65C047Du, 0x5437877Eu, 0x4767748Au, 0xB50CF789u,
+	0xEB1FCBADu, 0x197448AEu, 0x0A24BB5Au, 0xF84F3859u, 0x2C855CB2u, 0xDEEEDFB1u, 0xCDBE2C45u, 0x3FD5AF46u,
+	0x7198540Du, 0x83F3D70Eu, 0x90A324FAu, 0x62C8A7F9u, 0xB602C312u, 0x44694011u, 0x5739B3E5u, 0xA55230E6u,
+	0xFB410CC2u, 0x092A8FC1u, 0x1A7A7C35u, 0xE811FF36u, 0x3CDB9BDDu, 0xCEB018DEu, 0xDDE0EB2Au, 0x2F8B6829u,
+	0x82F63B78u, 0x709DB87Bu, 0x63CD4B8Fu, 0x91A6C88Cu, 0x456CAC67u, 0xB7072F64u, 0xA457DC90u, 0x563C5F93u,
+	0x082F63B7u, 0xFA44E0B4u, 0xE9141340u, 0x1B7F9043u, 0xCFB5F4A8u, 0x3DDE77ABu, 0x2E8E845Fu, 0xDCE5075Cu,
+	0x92A8FC17u, 0x60C37F14u, 0x73938CE0u, 0x81F80FE3u, 0x55326B08u, 0xA759E80Bu, 0xB4091BFFu, 0x466298FCu,
+	0x1871A4D8u, 0xEA1A27DBu, 0xF94AD42Fu, 0x0B21572Cu, 0xDFEB33C7u, 0x2D80B0C4u, 0x3ED04330u, 0xCCBBC033u,
+	0xA24BB5A6u, 0x502036A5u, 0x4370C551u, 0xB11B4652u, 0x65D122B9u, 0x97BAA1BAu, 0x84EA524Eu, 0x7681D14Du,
+	0x2892ED69u, 0xDAF96E6Au, 0xC9A99D9Eu, 0x3BC21E9Du, 0xEF087A76u, 0x1D63F975u, 0x0E330A81u, 0xFC588982u,
+	0xB21572C9u, 0x407EF1CAu, 0x532E023Eu, 0xA145813Du, 0x758FE5D6u, 0x87E466D5u, 0x94B49521u, 0x66DF1622u,
+	0x38CC2A06u, 0xCAA7A905u, 0xD9F75AF1u, 0x2B9CD9F2u, 0xFF56BD19u, 0x0D3D3E1Au, 0x1E6DCDEEu, 0xEC064EEDu,
+	0xC38D26C4u, 0x31E6A5C7u, 0x22B65633u, 0xD0DDD530u, 0x0417B1DBu, 0xF67C32D8u, 0xE52CC12Cu, 0x1747422Fu,
+	0x49547E0Bu, 0xBB3FFD08u, 0xA86F0EFCu, 0x5A048DFFu, 0x8ECEE914u, 0x7CA56A17u, 0x6FF599E3u, 0x9D9E1AE0u,
+	0xD3D3E1ABu, 0x21B862A8u, 0x32E8915Cu, 0xC083125Fu, 0x144976B4u, 0xE622F5B7u, 0xF5720643u, 0x07198540u,
+	0x590AB964u, 0xAB613A67u, 0xB831C993u, 0x4A5A4A90u, 0x9E902E7Bu, 0x6CFBAD78u, 0x7FAB5E8Cu, 0x8DC0DD8Fu,
+	0xE330A81Au, 0x115B2B19u, 0x020BD8EDu, 0xF0605BEEu, 0x24AA3F05u, 0xD6C1BC06u, 0xC5914FF2u, 0x37FACCF1u,
+	0x69E9F0D5u, 0x9B8273D6u, 0x88D28022u, 0x7AB90321u, 0xAE7367CAu, 0x5C18E4C9u, 0x4F48173Du, 0xBD23943Eu,
+	0xF36E6F75u, 0x0105EC76u, 0x12551F82u, 0xE03E9C81u, 0x34F4F86Au, 0xC69F7B69u, 0xD5CF889Du, 0x27A40B9Eu,
+	0x79B737BAu, 0x8BDCB4B9u, 0x988C474Du, 0x6AE7C44Eu, 0xBE2DA0A5u, 0x4C4623A6u, 0x5F16D052u, 0xAD7D5351u
+};
+
+// Compute the CRC32C of 'length' bytes, continuing from 'crc' (0 to start). Uses the SSE4.2 crc32 instruction when compiled for it.
+u32 binary_file_crc32c(const void* data, i64 length, u32 crc)
+{
+	const byte* bytes = (const byte*)data;
+	crc = ~crc;
+
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+	for (; length >= 8; length -= 8, bytes += 8)
+	{
+		u64 chunk;
+		memcpy(&chunk, bytes, sizeof(chunk));
+		crc = (u32)_mm_crc32_u64(crc, chunk);
+	}
+	for (; length > 0; length--, bytes++)
+		crc = _mm_crc32_u8(crc, *bytes);
+#else
+	for (; length > 0; length--, bytes++)
+		crc = binary_file_crc32c_table[(crc ^ *bytes) & 0xFF] ^ (crc >> 8);
+#endif
+
+	return ~crc;
+}
+// Open an append log for reading its records from the start. Returns NULL if the file is not found or is not an append log.
+binary_file_log_reader* binary_file_log_reader_open(str filename)
+{
+	binary_file file = binary_file_openfor_read(filename);
+	if (file == NULL)
+		return NULL; // Return NULL if the binary file is not found
+
+	u32 magic = 0, version = 0;
+	if (!binary_file_read_u32_le(&magic, file) || !binary_file_read_u32_le(&version, file) || magic != BINARY_FILE_LOG_MAGIC || version != BINARY_FILE_LOG_VERSION)
+	{
+		binary_file_close(file);
+		return NULL; // Not an append log
+	}
+
+	binary_file_log_reader* reader = (binary_file_log_reader*)calloc(1, sizeof(binary_file_log_reader));
+	if (reader != NULL)
+	{
+		reader->capacity = 256;
+		reader->record = (byte*)malloc(reader->capacity);
+	}
+	if (reader == NULL || reader->record == NULL)
+	{
+		free(reader);
+		binary_file_close(file);
+		return NULL;
+	}
+	reader->file = file;
+	reader->length = binary_file_get_open_length(file);
+	reader->position = BINARY_FILE_LOG_HEADER_SIZE;
+
+	return reader;
+}
+// Read the next record of an append log. Sets 'length' and returns the record (valid until the next call).
+// Returns NULL at the end of the log, or at a torn or corrupt record (which ends the log).
+const byte* binary_file_log_reader_next(i64* length, binary_file_log_reader* reader)
+{
+	u32 record_length, crc;
+	if (!binary_file_read_u32_le(&record_length, reader->file) || !binary_file_read_u32_le(&crc, reader->file))
+		return NULL; // End of the log, or a torn frame
+	if (reader->position + BINARY_FILE_LOG_FRAME_SIZE + (file_size)record_length > reader->length)
+		return NULL; // Torn record
+
+	if (record_length > reader->capacity)
+	{
+		byte* record = (byte*)realloc(reader->record, record_length);
+		if (record == NULL)
+			return NULL; // Out of memory
+		reader->record = record;
+		reader->capacity = record_length;
+	}
+	if ((record_length > 0 && !binary_file_read_byte(reader->record, record_length, reader->file)) || binary_file_crc32c(reader->record, record_length, 0) != crc)
+		return NULL; // Torn or corrupt record
+
+	reader->position += BINARY_FILE_LOG_FRAME_SIZE + record_length;
+	*length = record_length;
+	return reader->record;
+}
+// Get the end of the last valid record read
+file_size binary_file_log_reader_get_position(binary_file_log_reader* reader)
+{
+	return reader->position;
+}
+// Close an append log reader
+void binary_file_log_reader_close(binary_file_log_reader* reader)
+{
+	if (reader == NULL)
+		return;
+
+	binary_file_close(reader->file);
+	free(reader->record);
+	free(reader);
+}
+// Flusher thread of an append log: commits the waiting records in groups
+void binary_file_log_flusher(void* argument)
+{
+	binary_file_log* log = (binary_file_log*)argument;
+
+	binary_file_platform_mutex_lock(&log->mutex);
+	for (;;)
+	{
+		while (log->pending_used == 0 && !log->stopping)
+			binary_file_platform_condition_wait(&log->pending_ready, &log->mutex);
+		if (log->pending_used == 0)
+			break; // Stopping and everything is committed
+
+		// Give other records a chance to join this commit
+		i64 deadline = binary_file_platform_get_time_us() + log->max_delay_us;
+		while (!log->stopping && !log->flush_requested && log->pending_used < BINARY_FILE_LOG_BATCH_SIZE)
+		{
+			i64 remaining = deadline - binary_file_platform_get_time_us();
+			if (remaining <= 0)
+				break;
+			binary_file_platform_condition_wait_timeout(&log->pending_ready, &log->mutex, remaining);
+		}
+
+		// Swap the buffers, so appending goes on while this group is written
+		byte* group = log->pending;
+		i64 group_length = log->pending_used;
+		i64 group_capacity = log->pending_capacity;
+		u64 sequence = log->appended;
+		log->pending = log->flushing;
+		log->pending_capacity = log->flushing_capacity;
+		log->pending_used = 0;
+		log->flushing = group;
+		log->flushing_capacity = group_capacity;
+		log->flush_requested = false;
+		bool failed = log->failed;
+		binary_file_platform_condition_broadcast(&log->durable_ready); // Room for appends that wait for space
+		binary_file_platform_mutex_unlock(&log->mutex);
+
+		BINARY_FILE_STATS_TIME(start);
+		bool ok = !failed && binary_file_write_byte(group, group_length, log->file) && binary_file_platform_sync(log->file);
+		if (ok)
+			BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_FLUSH, group_length, group_length, start, log->file);
+
+		binary_file_platform_mutex_lock(&log->mutex);
+		if (ok)
+			log->durable = sequence;
+		else
+			log->failed = true;
+		binary_file_platform_condition_broadcast(&log->durable_ready);
+	}
+	binary_file_platform_mutex_unlock(&log->mutex);
+}
+// Open an append log for appending (created if it does not exist). Records of a crashed writer are checked and a torn tail is cut off.
+// A record waits at most 'max_delay_us' microseconds (0 = commit as soon as the flusher is free) for other records to share its write and fdatasync.
+// Returns NULL if the file can not be opened or is not an append log.
+binary_file_log* binary_file_log_open(str filename, i64 max_delay_us)
+{
+	// Find the end of the last complete record
+	file_size length = binary_file_get_length(filename);
+	file_size valid_end = 0;
+	if (length > 0 && length < BINARY_FILE_LOG_HEADER_SIZE)
+	{
+		// The first open died before its header was synced. If what is there is the start of a header, start over.
+		u32 expected[2] = { binary_file_to_le_u32(BINARY_FILE_LOG_MAGIC), binary_file_to_le_u32(BINARY_FILE_LOG_VERSION) };
+		byte header[BINARY_FILE_LOG_HEADER_SIZE];
+		binary_file file = binary_file_openfor_read(filename);
+		if (file == NULL)
+			return NULL; // Failure
+		bool torn = binary_file_read_byte(header, length, file) && memcmp(header, expected, (size_t)length) == 0;
+		binary_file_close(file);
+		if (!torn)
+			return NULL; // Not an append log
+	}
+	else if (length > 0)
+	{
+		binary_file_log_reader* reader = binary_file_log_reader_open(filename);
+		if (reader == NULL)
+			return NULL; // Not an append log
+		i64 record_length;
+		while (binary_file_log_reader_next(&record_length, reader) != NULL)
+			; // Skip the record
+		valid_end = binary_file_log_reader_get_position(reader);
+		binary_file_log_reader_close(reader);
+	}
+
+	binary_file_log* log = (binary_file_log*)calloc(1, sizeof(binary_file_log));
+	if (log == NULL)
+		return NULL;
+	log->max_delay_us = (max_delay_us > 0) ? max_delay_us : 0;
+	log->pending_capacity = BINARY_FILE_LOG_BATCH_SIZE;
+	log->flushing_capacity = BINARY_FILE_LOG_BATCH_SIZE;
+	log->pending = (byte*)malloc(log->pending_capacity);
+	log->flushing = (byte*)malloc(log->flushing_capacity);
+	log->file = binary_file_openfor_write_append(filename);
+	binary_file_platform_mutex_init(&log->mutex);
+	binary_file_platform_condition_init(&log->pending_ready);
+	binary_file_platform_condition_init(&log->durable_ready);
+
+	bool ok = log->pending != NULL && log->flushing != NULL && log->file != NULL;
+	if (ok && valid_end < length)
+		ok = binary_file_platform_truncate(valid_end, log->file) && binary_file_platform_sync(log->file); // Cut off the torn tail
+	if (ok && valid_end == 0)
+		ok = binary_file_write_u32_le(BINARY_FILE_LOG_MAGIC, log->file) && binary_file_write_u32_le(BINARY_FILE_LOG_VERSION, log->file) && binary_file_platform_sync(log->file);
+	ok = ok && binary_file_platform_thread_start(&log->flusher, binary_file_log_flusher, log);
+
+	if (!ok)
+	{
+		if (log->file != NULL)
+			binary_file_close(log->file);
+		binary_file_platform_condition_destroy(&log->durable_ready);
+		binary_file_platform_condition_destroy(&log->pending_ready);
+		binary_file_platform_mutex_destroy(&log->mutex);
+		free(log->flushing);
+		free(log->pending);
+		free(log);
+		return NULL;
+	}
+
+	return log;
 }
-// Open a binary file for reading in binary mode.
-binary_file binary_file_openfor_read(str filename)
+// Append a record to an append log (safe to call from many threads). Returns its sequence number for binary_file_log_wait(..), or 0 on failure.
+// The record is only copied here; it is written by the next group commit.
+u64 binary_file_log_append(const void* data, i64 length, binary_file_log* log)
 {
-	// Read a binary file in binary mode. Returns NULL if the file does not exist.
-	binary_file file = fopen((const char*)filename, "rb");
+	if (length < 0 || length > (i64)UINT32_MAX)
+		return 0; // Record too large
 
-	return file;
+	byte frame[BINARY_FILE_LOG_FRAME_SIZE];
+	u32 frame_length = binary_file_to_le_u32((u32)length);
+	u32 crc = binary_file_to_le_u32(binary_file_crc32c(data, length, 0));
+	memcpy(frame, &frame_length, sizeof(u32));
+	memcpy(frame + sizeof(u32), &crc, sizeof(u32));
+	i64 total = BINARY_FILE_LOG_FRAME_SIZE + length;
+
+	binary_file_platform_mutex_lock(&log->mutex);
+
+	// Wait while too much is waiting for the flusher
+	while (!log->failed && log->pending_used > 0 && log->pending_used + total > 4 * BINARY_FILE_LOG_BATCH_SIZE)
+		binary_file_platform_condition_wait(&log->durable_ready, &log->mutex);
+	if (log->failed)
+	{
+		binary_file_platform_mutex_unlock(&log->mutex);
+		return 0; // Something went wrong while trying to write the data
+	}
+
+	if (log->pending_used + total > log->pending_capacity)
+	{
+		i64 capacity = log->pending_capacity * 2;
+		while (capacity < log->pending_used + total)
+			capacity *= 2;
+		byte* pending = (byte*)realloc(log->pending, capacity);
+		if (pending == NULL)
+		{
+			binary_file_platform_mutex_unlock(&log->mutex);
+			return 0; // Out of memory
+		}
+		log->pending = pending;
+		log->pending_capacity = capacity;
+	}
+	memcpy(log->pending + log->pending_used, frame, BINARY_FILE_LOG_FRAME_SIZE);
+	if (length > 0)
+		memcpy(log->pending + log->pending_used + BINARY_FILE_LOG_FRAME_SIZE, data, length);
+	log->pending_used += total;
+	u64 sequence = ++log->appended;
+
+	binary_file_platform_condition_signal(&log->pending_ready);
+	binary_file_platform_mutex_unlock(&log->mutex);
+
+	return sequence;
 }
-// Get the length of a binary file. Note: This function returns -1 if the binary file is not found
-file_size binary_file_get_length(str filename)
+// Wait until the record with 'sequence' (and every record before it) is on the storage device. Returns false if a write or sync failed.
+bool binary_file_log_wait(u64 sequence, binary_file_log* log)
+{
+	binary_file_platform_mutex_lock(&log->mutex);
+	while (log->durable < sequence && !log->failed)
+		binary_file_platform_condition_wait(&log->durable_ready, &log->mutex);
+	bool durable = (log->durable >= sequence);
+	binary_file_platform_mutex_unlock(&log->mutex);
+
+	return durable;
+}
+// Append a record and wait until it is on the storage device. Returns its sequence number, or 0 on failure.
+u64 binary_file_log_append_sync(const void* data, i64 length, binary_file_log* log)
+{
+	u64 sequence = binary_file_log_append(data, length, log);
+	if (sequence == 0 || !binary_file_log_wait(sequence, log))
+		return 0; // Failure
+
+	return sequence;
+}
+// Commit every record appended so far without waiting for more, and wait until they are on the storage device
+bool binary_file_log_flush(binary_file_log* log)
+{
+	binary_file_platform_mutex_lock(&log->mutex);
+	u64 sequence = log->appended;
+	log->flush_requested = true;
+	binary_file_platform_condition_signal(&log->pending_ready);
+	binary_file_platform_mutex_unlock(&log->mutex);
+
+	return binary_file_log_wait(sequence, log);
+}
+// Commit the waiting records, stop the flusher, close the file and free the log. Returns false if any record could not be made durable.
+bool binary_file_log_close(binary_file_log* log)
+{
+	if (log == NULL)
+		return false;
+
+	binary_file_platform_mutex_lock(&log->mutex);
+	log->stopping = true;
+	binary_file_platform_condition_signal(&log->pending_ready);
+	binary_file_platform_mutex_unlock(&log->mutex);
+	binary_file_platform_thread_join(log->flusher);
+
+	bool ok = !log->failed && log->durable == log->appended;
+	ok = (BINARY_FILE_FCLOSE(log->file) == 0) && ok;
+
+	binary_file_platform_condition_destroy(&log->durable_ready);
+	binary_file_platform_condition_destroy(&log->pending_ready);
+	binary_file_platform_mutex_destroy(&log->mutex);
+	free(log->flushing);
+	free(log->pending);
+	free(log);
+
+	return ok;
+}
+
+//
+// Implementations: Shared writer
+//
+// Note: The ring holds the record bytes exactly as they go to the file, in the order their space was reserved.
+//       A producer reserves its space with one compare-and-swap on 'reserved', fills it in without a lock and commits it
+//       by setting the bits of its bytes in the 'committed' bitmap. A record that runs past the end of the ring is filled in
+//       contiguously in the spare room after it, and its tail is copied to the start of the ring when it is committed.
+//       The drainer writes the committed bytes from its position on straight from the ring with one pwritev() (two spans
+//       when they run past the end), then clears their bits. Nothing is copied on the way out and no producer waits for another.
+//       Bits are set and cleared with atomic adds: a byte's bit is always clear before it is set and set before it is cleared.
+//
+
+// Set (or clear) the 'committed' bits of 'length' bytes of the ring from 'offset' on, wrapping around the end
+void binary_file_shared_writer_mark(u64 offset, u64 length, bool committed, binary_file_shared_writer* writer)
+{
+	while (length > 0)
+	{
+		u64 index = offset / 64;
+		u64 bit = offset % 64;
+		u64 count = (length < 64 - bit) ? length : 64 - bit;
+		u64 bits = ((count == 64) ? ~(u64)0 : (((u64)1 << count) - 1)) << bit;
+		if (count == 64)
+			binary_file_platform_atomic_store_u64(committed ? bits : 0, &writer->committed[index]); // Nobody else has bytes in this word
+		else
+			binary_file_platform_atomic_add_u64(committed ? bits : (u64)0 - bits, &writer->committed[index]); // Neighbours may change their own bits meanwhile
+
+		offset = (offset + count) & (writer->ring_size - 1);
+		length -= count;
+	}
+}
+// Drainer thread of a shared writer: writes the committed records in reservation order
+void binary_file_shared_writer_drainer(void* argument)
+{
+	binary_file_shared_writer* writer = (binary_file_shared_writer*)argument;
+	u64 mask = writer->ring_size - 1;
+	u64 position = 0;
+
+	for (;;)
+	{
+		// Count the committed bytes from the position on, at most half the ring so the producers can fill the other half meanwhile
+		u64 limit = writer->ring_size / 2;
+		u64 length = 0;
+		while (length < limit)
+		{
+			u64 offset = (position + length) & mask;
+			u64 bits = binary_file_platform_atomic_load_u64(&writer->committed[offset / 64]) >> (offset % 64);
+			if (bits == (~(u64)0 >> (offset % 64)))
+			{
+				length += 64 - offset % 64; // The rest of the word is committed
+				continue;
+			}
+			for (; bits & 1; bits >>= 1)
+				length++;
+			break;
+		}
+		if (length > limit)
+			length = limit;
+
+		if (length > 0)
+		{
+			// Write the bytes straight from the ring: one span, or two when they run past the end
+			u64 offset = position & mask;
+			u64 first = (length < writer->ring_size - offset) ? length : writer->ring_size - offset;
+			binary_file_segment segments[2] = { { writer->ring + offset, (i64)first }, { writer->ring, (i64)(length - first) } };
+			i64 count = (first < length) ? 2 : 1;
+
+			if (!binary_file_platform_atomic_load_u32(&writer->failed))
+			{
+				BINARY_FILE_STATS_TIME(flush_start);
+				bool ok;
+				if (writer->direct)
+				{
+					ok = (binary_file_platform_pwritev(segments, count, writer->file_position, writer->file) == (i64)length);
+					writer->file_position += (file_size)length;
+				}
+				else
+					ok = binary_file_write_byte(writer->ring + offset, (i64)first, writer->file) && (count == 1 || binary_file_write_byte(writer->ring, (i64)(length - first), writer->file));
+				if (!ok)
+					binary_file_platform_atomic_store_u32(1, &writer->failed); // Something went wrong while trying to write the data
+				else
+					BINARY_FILE_STATS_RECORD(BINARY_FILE_STATS_FLUSH, (i64)length, (i64)length, flush_start, writer->file);
+			}
+
+			binary_file_shared_writer_mark(offset, length, false, writer);
+			position += length;
+			binary_file_platform_atomic_store_u64(position, &writer->drained); // Producers may reuse the space now
+			binary_file_platform_mutex_lock(&writer->mutex);
+			writer->written = position;
+			binary_file_platform_condition_broadcast(&writer->written_ready);
+			binary_file_platform_mutex_unlock(&writer->mutex);
+			continue;
+		}
+
+		// Nothing committed: stop once everything reserved is written, or sleep until a producer commits
+		binary_file_platform_mutex_lock(&writer->mutex);
+		if (writer->stopping && binary_file_platform_atomic_load_u64(&writer->reserved) == position)
+		{
+			binary_file_platform_mutex_unlock(&writer->mutex);
+			break;
+		}
+		binary_file_platform_atomic_store_u32(1, &writer->drainer_idle);
+		if ((binary_file_platform_atomic_load_u64(&writer->committed[(position & mask) / 64]) & ((u64)1 << (position % 64))) == 0)
+			binary_file_platform_condition_wait_timeout(&writer->work_ready, &writer->mutex, 1000);
+		binary_file_platform_atomic_store_u32(0, &writer->drainer_idle);
+		binary_file_platform_mutex_unlock(&writer->mutex);
+	}
+}
+// Start writing records from many threads to an open binary file. 'ring_size' is rounded up to a power of two (0 = BINARY_FILE_SHARED_WRITER_RING_SIZE).
+// The file must not be written by anything else until binary_file_shared_writer_close(..). Returns NULL if out of memory or the file can not be flushed.
+binary_file_shared_writer* binary_file_shared_writer_open(binary_file file, i64 ring_size)
 {
-	binary_file file = binary_file_openfor_read(filename);
 	if (file == NULL)
-		return -1; // Return -1 if the binary file is not found
+		return NULL;
 
-	if (_fseeki64(file, 0, SEEK_END) != 0)
-		return -1; // Failure
+	u64 size = 4096;
+	while (size < (u64)((ring_size > 0) ? ring_size : BINARY_FILE_SHARED_WRITER_RING_SIZE))
+		size *= 2;
+
+	// Write past the stdio buffer when the stream has a file descriptor
+	bool direct = true;
+#ifdef BINARY_FILE_STREAM_COOKIE
+	direct = (fileno(file) >= 0);
+#endif
+	file_size file_position = 0;
+	if (direct)
+	{
+		file_position = binary_file_platform_tell(file);
+		if (file_position < 0 || fflush(file) != 0)
+			return NULL; // Failure
+	}
 
-	file_size length = _ftelli64(file);
+	binary_file_shared_writer* writer = (binary_file_shared_writer*)calloc(1, sizeof(binary_file_shared_writer));
+	if (writer == NULL)
+		return NULL; // Out of memory
+	writer->file = file;
+	writer->ring_size = size;
+	writer->ring = (byte*)malloc((size_t)(size + size / 2)); // Room for a record of half the ring to run past the end
+	writer->committed = (volatile u64*)calloc((size_t)(size / 64), sizeof(u64));
+	writer->direct = direct;
+	writer->file_position = file_position;
+	binary_file_platform_mutex_init(&writer->mutex);
+	binary_file_platform_condition_init(&writer->work_ready);
+	binary_file_platform_condition_init(&writer->written_ready);
 
-	binary_file_close(file);
+	if (writer->ring == NULL || writer->committed == NULL || !binary_file_platform_thread_start(&writer->drainer, binary_file_shared_writer_drainer, writer))
+	{
+		binary_file_platform_condition_destroy(&writer->written_ready);
+		binary_file_platform_condition_destroy(&writer->work_ready);
+		binary_file_platform_mutex_destroy(&writer->mutex);
+		free((void*)writer->committed);
+		free(writer->ring);
+		free(writer);
+		return NULL;
+	}
 
-	return length; // Return the length of the binary file
+	return writer;
 }
-// Write 'i8' data to a binary file
-bool binary_file_write_i8(i8 data, binary_file file)
+// Reserve space for a record of 'length' bytes (safe to call from many threads, takes no lock). Fill it in and pass it to binary_file_shared_writer_commit(..).
+// Waits while the ring is full. Returns NULL if the record is longer than half the ring or a write has failed.
+byte* binary_file_shared_writer_reserve(i64 length, binary_file_shared_writer* writer)
 {
-	if (fwrite(&data, sizeof(i8), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	if (length < 0 || (u64)length > writer->ring_size / 2)
+		return NULL; // Record too large
+	if (binary_file_platform_atomic_load_u32(&writer->failed))
+		return NULL; // Something went wrong while trying to write the data
 
-	return true; // Success
+	u64 reserved;
+	for (;;)
+	{
+		reserved = binary_file_platform_atomic_load_u64(&writer->reserved);
+		if (reserved + (u64)length - binary_file_platform_atomic_load_u64(&writer->drained) > writer->ring_size)
+		{
+			binary_file_platform_yield(); // The ring is full, wait for the drainer
+			continue;
+		}
+		if (binary_file_platform_atomic_compare_exchange_u64(reserved, reserved + (u64)length, &writer->reserved))
+			break;
+	}
+
+	return writer->ring + (reserved & (writer->ring_size - 1));
 }
-// Write 'i16' data to a binary file
-bool binary_file_write_i16(i16 data, binary_file file)
+// Publish a record of 'length' bytes filled in after binary_file_shared_writer_reserve(..). It is written after every record reserved before it.
+void binary_file_shared_writer_commit(byte* record, i64 length, binary_file_shared_writer* writer)
 {
-	if (fwrite(&data, sizeof(i16), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	if (length <= 0)
+		return; // Nothing to write
 
-	return true; // Success
+	u64 offset = (u64)(record - writer->ring);
+	if (offset + (u64)length > writer->ring_size)
+		memcpy(writer->ring, writer->ring + writer->ring_size, (size_t)(offset + (u64)length - writer->ring_size)); // The part past the end goes to the start of the ring
+	binary_file_shared_writer_mark(offset, (u64)length, true, writer);
+
+	if (binary_file_platform_atomic_load_u32(&writer->drainer_idle))
+	{
+		binary_file_platform_atomic_store_u32(0, &writer->drainer_idle); // One wake up is enough
+		binary_file_platform_mutex_lock(&writer->mutex);
+		binary_file_platform_condition_signal(&writer->work_ready);
+		binary_file_platform_mutex_unlock(&writer->mutex);
+	}
 }
-// Write 'i32' data to a binary file
-bool binary_file_write_i32(i32 data, binary_file file)
+// Write a record (safe to call from many threads, takes no lock). The record is only copied here; the drainer thread writes it.
+bool binary_file_shared_writer_write(const void* data, i64 length, binary_file_shared_writer* writer)
 {
-	if (fwrite(&data, sizeof(i32), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	byte* record = binary_file_shared_writer_reserve(length, writer);
+	if (record == NULL)
+		return false; // Failure
 
+	memcpy(record, data, (size_t)length);
+	binary_file_shared_writer_commit(record, length, writer);
 	return true; // Success
 }
-// Write 'i64' data to a binary file
-bool binary_file_write_i64(i64 data, binary_file file)
+// Wait until every record reserved so far is committed and written to the file, then flush the file. Returns false if a write failed.
+bool binary_file_shared_writer_flush(binary_file_shared_writer* writer)
 {
-	if (fwrite(&data, sizeof(i64), 1, file) != 1)
+	u64 reserved = binary_file_platform_atomic_load_u64(&writer->reserved);
+
+	binary_file_platform_mutex_lock(&writer->mutex);
+	while (writer->written < reserved)
+		binary_file_platform_condition_wait(&writer->written_ready, &writer->mutex);
+	binary_file_platform_mutex_unlock(&writer->mutex);
+
+	if (binary_file_platform_atomic_load_u32(&writer->failed))
 		return false; // Something went wrong while trying to write the data
+	return writer->direct || (fflush(writer->file) == 0); // Direct writes are already in the file
+}
+// Write the remaining records, stop the drainer and free the shared writer. Does not close the file; its position is moved past the records.
+// Every producer must be done with the writer. Returns false if any record could not be written.
+bool binary_file_shared_writer_close(binary_file_shared_writer* writer)
+{
+	if (writer == NULL)
+		return false;
 
-	return true; // Success
+	binary_file_platform_mutex_lock(&writer->mutex);
+	writer->stopping = true;
+	binary_file_platform_condition_signal(&writer->work_ready);
+	binary_file_platform_mutex_unlock(&writer->mutex);
+	binary_file_platform_thread_join(writer->drainer);
+
+	bool ok = !binary_file_platform_atomic_load_u32(&writer->failed);
+	if (writer->direct)
+		ok = binary_file_platform_seek(writer->file_position, SEEK_SET, writer->file) && ok;
+	ok = (fflush(writer->file) == 0) && ok;
+
+	binary_file_platform_condition_destroy(&writer->written_ready);
+	binary_file_platform_condition_destroy(&writer->work_ready);
+	binary_file_platform_mutex_destroy(&writer->mutex);
+	free((void*)writer->committed);
+	free(writer->ring);
+	free(writer);
+
+	return ok;
 }
-// Write 'u8' data to a binary file
-bool binary_file_write_u8(u8 data, binary_file file)
+
+//
+// Implementations: Statistics
+//
+// Note: Each binary file gets a slot in a small open addressing table the first time it is counted, and gives it up
+//       when closed with binary_file_close(..); its counts then move to the totals of the files that are no longer counted
+//       on their own. Files beyond the table are counted there too. The totals are summed up when asked for, so a call
+//       costs two atomic adds on the counters of its own file, and a clock read for one in BINARY_FILE_STATS_SAMPLE calls.
+//       Snapshots read each counter atomically, but not all counters at the same instant.
+//
+
+#define BINARY_FILE_STATS_CLOSED 1						// Slot of a closed binary file, free to reuse
+
+#ifdef BINARY_FILE_STATS
+binary_file_stats binary_file_stats_others;				// Closed files, and files that did not fit in the table
+binary_file_stats_slot binary_file_stats_files[BINARY_FILE_STATS_MAX_FILES];
+#if defined(_MSC_VER)
+__declspec(thread) u32 binary_file_stats_counter;
+#elif defined(__cplusplus)
+thread_local u32 binary_file_stats_counter;
+#else
+__thread u32 binary_file_stats_counter;
+#endif
+#endif
+
+// Get the counters of a binary file, adding it to the table if 'add'. Returns NULL if it is not counted on its own.
+binary_file_stats* binary_file_stats_find(binary_file file, bool add)
 {
-	if (fwrite(&data, sizeof(u8), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+#ifdef BINARY_FILE_STATS
+	u64 key = (u64)(uintptr_t)file;
+	u64 mask = BINARY_FILE_STATS_MAX_FILES - 1;
+	u64 start = ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+	for (;;)
+	{
+		// Look for the file up to the first empty slot (it may sit past the slot of a closed file), remembering the first free slot
+		binary_file_stats_slot* free_slot = NULL;
+		u64 free_value = 0;
+		u64 index = start;
+		for (i32 probe = 0; probe < BINARY_FILE_STATS_MAX_FILES; probe++, index = (index + 1) & mask)
+		{
+			binary_file_stats_slot* slot = &binary_file_stats_files[index];
+			u64 current = binary_file_platform_atomic_load_u64(&slot->file);
+			if (current == key)
+				return &slot->stats;
+			if ((current == 0 || current == BINARY_FILE_STATS_CLOSED) && free_slot == NULL)
+			{
+				free_slot = slot;
+				free_value = current;
+			}
+			if (current == 0)
+				break; // The file is not further along
+		}
 
-	return true; // Success
+		if (!add || free_slot == NULL)
+			return NULL; // Not counted, or the table is full
+		if (binary_file_platform_atomic_compare_exchange_u64(free_value, key, &free_slot->file) || binary_file_platform_atomic_load_u64(&free_slot->file) == key)
+			return &free_slot->stats; // Added here (or by another thread at the same time)
+		// Another file took the free slot first: look again
+	}
+#else
+	(void)file;
+	(void)add;
+	return NULL; // Not counted
+#endif
 }
-// Write 'u16' data to a binary file
-bool binary_file_write_u16(u16 data, binary_file file)
+// Get a start time for binary_file_stats_record(..) if this call is one of the timed ones, otherwise 0
+i64 binary_file_stats_start(void)
 {
-	if (fwrite(&data, sizeof(u16), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+#ifdef BINARY_FILE_STATS
+	if ((++binary_file_stats_counter & (BINARY_FILE_STATS_SAMPLE - 1)) == 0)
+		return binary_file_platform_get_time_ns();
+#endif
+	return 0; // Not timed
+}
+// Count one call that asked for 'asked' bytes and got 'done' (-1 on failure). 'start' is from binary_file_platform_get_time_ns(), or 0 if the call was not timed.
+void binary_file_stats_record(binary_file_stats_operation operation, i64 asked, i64 done, i64 start, binary_file file)
+{
+#ifdef BINARY_FILE_STATS
+	binary_file_stats* stats = binary_file_stats_find(file, true);
+	if (stats == NULL)
+		stats = &binary_file_stats_others; // Table full
+
+	binary_file_platform_atomic_add_u64(1, &stats->calls[operation]);
+	if (done > 0)
+		binary_file_platform_atomic_add_u64((u64)done, &stats->bytes[operation]);
+	if (done < 0 || (done < asked && operation != BINARY_FILE_STATS_READ))
+		binary_file_platform_atomic_add_u64(1, &stats->failures);
+	else if (done < asked)
+		binary_file_platform_atomic_add_u64(1, &stats->short_reads);
 
+	if (start != 0)
+	{
+		u64 nanoseconds = (u64)(binary_file_platform_get_time_ns() - start);
+		i32 bucket = 0;
+		while (nanoseconds != 0 && bucket < BINARY_FILE_STATS_BUCKETS - 1)
+		{
+			nanoseconds >>= 1;
+			bucket++;
+		}
+		binary_file_platform_atomic_add_u64(1, &stats->latency[operation][bucket]);
+	}
+#else
+	(void)operation;
+	(void)asked;
+	(void)done;
+	(void)start;
+	(void)file;
+#endif
+}
+// Add every counter of 'source' to 'stats', one atomic read per counter. 'stats' is updated atomically if 'shared'.
+void binary_file_stats_sum(binary_file_stats* stats, binary_file_stats* source, bool shared)
+{
+	u64* to = (u64*)stats;
+	volatile u64* from = (volatile u64*)source;
+	for (i64 i = 0; i < (i64)(sizeof(binary_file_stats) / sizeof(u64)); i++)
+	{
+		u64 count = binary_file_platform_atomic_load_u64(&from[i]);
+		if (shared && count != 0)
+			binary_file_platform_atomic_add_u64(count, &to[i]);
+		else if (!shared)
+			to[i] += count;
+	}
+}
+// Move the counters of a binary file that is being closed to the totals of the others
+void binary_file_stats_forget(binary_file file)
+{
+#ifdef BINARY_FILE_STATS
+	binary_file_stats* stats;
+	while ((stats = binary_file_stats_find(file, false)) != NULL)
+	{
+		binary_file_stats_slot* slot = (binary_file_stats_slot*)((byte*)stats - offsetof(binary_file_stats_slot, stats));
+		binary_file_stats_sum(&binary_file_stats_others, stats, true);
+		memset(stats, 0, sizeof(binary_file_stats));
+		binary_file_platform_atomic_store_u64(BINARY_FILE_STATS_CLOSED, &slot->file);
+	}
+#else
+	(void)file;
+#endif
+}
+// Get the counters of all binary files. Returns false (and zeros) if BINARY_FILE_STATS is not defined.
+bool binary_file_stats_get(binary_file_stats* stats)
+{
+	memset(stats, 0, sizeof(binary_file_stats));
+#ifdef BINARY_FILE_STATS
+	binary_file_stats_sum(stats, &binary_file_stats_others, false);
+	for (i32 i = 0; i < BINARY_FILE_STATS_MAX_FILES; i++)
+		binary_file_stats_sum(stats, &binary_file_stats_files[i].stats, false);
 	return true; // Success
+#else
+	return false; // Not counted
+#endif
 }
-// Write 'u32' data to a binary file
-bool binary_file_write_u32(u32 data, binary_file file)
+// Get the counters of one open binary file. Returns false (and zeros) if it is not counted on its own or BINARY_FILE_STATS is not defined.
+bool binary_file_stats_get_file(binary_file_stats* stats, binary_file file)
 {
-	if (fwrite(&data, sizeof(u32), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	memset(stats, 0, sizeof(binary_file_stats));
+	binary_file_stats* source = binary_file_stats_find(file, false);
+	if (source == NULL)
+		return false; // Not counted
 
+	binary_file_stats_sum(stats, source, false);
 	return true; // Success
 }
-// Write 'u64' data to a binary file
-bool binary_file_write_u64(u64 data, binary_file file)
+// Set all counters to zero
+void binary_file_stats_reset(void)
 {
-	if (fwrite(&data, sizeof(u64), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+#ifdef BINARY_FILE_STATS
+	memset(&binary_file_stats_others, 0, sizeof(binary_file_stats));
+	for (i32 i = 0; i < BINARY_FILE_STATS_MAX_FILES; i++)
+		memset(&binary_file_stats_files[i].stats, 0, sizeof(binary_file_stats));
+#endif
+}
+// Get the latency in nanoseconds that 'percentile' (0.0 to 1.0) of the calls stayed under, as the upper bound of its histogram bucket. Returns 0 if there are no calls.
+i64 binary_file_stats_get_percentile(const binary_file_stats* stats, binary_file_stats_operation operation, f64 percentile)
+{
+	u64 total = 0;
+	for (i32 i = 0; i < BINARY_FILE_STATS_BUCKETS; i++)
+		total += stats->latency[operation][i];
+	if (total == 0)
+		return 0; // No calls
+
+	u64 target = (u64)(percentile * (f64)total + 0.5);
+	if (target < 1)
+		target = 1;
+	u64 count = 0;
+	for (i32 i = 0; i < BINARY_FILE_STATS_BUCKETS; i++)
+	{
+		count += stats->latency[operation][i];
+		if (count >= target)
+			return (i64)1 << i;
+	}
+	return (i64)1 << (BINARY_FILE_STATS_BUCKETS - 1);
+}
+// Write a set of counters as one line of JSON into 'buffer' (for a metrics exporter). Returns the length, or -1 if it does not fit in 'capacity' bytes.
+i64 binary_file_stats_export(c8* buffer, i64 capacity, const binary_file_stats* stats)
+{
+	const char* names[BINARY_FILE_STATS_OPERATION_COUNT] = { "read", "write", "seek", "flush" };
+	i64 length = 0;
+
+#define BINARY_FILE_STATS_PRINT(...) \
+	{ \
+		int printed = snprintf((char*)buffer + length, (size_t)(capacity - length), __VA_ARGS__); \
+		if (printed < 0 || printed >= capacity - length) \
+			return -1; /* Does not fit */ \
+		length += printed; \
+	}
+
+	if (capacity <= 0)
+		return -1; // Does not fit
+	BINARY_FILE_STATS_PRINT("{");
+	for (i32 operation = 0; operation < BINARY_FILE_STATS_OPERATION_COUNT; operation++)
+	{
+		binary_file_stats_operation op = (binary_file_stats_operation)operation;
+		BINARY_FILE_STATS_PRINT("\"%s\":{\"calls\":%llu,\"bytes\":%llu,\"p50_ns\":%lld,\"p99_ns\":%lld,\"histogram\":[", names[operation],
+			(unsigned long long)stats->calls[operation], (unsigned long long)stats->bytes[operation],
+			(long long)binary_file_stats_get_percentile(stats, op, 0.5), (long long)binary_file_stats_get_percentile(stats, op, 0.99));
+		for (i32 i = 0; i < BINARY_FILE_STATS_BUCKETS; i++)
+			BINARY_FILE_STATS_PRINT((i == 0) ? "%llu" : ",%llu", (unsigned long long)stats->latency[operation][i]);
+		BINARY_FILE_STATS_PRINT("]},");
+	}
+	BINARY_FILE_STATS_PRINT("\"short_reads\":%llu,\"failures\":%llu}", (unsigned long long)stats->short_reads, (unsigned long long)stats->failures);
+
+#undef BINARY_FILE_STATS_PRINT
+	return length;
+}
+// fread() that is counted
+size_t binary_file_stats_fread(void* data, size_t size, size_t count, binary_file file)
+{
+	i64 start = binary_file_stats_start();
+	size_t read = fread(data, size, count, file);
+	binary_file_stats_record(BINARY_FILE_STATS_READ, (i64)(size * count), (read < count && ferror(file)) ? -1 : (i64)(size * read), start, file);
+	return read;
+}
+// fwrite() that is counted
+size_t binary_file_stats_fwrite(const void* data, size_t size, size_t count, binary_file file)
+{
+	i64 start = binary_file_stats_start();
+	size_t written = fwrite(data, size, count, file);
+	binary_file_stats_record(BINARY_FILE_STATS_WRITE, (i64)(size * count), (i64)(size * written), start, file);
+	return written;
+}
+// binary_file_platform_seek(..) that is counted
+bool binary_file_stats_seek(file_size offset, int origin, binary_file file)
+{
+	i64 start = binary_file_stats_start();
+	bool ok = binary_file_platform_seek(offset, origin, file);
+	binary_file_stats_record(BINARY_FILE_STATS_SEEK, 0, ok ? 0 : -1, start, file);
+	return ok;
+}
+// fclose() that moves the counters of the binary file to the closed files first, so its slot can be reused
+int binary_file_stats_fclose(binary_file file)
+{
+	binary_file_stats_forget(file);
+	return fclose(file);
+}
+
+//
+// Implementations: Thread pool
+//
+
+// Run queued tasks until the thread pool is destroyed
+void binary_file_thread_pool_worker(void* argument)
+{
+	binary_file_thread_pool* pool = (binary_file_thread_pool*)argument;
+
+	binary_file_platform_mutex_lock(&pool->mutex);
+	while (true)
+	{
+		while (pool->task_count == 0 && !pool->stopping)
+			binary_file_platform_condition_wait(&pool->task_ready, &pool->mutex);
+		if (pool->task_count == 0)
+			break; // Stopping and nothing left to do
+
+		binary_file_task task = pool->tasks[pool->task_first];
+		pool->task_first = (pool->task_first + 1) % pool->task_capacity;
+		pool->task_count--;
+
+		binary_file_platform_mutex_unlock(&pool->mutex);
+		task.function(task.argument);
+		binary_file_platform_mutex_lock(&pool->mutex);
+
+		pool->unfinished--;
+		if (pool->unfinished == 0)
+			binary_file_platform_condition_broadcast(&pool->all_done);
+	}
+	binary_file_platform_mutex_unlock(&pool->mutex);
+}
+// Create a thread pool. If 'thread_count' is 0 or less one thread per logical processor is used.
+binary_file_thread_pool* binary_file_thread_pool_create(i32 thread_count)
+{
+	if (thread_count <= 0)
+		thread_count = binary_file_platform_get_cpu_count();
+
+	binary_file_thread_pool* pool = (binary_file_thread_pool*)calloc(1, sizeof(binary_file_thread_pool));
+	if (pool == NULL)
+		return NULL;
+
+	pool->task_capacity = 64;
+	pool->tasks = (binary_file_task*)malloc(pool->task_capacity * sizeof(binary_file_task));
+	pool->threads = (binary_file_thread*)malloc(thread_count * sizeof(binary_file_thread));
+	if (pool->tasks == NULL || pool->threads == NULL)
+	{
+		free(pool->tasks);
+		free(pool->threads);
+		free(pool);
+		return NULL;
+	}
+
+	binary_file_platform_mutex_init(&pool->mutex);
+	binary_file_platform_condition_init(&pool->task_ready);
+	binary_file_platform_condition_init(&pool->all_done);
+
+	for (i32 i = 0; i < thread_count; i++)
+	{
+		if (!binary_file_platform_thread_start(&pool->threads[i], binary_file_thread_pool_worker, pool))
+			break; // Keep the threads that did start
+		pool->thread_count++;
+	}
+
+	if (pool->thread_count == 0)
+	{
+		binary_file_thread_pool_destroy(pool);
+		return NULL; // Could not start any thread
+	}
+
+	return pool;
+}
+// Queue 'function(argument)' to run on the thread pool
+bool binary_file_thread_pool_submit(binary_file_task_function function, void* argument, binary_file_thread_pool* pool)
+{
+	binary_file_platform_mutex_lock(&pool->mutex);
+
+	// Grow the task ring buffer when it is full
+	if (pool->task_count == pool->task_capacity)
+	{
+		binary_file_task* tasks = (binary_file_task*)malloc(pool->task_capacity * 2 * sizeof(binary_file_task));
+		if (tasks == NULL)
+		{
+			binary_file_platform_mutex_unlock(&pool->mutex);
+			return false; // Out of memory
+		}
+		for (i64 i = 0; i < pool->task_count; i++)
+			tasks[i] = pool->tasks[(pool->task_first + i) % pool->task_capacity];
+		free(pool->tasks);
+		pool->tasks = tasks;
+		pool->task_first = 0;
+		pool->task_capacity *= 2;
+	}
+
+	binary_file_task* task = &pool->tasks[(pool->task_first + pool->task_count) % pool->task_capacity];
+	task->function = function;
+	task->argument = argument;
+	pool->task_count++;
+	pool->unfinished++;
+
+	binary_file_platform_condition_signal(&pool->task_ready);
+	binary_file_platform_mutex_unlock(&pool->mutex);
 
 	return true; // Success
 }
-// Write 'f32' data to a binary file
-bool binary_file_write_f32(f32 data, binary_file file)
+// Wait until all queued tasks of a thread pool have finished
+void binary_file_thread_pool_wait(binary_file_thread_pool* pool)
 {
-	if (fwrite(&data, sizeof(f32), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	binary_file_platform_mutex_lock(&pool->mutex);
+	while (pool->unfinished != 0)
+		binary_file_platform_condition_wait(&pool->all_done, &pool->mutex);
+	binary_file_platform_mutex_unlock(&pool->mutex);
+}
+// Finish the queued tasks, stop the threads and free a thread pool
+void binary_file_thread_pool_destroy(binary_file_thread_pool* pool)
+{
+	if (pool == NULL)
+		return;
+
+	binary_file_platform_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	binary_file_platform_condition_broadcast(&pool->task_ready);
+	binary_file_platform_mutex_unlock(&pool->mutex);
+
+	for (i32 i = 0; i < pool->thread_count; i++)
+		binary_file_platform_thread_join(pool->threads[i]);
+
+	binary_file_platform_condition_destroy(&pool->all_done);
+	binary_file_platform_condition_destroy(&pool->task_ready);
+	binary_file_platform_mutex_destroy(&pool->mutex);
+	free(pool->threads);
+	free(pool->tasks);
+	free(pool);
+}
+
+//
+// Implementations: Asynchronous binary file I/O
+//
+
+#ifdef BINARY_FILE_IO_URING
+// Set up an io_uring with room for 'queue_depth' requests. Returns false if io_uring is not available (old kernel or blocked), so the thread pool is used instead.
+bool binary_file_async_uring_open(binary_file_async* async)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	int descriptor = (int)syscall(__NR_io_uring_setup, (unsigned)async->queue_depth, &params);
+	if (descriptor < 0)
+		return false; // io_uring is not available
+
+	async->ring_descriptor = descriptor;
+	async->submission_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	async->completion_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (async->completion_ring_size > async->submission_ring_size)
+			async->submission_ring_size = async->completion_ring_size;
+		async->completion_ring_size = 0; // Shares the mapping of the submission ring
+	}
+
+	async->submission_ring = mmap(NULL, async->submission_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+	if (async->submission_ring == MAP_FAILED)
+	{
+		close(descriptor);
+		return false; // Failure
+	}
+
+	async->completion_ring = async->submission_ring;
+	if (async->completion_ring_size != 0)
+	{
+		async->completion_ring = mmap(NULL, async->completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_CQ_RING);
+		if (async->completion_ring == MAP_FAILED)
+		{
+			munmap(async->submission_ring, async->submission_ring_size);
+			close(descriptor);
+			return false; // Failure
+		}
+	}
+
+	async->submission_entries_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	async->submission_entries = (struct io_uring_sqe*)mmap(NULL, async->submission_entries_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES);
+	if ((void*)async->submission_entries == MAP_FAILED)
+	{
+		if (async->completion_ring_size != 0)
+			munmap(async->completion_ring, async->completion_ring_size);
+		munmap(async->submission_ring, async->submission_ring_size);
+		close(descriptor);
+		return false; // Failure
+	}
+
+	byte* submission = (byte*)async->submission_ring;
+	async->submission_head = (u32*)(submission + params.sq_off.head);
+	async->submission_tail = (u32*)(submission + params.sq_off.tail);
+	async->submission_mask = (u32*)(submission + params.sq_off.ring_mask);
+	async->submission_array = (u32*)(submission + params.sq_off.array);
+
+	byte* completion = (byte*)async->completion_ring;
+	async->completion_head = (u32*)(completion + params.cq_off.head);
+	async->completion_tail = (u32*)(completion + params.cq_off.tail);
+	async->completion_mask = (u32*)(completion + params.cq_off.ring_mask);
+	async->completion_entries = (struct io_uring_cqe*)(completion + params.cq_off.cqes);
 
 	return true; // Success
 }
-// Write 'f64' data to a binary file
-bool binary_file_write_f64(f64 data, binary_file file)
+// Put the part of a request not done yet into the submission ring of an io_uring. The kernel takes it on the next io_uring_enter().
+void binary_file_async_uring_prepare(i32 slot, binary_file_async* async)
+{
+	binary_file_async_request* request = &async->requests[slot];
+	request->vector.iov_base = (byte*)request->data + request->result;
+	request->vector.iov_len = (size_t)(request->length - request->result);
+
+	u32 tail = *async->submission_tail;
+	u32 index = tail & *async->submission_mask;
+	struct io_uring_sqe* entry = &async->submission_entries[index];
+	memset(entry, 0, sizeof(*entry));
+	entry->opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+	entry->fd = fileno(request->file);
+	entry->addr = (u64)(uintptr_t)&request->vector;
+	entry->len = 1;
+	entry->off = (u64)(request->offset + request->result);
+	entry->user_data = (u64)slot;
+	async->submission_array[index] = index;
+	__atomic_store_n(async->submission_tail, tail + 1, __ATOMIC_RELEASE);
+	async->unsubmitted++;
+}
+// Hand the entries in the submission ring to the kernel and wait for 'wait_count' completions. Interrupted calls are retried.
+// When the kernel is busy (EAGAIN, EBUSY) the entries it did not take stay in the ring for the next call. Returns false on failure.
+bool binary_file_async_uring_enter(u32 wait_count, binary_file_async* async)
+{
+	for (;;)
+	{
+		int result = (int)syscall(__NR_io_uring_enter, async->ring_descriptor, (unsigned)async->unsubmitted, wait_count, (wait_count > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (result >= 0)
+		{
+			async->unsubmitted -= result;
+			if (result > 0 && async->unsubmitted > 0 && wait_count == 0)
+				continue; // Took only some of them
+			return true; // Success
+		}
+		if (errno == EINTR)
+			continue; // Interrupted by a signal
+		if (errno == EAGAIN || errno == EBUSY)
+		{
+			binary_file_platform_yield();
+			return true; // Busy, try again on the next call
+		}
+		return false; // Failure
+	}
+}
+// Tear down the io_uring of an async engine
+void binary_file_async_uring_close(binary_file_async* async)
 {
-	if (fwrite(&data, sizeof(f64), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
-
-	return true; // Success
+	munmap(async->submission_entries, async->submission_entries_size);
+	if (async->completion_ring_size != 0)
+		munmap(async->completion_ring, async->completion_ring_size);
+	munmap(async->submission_ring, async->submission_ring_size);
+	close(async->ring_descriptor);
 }
-// Write 'bool' data to a binary file. Note this writes 'true' as '1' and 'false' as '0'. Not compacted.
-bool binary_file_write_bool(bool data, binary_file file)
+#endif
+// Run one request on the thread pool and hand the result to the completion queue
+void binary_file_async_run_request(void* argument)
 {
-	if (fwrite(&data, sizeof(bool), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	binary_file_async_request* request = (binary_file_async_request*)argument;
+	binary_file_async* async = request->async;
 
-	return true; // Success
+	if (request->write)
+		request->result = binary_file_platform_pwrite(request->data, request->length, request->offset, request->file);
+	else
+		request->result = binary_file_platform_pread(request->data, request->length, request->offset, request->file);
+
+	binary_file_platform_mutex_lock(&async->mutex);
+	binary_file_async_completion* completion = &async->completed[(async->completed_first + async->completed_count) % async->queue_depth];
+	completion->user_data = (u64)(request - async->requests); // Slot index, swapped for the user data when reaped
+	completion->result = request->result;
+	async->completed_count++;
+	binary_file_platform_condition_signal(&async->completion_ready);
+	binary_file_platform_mutex_unlock(&async->mutex);
 }
-// Write 'byte'(s) data to a binary file
-bool binary_file_write_byte(byte* data, i64 length, binary_file file)
+// Create an async I/O engine that can have 'queue_depth' requests queued or in flight. Uses io_uring on Linux, otherwise a pool of 'thread_count' threads (0 = one per logical processor).
+binary_file_async* binary_file_async_create(i32 queue_depth, i32 thread_count)
 {
-	if (fwrite(data, sizeof(byte), length, file) != length)
-		return false; // Something went wrong while trying to write the data
+	if (queue_depth <= 0)
+		return NULL; // Invalid queue depth
 
-	return true; // Success
+	binary_file_async* async = (binary_file_async*)calloc(1, sizeof(binary_file_async));
+	if (async == NULL)
+		return NULL;
+
+	binary_file_platform_mutex_init(&async->mutex);
+	binary_file_platform_condition_init(&async->completion_ready);
+
+	async->queue_depth = queue_depth;
+	async->requests = (binary_file_async_request*)calloc(queue_depth, sizeof(binary_file_async_request));
+	async->free_slots = (i32*)malloc(queue_depth * sizeof(i32));
+	async->queued_slots = (i32*)malloc(queue_depth * sizeof(i32));
+	async->completed = (binary_file_async_completion*)malloc(queue_depth * sizeof(binary_file_async_completion));
+	if (async->requests == NULL || async->free_slots == NULL || async->queued_slots == NULL || async->completed == NULL)
+	{
+		binary_file_async_close(async);
+		return NULL;
+	}
+	for (i32 i = 0; i < queue_depth; i++)
+		async->free_slots[i] = queue_depth - 1 - i;
+	async->free_count = queue_depth;
+
+#ifdef BINARY_FILE_IO_URING
+	async->uring = binary_file_async_uring_open(async);
+#endif
+	if (!async->uring)
+	{
+		async->pool = binary_file_thread_pool_create(thread_count);
+		if (async->pool == NULL)
+		{
+			binary_file_async_close(async);
+			return NULL;
+		}
+	}
+
+	return async;
 }
-// Write 'str' data to a binary file
-bool binary_file_write_str(str text, binary_file file)
+// Queue a request in a free slot. Returns false if 'queue_depth' requests are already queued or in flight.
+bool binary_file_async_queue(bool write, void* data, i64 length, file_size offset, binary_file file, u64 user_data, binary_file_async* async)
 {
-	if (fwrite(text, sizeof(c8), strlen((const char*)text), file) != strlen((const char*)text))
-		return false; // Something went wrong while trying to write the data
+	if (async->free_count == 0)
+		return false; // Queue is full, reap some completions first
 
-	// Write a null terminator
-	c8 null_terminator = '\0';
-	if (fwrite(&null_terminator, sizeof(byte), 1, file) != 1)
-		return false; // Something went wrong while trying to write the data
+	i32 slot = async->free_slots[--async->free_count];
+	binary_file_async_request* request = &async->requests[slot];
+	request->async = async;
+	request->file = file;
+	request->data = data;
+	request->length = length;
+	request->offset = offset;
+	request->user_data = user_data;
+	request->write = write;
+	request->result = 0;
+
+	async->queued_slots[async->queued_count++] = slot;
 
 	return true; // Success
 }
-// Write 'elements'(s) data to a binary file (as typical fwrite())
-bool binary_file_write_elements(void* data, i64 size, i64 count, binary_file file)
+// Queue a read of 'length' bytes at 'offset' into 'data'. Nothing is read until binary_file_async_submit(..) is called.
+bool binary_file_async_read(void* data, i64 length, file_size offset, binary_file file, u64 user_data, binary_file_async* async)
 {
-	if (fwrite(data, size, count, file) != count)
-		return false; // Something went wrong while trying to write the data
-
-	return true; // Success
+	return binary_file_async_queue(false, data, length, offset, file, user_data, async);
 }
-// Read 'i8' data from a binary file
-bool binary_file_read_i8(i8* data, binary_file file)
+// Queue a write of 'length' bytes from 'data' at 'offset'. Nothing is written until binary_file_async_submit(..) is called.
+bool binary_file_async_write(void* data, i64 length, file_size offset, binary_file file, u64 user_data, binary_file_async* async)
 {
-	if (fread(data, sizeof(i8), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
-
-	return true; // Success
+	return binary_file_async_queue(true, data, length, offset, file, user_data, async);
 }
-// Read 'i16' data from a binary file
-bool binary_file_read_i16(i16* data, binary_file file)
+// Submit all queued requests in one batch. Returns the number of requests submitted, or -1 on failure.
+i64 binary_file_async_submit(binary_file_async* async)
 {
-	if (fread(data, sizeof(i16), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	i32 count = async->queued_count;
+	if (count == 0)
+		return 0; // Nothing to submit
 
-	return true; // Success
+#ifdef BINARY_FILE_IO_URING
+	if (async->uring)
+	{
+		for (i32 i = 0; i < count; i++)
+			binary_file_async_uring_prepare(async->queued_slots[i], async);
+
+		// Once in the ring the requests are in flight whatever io_uring_enter() says. Entries the kernel does not take now go with the next submit or reap.
+		async->queued_count = 0;
+		async->in_flight += count;
+		if (!binary_file_async_uring_enter(0, async))
+			return -1; // Failure
+		return count;
+	}
+#endif
+
+	i32 submitted = 0;
+	for (; submitted < count; submitted++)
+	{
+		if (!binary_file_thread_pool_submit(binary_file_async_run_request, &async->requests[async->queued_slots[submitted]], async->pool))
+			break; // Out of memory, keep the rest queued
+	}
+	memmove(async->queued_slots, async->queued_slots + submitted, (count - submitted) * sizeof(i32));
+	async->queued_count -= submitted;
+	async->in_flight += submitted;
+
+	return (submitted == 0) ? -1 : submitted;
 }
-// Read 'i32' data from a binary file
-bool binary_file_read_i32(i32* data, binary_file file)
+// Wait for at least 'min_count' submitted requests to finish and copy up to 'max_count' completions. Returns the number of completions copied, or -1 on failure.
+i64 binary_file_async_reap(binary_file_async_completion* completions, i64 max_count, i64 min_count, binary_file_async* async)
 {
-	if (fread(data, sizeof(i32), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	if (min_count > async->in_flight)
+		min_count = async->in_flight; // Do not wait for requests that were never submitted
+	if (min_count > max_count)
+		min_count = max_count;
 
-	return true; // Success
+	i64 reaped = 0;
+#ifdef BINARY_FILE_IO_URING
+	if (async->uring)
+	{
+		while (reaped < max_count)
+		{
+			u32 head = *async->completion_head;
+			u32 tail = __atomic_load_n(async->completion_tail, __ATOMIC_ACQUIRE);
+			if (head == tail)
+			{
+				u32 wait_count = (reaped < min_count) ? (u32)(min_count - reaped) : 0;
+				if (wait_count == 0 && async->unsubmitted == 0)
+					break; // Got enough
+
+				// Also hands over entries left in the ring by a busy kernel or a short transfer
+				if (!binary_file_async_uring_enter(wait_count, async))
+					return (reaped > 0) ? reaped : -1; // Failure
+				if (wait_count == 0)
+					break; // Got enough
+				continue;
+			}
+
+			for (; head != tail && reaped < max_count; head++)
+			{
+				struct io_uring_cqe* entry = &async->completion_entries[head & *async->completion_mask];
+				i32 slot = (i32)entry->user_data;
+				binary_file_async_request* request = &async->requests[slot];
+				if (entry->res > 0 && request->result + entry->res < request->length)
+				{
+					// Short read or write: submit the rest, as pread()/pwrite() on the thread pool would continue
+					request->result += entry->res;
+					binary_file_async_uring_prepare(slot, async);
+					continue;
+				}
+
+				completions[reaped].user_data = request->user_data;
+				completions[reaped].result = (entry->res < 0) ? -1 : request->result + (i64)entry->res;
+				async->free_slots[async->free_count++] = slot;
+				async->in_flight--;
+				reaped++;
+			}
+			__atomic_store_n(async->completion_head, head, __ATOMIC_RELEASE);
+		}
+		return reaped;
+	}
+#endif
+
+	binary_file_platform_mutex_lock(&async->mutex);
+	while (async->completed_count < min_count)
+		binary_file_platform_condition_wait(&async->completion_ready, &async->mutex);
+	for (; reaped < max_count && async->completed_count > 0; reaped++)
+	{
+		binary_file_async_completion* completion = &async->completed[async->completed_first];
+		i32 slot = (i32)completion->user_data;
+		completions[reaped].user_data = async->requests[slot].user_data;
+		completions[reaped].result = completion->result;
+		async->free_slots[async->free_count++] = slot;
+		async->completed_first = (async->completed_first + 1) % async->queue_depth;
+		async->completed_count--;
+		async->in_flight--;
+	}
+	binary_file_platform_mutex_unlock(&async->mutex);
+
+	return reaped;
 }
-// Read 'i64' data from a binary file
-bool binary_file_read_i64(i64* data, binary_file file)
+// Check if an async I/O engine uses io_uring (true) or the thread pool fallback (false)
+bool binary_file_async_is_uring(binary_file_async* async)
 {
-	if (fread(data, sizeof(i64), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
-
-	return true; // Success
+	return async->uring;
 }
-// Read 'u8' data from a binary file
-bool binary_file_read_u8(u8* data, binary_file file)
+// Wait for all submitted requests and free an async I/O engine. Requests that were queued but not submitted are dropped.
+void binary_file_async_close(binary_file_async* async)
 {
-	if (fread(data, sizeof(u8), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	if (async == NULL)
+		return;
 
-	return true; // Success
+	binary_file_async_completion completion;
+	while (async->in_flight > 0 && binary_file_async_reap(&completion, 1, 1, async) == 1)
+		; // Drop the completion
+
+#ifdef BINARY_FILE_IO_URING
+	if (async->uring)
+		binary_file_async_uring_close(async);
+#endif
+	binary_file_thread_pool_destroy(async->pool);
+	binary_file_platform_condition_destroy(&async->completion_ready);
+	binary_file_platform_mutex_destroy(&async->mutex);
+
+	free(async->completed);
+	free(async->queued_slots);
+	free(async->free_slots);
+	free(async->requests);
+	free(async);
 }
-// Read 'u16' data from a binary file
-bool binary_file_read_u16(u16* data, binary_file file)
+
+//
+// Implementations: Pipeline
+//
+// Note: The input is split into chunks. A thread pool task reads its chunk with a positional read and runs the transform on it, so several
+//       chunks are read and transformed at once while the calling thread writes the finished ones in order. With 'output_chunk_size' the
+//       place of every output chunk is known in advance, so the tasks write them too, in any order. At most 'max_in_flight' chunks are in
+//       memory: a chunk can only start when the chunk 'max_in_flight' before it has been written.
+//       Both files are flushed first and left positioned after the data. The output must not be opened for appending.
+//
+
+// Thread pool task of a pipeline: read, transform and (fixed size output) write the chunk of one slot
+void binary_file_pipeline_slot_work(void* argument)
 {
-	if (fread(data, sizeof(u16), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	binary_file_pipeline_slot* slot = (binary_file_pipeline_slot*)argument;
+	binary_file_pipeline* pipeline = slot->pipeline;
 
-	return true; // Success
+	file_size offset = slot->index * pipeline->chunk_size;
+	i64 length = (pipeline->length - offset < pipeline->chunk_size) ? (i64)(pipeline->length - offset) : pipeline->chunk_size;
+
+	i32 state = BINARY_FILE_PIPELINE_SLOT_DONE;
+	if (binary_file_platform_pread(slot->input, length, pipeline->input_offset + offset, pipeline->input) != length)
+		state = BINARY_FILE_PIPELINE_SLOT_FAILED; // Something went wrong while trying to read the data
+	else if (pipeline->transform == NULL)
+		slot->output_length = length;
+	else
+	{
+		slot->output_length = pipeline->transform(slot->input, length, slot->output, pipeline->output_capacity, slot->index, pipeline->user_data);
+		if (slot->output_length < 0 || slot->output_length > pipeline->output_capacity)
+			state = BINARY_FILE_PIPELINE_SLOT_FAILED; // The transform failed
+	}
+
+	// Fixed size output: the place of the chunk is known, so write it now
+	if (state == BINARY_FILE_PIPELINE_SLOT_DONE && pipeline->output_chunk_size > 0)
+	{
+		bool last = (offset + length == pipeline->length);
+		byte* data = (pipeline->transform != NULL) ? slot->output : slot->input;
+		if ((last ? slot->output_length > pipeline->output_chunk_size : slot->output_length != pipeline->output_chunk_size)
+			|| binary_file_platform_pwrite(data, slot->output_length, pipeline->output_offset + slot->index * pipeline->output_chunk_size, pipeline->output) != slot->output_length)
+			state = BINARY_FILE_PIPELINE_SLOT_FAILED; // Wrong output size, or something went wrong while trying to write the data
+	}
+
+	binary_file_platform_mutex_lock(&pipeline->mutex);
+	slot->state = state;
+	binary_file_platform_condition_broadcast(&pipeline->slot_changed);
+	binary_file_platform_mutex_unlock(&pipeline->mutex);
 }
-// Read 'u32' data from a binary file
-bool binary_file_read_u32(u32* data, binary_file file)
+// Run the chunks of a pipeline through a thread pool and write them. Returns the number of bytes written, or -1 on failure.
+i64 binary_file_pipeline_run(binary_file_pipeline* pipeline, i32 thread_count)
 {
-	if (fread(data, sizeof(u32), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	i64 chunk_count = (i64)((pipeline->length + pipeline->chunk_size - 1) / pipeline->chunk_size);
+	binary_file_thread_pool* pool = binary_file_thread_pool_create(thread_count);
 
-	return true; // Success
+	i64 written = 0;
+	i64 next_submit = 0;
+	i64 next_done = 0;
+	for (; next_done < chunk_count; next_done++)
+	{
+		// Keep every slot busy
+		while (next_submit < chunk_count && next_submit - next_done < pipeline->slot_count)
+		{
+			binary_file_pipeline_slot* slot = &pipeline->slots[next_submit % pipeline->slot_count];
+			binary_file_platform_mutex_lock(&pipeline->mutex);
+			slot->index = next_submit++;
+			slot->state = BINARY_FILE_PIPELINE_SLOT_BUSY;
+			binary_file_platform_mutex_unlock(&pipeline->mutex);
+
+			if (pool == NULL || !binary_file_thread_pool_submit(binary_file_pipeline_slot_work, slot, pool))
+				binary_file_pipeline_slot_work(slot); // Run it on this thread instead
+		}
+
+		// Wait for the oldest chunk
+		binary_file_pipeline_slot* slot = &pipeline->slots[next_done % pipeline->slot_count];
+		binary_file_platform_mutex_lock(&pipeline->mutex);
+		while (slot->state == BINARY_FILE_PIPELINE_SLOT_BUSY)
+			binary_file_platform_condition_wait(&pipeline->slot_changed, &pipeline->mutex);
+		i32 state = slot->state;
+		slot->state = BINARY_FILE_PIPELINE_SLOT_FREE;
+		binary_file_platform_mutex_unlock(&pipeline->mutex);
+		if (state != BINARY_FILE_PIPELINE_SLOT_DONE)
+			break; // Failure
+
+		// Variable size output: write the chunks in order
+		if (pipeline->output_chunk_size == 0)
+		{
+			byte* data = (pipeline->transform != NULL) ? slot->output : slot->input;
+			if (binary_file_platform_pwrite(data, slot->output_length, pipeline->output_offset + written, pipeline->output) != slot->output_length)
+				break; // Something went wrong while trying to write the data
+		}
+		written += slot->output_length;
+	}
+
+	// Let the chunks still in flight finish before their buffers are freed
+	if (pool != NULL)
+	{
+		binary_file_thread_pool_wait(pool);
+		binary_file_thread_pool_destroy(pool);
+	}
+
+	return (next_done == chunk_count) ? written : -1;
 }
-// Read 'u64' data from a binary file
-bool binary_file_read_u64(u64* data, binary_file file)
+// Copy or transform 'length' bytes of the input at 'input_offset' to the output at 'output_offset'. Returns the number of bytes written, or -1 on failure.
+i64 binary_file_pipeline_start(file_size input_offset, file_size length, file_size output_offset, binary_file_transform_function transform, void* user_data,
+	const binary_file_pipeline_options* options, binary_file input, binary_file output)
 {
-	if (fread(data, sizeof(u64), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	binary_file_pipeline_options defaults = { 0, 0, 0, 0, 0 };
+	if (options == NULL)
+		options = &defaults;
+	if (length == 0)
+		return 0; // Nothing to do
+	if (options->chunk_size < 0 || options->output_capacity < 0 || options->output_chunk_size < 0)
+		return -1; // Failure
 
-	return true; // Success
+	binary_file_pipeline pipeline;
+	memset(&pipeline, 0, sizeof(pipeline));
+	pipeline.input = input;
+	pipeline.output = output;
+	pipeline.input_offset = input_offset;
+	pipeline.length = length;
+	pipeline.output_offset = output_offset;
+	pipeline.transform = transform;
+	pipeline.user_data = user_data;
+	pipeline.chunk_size = (options->chunk_size > 0) ? options->chunk_size : BINARY_FILE_PIPELINE_CHUNK_SIZE;
+	pipeline.output_capacity = (options->output_capacity > 0) ? options->output_capacity : pipeline.chunk_size;
+	pipeline.output_chunk_size = options->output_chunk_size;
+	if (pipeline.output_chunk_size > ((transform != NULL) ? pipeline.output_capacity : pipeline.chunk_size))
+		return -1; // An output chunk can never be that large
+
+	i32 thread_count = (options->thread_count > 0) ? options->thread_count : binary_file_platform_get_cpu_count();
+	i32 slot_count = (options->max_in_flight > 0) ? options->max_in_flight : 2 * thread_count;
+	i64 chunk_count = (i64)((length + pipeline.chunk_size - 1) / pipeline.chunk_size);
+	if (slot_count > chunk_count)
+		slot_count = (i32)chunk_count;
+
+	pipeline.slots = (binary_file_pipeline_slot*)calloc(slot_count, sizeof(binary_file_pipeline_slot));
+	if (pipeline.slots == NULL)
+		return -1; // Out of memory
+	pipeline.slot_count = slot_count;
+	binary_file_platform_mutex_init(&pipeline.mutex);
+	binary_file_platform_condition_init(&pipeline.slot_changed);
+
+	i64 written = 0;
+	for (i32 i = 0; i < slot_count && written == 0; i++)
+	{
+		binary_file_pipeline_slot* slot = &pipeline.slots[i];
+		slot->pipeline = &pipeline;
+		slot->input = (byte*)malloc(pipeline.chunk_size);
+		if (transform != NULL)
+			slot->output = (byte*)malloc(pipeline.output_capacity);
+		if (slot->input == NULL || (transform != NULL && slot->output == NULL))
+			written = -1; // Out of memory
+	}
+	if (written == 0)
+		written = binary_file_pipeline_run(&pipeline, (thread_count < slot_count) ? thread_count : slot_count);
+
+	for (i32 i = 0; i < slot_count; i++)
+	{
+		free(pipeline.slots[i].input);
+		free(pipeline.slots[i].output);
+	}
+	free(pipeline.slots);
+	binary_file_platform_condition_destroy(&pipeline.slot_changed);
+	binary_file_platform_mutex_destroy(&pipeline.mutex);
+
+	return written;
 }
-// Read 'f32' data from a binary file
-bool binary_file_read_f32(f32* data, binary_file file)
+// Get the current positions of two binary files (both flushed first) and the length of the input. Returns false on failure.
+bool binary_file_pipeline_positions(file_size* input_position, file_size* input_length, file_size* output_position, binary_file input, binary_file output)
 {
-	if (fread(data, sizeof(f32), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	if (fflush(input) != 0 || fflush(output) != 0)
+		return false; // Failure
 
-	return true; // Success
+	*input_position = binary_file_platform_tell(input);
+	*input_length = binary_file_platform_get_length(input);
+	*output_position = binary_file_platform_tell(output);
+	return (*input_position >= 0 && *input_length >= *input_position && *output_position >= 0);
 }
-// Read 'f64' data from a binary file
-bool binary_file_read_f64(f64* data, binary_file file)
+// Transform the rest of a binary file, from its current position to the end, chunk by chunk on a thread pool and write the output at the current position of 'output'.
+// Without a transform (NULL) the chunks are copied. 'options' can be NULL for the defaults. Returns the number of bytes written, or -1 on failure.
+i64 binary_file_transform(binary_file_transform_function transform, void* user_data, const binary_file_pipeline_options* options, binary_file input, binary_file output)
 {
-	if (fread(data, sizeof(f64), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	file_size input_position, input_length, output_position;
+	if (!binary_file_pipeline_positions(&input_position, &input_length, &output_position, input, output))
+		return -1; // Failure
 
-	return true; // Success
+	i64 written = binary_file_pipeline_start(input_position, input_length - input_position, output_position, transform, user_data, options, input, output);
+	if (written < 0)
+		return -1; // Something went wrong while trying to read, transform or write the data
+
+	// Leave both binary files after the data
+	if (!binary_file_platform_seek(input_length, SEEK_SET, input) || !binary_file_platform_seek(output_position + written, SEEK_SET, output))
+		return -1; // Failure
+
+	return written;
 }
-// Read 'bool' data from a binary file. Note this reads 'true' as '1' and 'false' as '0'. Not compacted.
-bool binary_file_read_bool(bool* data, binary_file file)
+// Copy the rest of a binary file, from its current position to the end, to the current position of 'output'. Returns the number of bytes copied, or -1 on failure.
+// Note: The data is copied inside the kernel (copy_file_range) where the system supports it, otherwise by the pipeline without a transform.
+i64 binary_file_copy(binary_file input, binary_file output)
 {
-	if (fread(data, sizeof(bool), 1, file) != 1)
-		return false; // Something went wrong while trying to read the data
+	file_size input_position, input_length, output_position;
+	if (!binary_file_pipeline_positions(&input_position, &input_length, &output_position, input, output))
+		return -1; // Failure
 
-	return true; // Success
+	i64 length = (i64)(input_length - input_position);
+	i64 copied = binary_file_platform_copy_range(input_position, output_position, length, input, output);
+	if (copied < length)
+	{
+		// Copy the rest through memory
+		i64 rest = binary_file_pipeline_start(input_position + copied, length - copied, output_position + copied, NULL, NULL, NULL, input, output);
+		if (rest != length - copied)
+			return -1; // Something went wrong while trying to copy the data
+	}
+
+	// Leave both binary files after the data
+	if (!binary_file_platform_seek(input_length, SEEK_SET, input) || !binary_file_platform_seek(output_position + length, SEEK_SET, output))
+		return -1; // Failure
+
+	return length;
 }
-// Read 'byte'(s) data from a binary file
-bool binary_file_read_byte(byte* data, i64 length, binary_file file)
+
+#ifdef BINARY_FILE_STRUCTS
+//
+// Prototypes and implementations: Struct serializer (C++17)
+//
+// Note: Declare the fields of a struct once at global scope, in the order they are stored in the file:
+//         struct particle { f32 x, y, z; i32 id; };
+//         BINARY_FILE_FIELDS(particle, x, y, z, id)
+//       Fields can be integers, floats, bool, enums, C arrays, std::array or other structs with BINARY_FILE_FIELDS(..) (up to 32 fields per struct).
+//       The file holds the fields packed back to back in native byte order, the same bytes as one binary_file_write_*(..) call per field.
+//       A struct whose memory already looks like that (trivially copyable, standard layout, no padding, fields listed in declaration order)
+//       is copied as a whole, and arrays of it are written and read with one binary_file_write_elements(..) / binary_file_read_elements(..) call.
+//       Other structs are packed into a buffer and written with one call per struct (or per BINARY_FILE_STRUCT_CHUNK_SIZE bytes for arrays).
+//
+
+#ifndef BINARY_FILE_STRUCT_CHUNK_SIZE
+#define BINARY_FILE_STRUCT_CHUNK_SIZE (64 * 1024)		// Buffer size when packing arrays of structs that can not be copied as a whole
+#endif
+
+#define BINARY_FILE_EXPAND(x) x
+#define BINARY_FILE_FOR_EACH_1(M, T, a) M(T, a)
+#define BINARY_FILE_FOR_EACH_2(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_1(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_3(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_2(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_4(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_3(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_5(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_4(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_6(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_5(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_7(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_6(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_8(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_7(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_9(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_8(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_10(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_9(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_11(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_10(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_12(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_11(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_13(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_12(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_14(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_13(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_15(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_14(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_16(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_15(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_17(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_16(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_18(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_17(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_19(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_18(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_20(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_19(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_21(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_20(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_22(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_21(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_23(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_22(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_24(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_23(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_25(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_24(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_26(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_25(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_27(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_26(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_28(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_27(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_29(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_28(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_30(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_29(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_31(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_30(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_32(M, T, a, ...) M(T, a), BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_31(M, T, __VA_ARGS__))
+#define BINARY_FILE_FOR_EACH_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define BINARY_FILE_FOR_EACH(M, T, ...) BINARY_FILE_EXPAND(BINARY_FILE_FOR_EACH_N(__VA_ARGS__, BINARY_FILE_FOR_EACH_32, BINARY_FILE_FOR_EACH_31, BINARY_FILE_FOR_EACH_30, BINARY_FILE_FOR_EACH_29, BINARY_FILE_FOR_EACH_28, BINARY_FILE_FOR_EACH_27, BINARY_FILE_FOR_EACH_26, BINARY_FILE_FOR_EACH_25, BINARY_FILE_FOR_EACH_24, BINARY_FILE_FOR_EACH_23, BINARY_FILE_FOR_EACH_22, BINARY_FILE_FOR_EACH_21, BINARY_FILE_FOR_EACH_20, BINARY_FILE_FOR_EACH_19, BINARY_FILE_FOR_EACH_18, BINARY_FILE_FOR_EACH_17, BINARY_FILE_FOR_EACH_16, BINARY_FILE_FOR_EACH_15, BINARY_FILE_FOR_EACH_14, BINARY_FILE_FOR_EACH_13, BINARY_FILE_FOR_EACH_12, BINARY_FILE_FOR_EACH_11, BINARY_FILE_FOR_EACH_10, BINARY_FILE_FOR_EACH_9, BINARY_FILE_FOR_EACH_8, BINARY_FILE_FOR_EACH_7, BINARY_FILE_FOR_EACH_6, BINARY_FILE_FOR_EACH_5, BINARY_FILE_FOR_EACH_4, BINARY_FILE_FOR_EACH_3, BINARY_FILE_FOR_EACH_2, BINARY_FILE_FOR_EACH_1)(M, T, __VA_ARGS__))
+
+#define BINARY_FILE_FIELD_POINTER(Type, field) &Type::field
+#define BINARY_FILE_FIELD_OFFSET(Type, field) offsetof(Type, field)
+
+// Declare the fields of 'Type' that are stored in a file (use at global scope)
+#define BINARY_FILE_FIELDS(Type, ...) \
+	template<> struct binary_file_schema<Type> \
+	{ \
+		static constexpr auto fields = std::make_tuple(BINARY_FILE_FOR_EACH(BINARY_FILE_FIELD_POINTER, Type, __VA_ARGS__)); \
+		static constexpr size_t offsets[] = { BINARY_FILE_FOR_EACH(BINARY_FILE_FIELD_OFFSET, Type, __VA_ARGS__) }; \
+	};
+
+// Field list of a struct, given by BINARY_FILE_FIELDS(..)
+template<typename T>
+struct binary_file_schema;
+
+// Type of the field a member pointer points to
+template<typename M>
+struct binary_file_member;
+template<typename C, typename U>
+struct binary_file_member<U C::*>
 {
-	if (fread(data, sizeof(byte), length, file) != length)
-		return false; // Something went wrong while trying to read the data
+	using type = U;
+};
 
-	return true; // Success
-}
-// Read 'str' data from a binary file. We need to use 'in_temp' in order to resize the allocated memory then return the string.
-// Note: 'in_temp' is required to use malloc() on the user side before using this function.
-str binary_file_read_str(binary_file file, str in_temp)
+// How a type is stored: 'size' bytes in the file, packed by pack(..) and unpacked by unpack(..). 'bulk' is true if the memory of the type is the same bytes.
+template<typename T, typename Enable = void>
+struct binary_file_codec
 {
-	// Store file position
-	i64 file_position = _ftelli64(file);
+	static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "binary_file: the type needs BINARY_FILE_FIELDS(..)");
 
-	// Check for file size
-	if (_fseeki64(file, 0, SEEK_END) != 0)
-		return NULL; // Failure
-	i64 file_size = _ftelli64(file);
+	static constexpr size_t size = sizeof(T);
+	static constexpr bool bulk = true;
 
-	// Restore file position
-	if (_fseeki64(file, file_position, SEEK_SET) != 0)
-		return NULL; // Failure
-			
-	// Read 'str' data from a binary file
-	str file_text = (str)malloc((file_size - file_position + 1) * sizeof(c8));
-	if (file_text == NULL)
-		return NULL;
-	if (fread(file_text, sizeof(byte), (file_size - file_position), file) != (file_size - file_position))
+	static void pack(const T& data, byte* out)
 	{
-		free(file_text);
-		return NULL; // Something went wrong while trying to read the data
+		memcpy(out, &data, sizeof(T));
+	}
+	static void unpack(T* data, const byte* in)
+	{
+		memcpy(data, in, sizeof(T));
 	}
+};
+// Arrays are stored element after element
+template<typename T, size_t N>
+struct binary_file_codec<T[N]>
+{
+	using element = binary_file_codec<T>;
 
-	// Search for the first '\0'
-	for (i64 i = 0; i < (file_size - file_position); i++)
+	static constexpr size_t size = element::size * N;
+	static constexpr bool bulk = element::bulk;
+
+	static void pack(const T (&data)[N], byte* out)
 	{
-		if (file_text[i] == '\0') // Found the end of the string
+		if constexpr (bulk)
+			memcpy(out, data, sizeof(data));
+		else
 		{
-			// Resize the string
-			str temp = (str)realloc(in_temp, (i + 1) * sizeof(c8));
-			if (temp == NULL)
-			{
-				free(in_temp);
-				free(file_text);
-				return NULL;
-			}
-			in_temp = temp;
-		
-			// Copy the string
-			memcpy(in_temp, file_text, (i + 1) * sizeof(c8));
-			free(file_text);
+			for (size_t i = 0; i < N; i++)
+				element::pack(data[i], out + i * element::size);
+		}
+	}
+	static void unpack(T (*data)[N], const byte* in)
+	{
+		if constexpr (bulk)
+			memcpy(*data, in, sizeof(*data));
+		else
+		{
+			for (size_t i = 0; i < N; i++)
+				element::unpack(&(*data)[i], in + i * element::size);
+		}
+	}
+};
+template<typename T, size_t N>
+struct binary_file_codec<std::array<T, N>>
+{
+	using element = binary_file_codec<T>;
 
-			// Restore file position
-			if (_fseeki64(file, file_position + i + 1, SEEK_SET) != 0)
-				return NULL; // Failure
+	static constexpr size_t size = element::size * N;
+	static constexpr bool bulk = element::bulk && sizeof(std::array<T, N>) == sizeof(T) * N;
+
+	static void pack(const std::array<T, N>& data, byte* out)
+	{
+		for (size_t i = 0; i < N; i++)
+			element::pack(data[i], out + i * element::size);
+	}
+	static void unpack(std::array<T, N>* data, const byte* in)
+	{
+		for (size_t i = 0; i < N; i++)
+			element::unpack(&(*data)[i], in + i * element::size);
+	}
+};
+// Structs with BINARY_FILE_FIELDS(..) are stored field after field. The pack and unpack routines are generated from the field list at compile time.
+template<typename T>
+struct binary_file_codec<T, std::void_t<decltype(binary_file_schema<T>::fields)>>
+{
+	using schema = binary_file_schema<T>;
+	static constexpr size_t count = std::tuple_size<std::remove_const_t<decltype(schema::fields)>>::value;
+
+	template<size_t I>
+	using field = typename binary_file_member<std::remove_const_t<std::tuple_element_t<I, std::remove_const_t<decltype(schema::fields)>>>>::type;
 
-			return in_temp;
+	template<size_t... I>
+	static constexpr size_t get_size(std::index_sequence<I...>)
+	{
+		return (binary_file_codec<field<I>>::size + ... + 0);
+	}
+	template<size_t... I>
+	static constexpr bool get_fields_bulk(std::index_sequence<I...>)
+	{
+		return (binary_file_codec<field<I>>::bulk && ... && true);
+	}
+	static constexpr bool get_in_order()
+	{
+		if (schema::offsets[0] != 0)
+			return false;
+		for (size_t i = 1; i < count; i++)
+		{
+			if (schema::offsets[i] <= schema::offsets[i - 1])
+				return false;
 		}
+		return true;
 	}
 
-	// Did not find '\0'
-	free(file_text);
-	return NULL;
-}
-// Read 'elements'(s) data from a binary file
-bool binary_file_read_elements(void* data, i64 size, i64 count, binary_file file)
-{
-	if (fread(data, size, count, file) != count)
-		return false; // Something went wrong while trying to read the data
+	static constexpr size_t size = get_size(std::make_index_sequence<count>());
+	static constexpr bool bulk = std::is_trivially_copyable<T>::value && std::is_standard_layout<T>::value
+		&& size == sizeof(T) && get_fields_bulk(std::make_index_sequence<count>()) && get_in_order();
 
-	return true; // Success
-}
-// Seek to the beginning of a binary file
-bool binary_file_set_position_begin(binary_file file)
-{
-	return (_fseeki64(file, 0, SEEK_SET) == 0); // Returns true if the seek returns 0 meaning that the seek was successful
-}
-// Seek to an absolute position in a binary file
-bool binary_file_set_position(file_size position, binary_file file)
+	template<size_t... I>
+	static void pack_fields(const T& data, byte* out, std::index_sequence<I...>)
+	{
+		size_t position = 0;
+		((binary_file_codec<field<I>>::pack(data.*std::get<I>(schema::fields), out + position), position += binary_file_codec<field<I>>::size), ...);
+	}
+	template<size_t... I>
+	static void unpack_fields(T* data, const byte* in, std::index_sequence<I...>)
+	{
+		size_t position = 0;
+		((binary_file_codec<field<I>>::unpack(&(data->*std::get<I>(schema::fields)), in + position), position += binary_file_codec<field<I>>::size), ...);
+	}
+	static void pack(const T& data, byte* out)
+	{
+		if constexpr (bulk)
+			memcpy(out, &data, sizeof(T));
+		else
+			pack_fields(data, out, std::make_index_sequence<count>());
+	}
+	static void unpack(T* data, const byte* in)
+	{
+		if constexpr (bulk)
+			memcpy(data, in, sizeof(T));
+		else
+			unpack_fields(data, in, std::make_index_sequence<count>());
+	}
+};
+
+// Get the number of bytes a struct takes in a file
+template<typename T>
+constexpr i64 binary_file_get_struct_size()
 {
-	return (_fseeki64(file, position, SEEK_SET) == 0); // Returns true if the seek returns 0 meaning that the seek was successful
+	return (i64)binary_file_codec<T>::size;
 }
-// Seek to a relative position in a binary file
-bool binary_file_set_position_relative(file_size position, binary_file file)
+// Write a struct to a binary file with one write call
+template<typename T>
+bool binary_file_write_struct(const T& data, binary_file file)
 {
-	return (_fseeki64(file, position, SEEK_CUR) == 0); // Returns true if the seek returns 0 meaning that the seek was successful
+	using codec = binary_file_codec<T>;
+	if constexpr (codec::bulk)
+		return binary_file_write_elements((void*)&data, sizeof(T), 1, file);
+	else
+	{
+		byte buffer[codec::size];
+		codec::pack(data, buffer);
+		return binary_file_write_byte(buffer, codec::size, file);
+	}
 }
-// Seek to the end of a binary file
-bool binary_file_set_position_end(binary_file file)
+// Write an array of structs to a binary file. Structs that can be copied as a whole are written with one call, others are packed in chunks.
+template<typename T>
+bool binary_file_write_structs(const T* data, i64 count, binary_file file)
 {
-	return (_fseeki64(file, 0, SEEK_END) == 0); // Note: the regular fseek() supports only file sizes up to 2GB. This _fseeki64() supports up to 8 Exabytes.
+	using codec = binary_file_codec<T>;
+	if constexpr (codec::bulk)
+		return binary_file_write_elements((void*)data, sizeof(T), count, file);
+	else
+	{
+		i64 chunk = BINARY_FILE_STRUCT_CHUNK_SIZE / (i64)codec::size;
+		if (chunk < 1)
+			chunk = 1;
+		if (chunk > count)
+			chunk = count;
+		byte* buffer = (byte*)malloc((chunk > 0 ? chunk : 1) * codec::size);
+		if (buffer == NULL)
+			return false; // Out of memory
+
+		for (i64 done = 0; done < count; done += chunk)
+		{
+			i64 n = (count - done < chunk) ? count - done : chunk;
+			for (i64 i = 0; i < n; i++)
+				codec::pack(data[done + i], buffer + i * codec::size);
+			if (!binary_file_write_byte(buffer, n * (i64)codec::size, file))
+			{
+				free(buffer);
+				return false; // Something went wrong while trying to write the data
+			}
+		}
+
+		free(buffer);
+		return true; // Success
+	}
 }
-// Get the current position in a binary file
-file_size binary_file_get_position(binary_file file)
+// Read a struct from a binary file with one read call
+template<typename T>
+bool binary_file_read_struct(T* data, binary_file file)
 {
-	return _ftelli64(file);
+	using codec = binary_file_codec<T>;
+	if constexpr (codec::bulk)
+		return binary_file_read_elements(data, sizeof(T), 1, file);
+	else
+	{
+		byte buffer[codec::size];
+		if (!binary_file_read_byte(buffer, codec::size, file))
+			return false; // Something went wrong while trying to read the data
+		codec::unpack(data, buffer);
+		return true; // Success
+	}
 }
-// Close a binary file
-void binary_file_close(binary_file file)
+// Read an array of structs from a binary file. Structs that can be copied as a whole are read with one call, others are unpacked in chunks.
+template<typename T>
+bool binary_file_read_structs(T* data, i64 count, binary_file file)
 {
-	fclose(file);
+	using codec = binary_file_codec<T>;
+	if constexpr (codec::bulk)
+		return binary_file_read_elements(data, sizeof(T), count, file);
+	else
+	{
+		i64 chunk = BINARY_FILE_STRUCT_CHUNK_SIZE / (i64)codec::size;
+		if (chunk < 1)
+			chunk = 1;
+		if (chunk > count)
+			chunk = count;
+		byte* buffer = (byte*)malloc((chunk > 0 ? chunk : 1) * codec::size);
+		if (buffer == NULL)
+			return false; // Out of memory
+
+		for (i64 done = 0; done < count; done += chunk)
+		{
+			i64 n = (count - done < chunk) ? count - done : chunk;
+			if (!binary_file_read_byte(buffer, n * (i64)codec::size, file))
+			{
+				free(buffer);
+				return false; // Something went wrong while trying to read the data
+			}
+			for (i64 i = 0; i < n; i++)
+				codec::unpack(&data[done + i], buffer + i * codec::size);
+		}
+
+		free(buffer);
+		return true; // Success
+	}
 }
+#endif
@@ -0,0 +1,17 @@
+//
+// Compile check for binary_file.h: it must build as C++11 (the struct serializer is left out before C++17)
+//
+
+#include "binary_file.h"
+
+int main()
+{
+	binary_file file = binary_file_openfor_write_new((str)"binary_file_cpp11.bin");
+	if (file == NULL)
+		return 1;
+	bool ok = binary_file_write_i32(42, file);
+	binary_file_close(file);
+	remove("binary_file_cpp11.bin");
+
+	return ok ? 0 : 1;
+}
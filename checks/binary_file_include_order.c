@@ -0,0 +1,23 @@
+//
+// Compile check for binary_file.h: it must still work when system headers are included before it
+//
+// Note: The GNU extensions binary_file.h asks for can be hidden when <stdio.h> comes first. The features that need them
+//       (compressed and direct streams, in-kernel copies) are then left out, and everything else must build as usual.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "binary_file.h"
+
+int main(void)
+{
+	binary_file file = binary_file_openfor_write_new((str)"binary_file_include_order.bin");
+	if (file == NULL)
+		return 1;
+	bool ok = binary_file_write_i32(42, file);
+	binary_file_close(file);
+	remove("binary_file_include_order.bin");
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+//
+// Check of the binary_file_stats table: a file must keep a single slot when the slot of a file that collided with it is freed
+//
+// Note: The counters are keyed by the binary_file pointer only, so made up pointers stand in for open files here.
+//
+
+#ifndef BINARY_FILE_STATS
+#define BINARY_FILE_STATS
+#endif
+#include "binary_file.h"
+
+// Get the first slot a binary file is looked up in (the same hash as binary_file_stats_find(..))
+u64 check_slot(binary_file file)
+{
+	return (((u64)(uintptr_t)file * 0x9E3779B97F4A7C15ull) >> 32) & (BINARY_FILE_STATS_MAX_FILES - 1);
+}
+
+int main(void)
+{
+	// Two files that start their lookup in the same slot
+	binary_file first = (binary_file)(uintptr_t)0x10000;
+	binary_file second = first;
+	do
+		second = (binary_file)((uintptr_t)second + 16);
+	while (check_slot(second) != check_slot(first));
+
+	// 'first' takes the slot, 'second' the one after it
+	binary_file_stats_record(BINARY_FILE_STATS_WRITE, 1, 1, 0, first);
+	binary_file_stats_record(BINARY_FILE_STATS_WRITE, 1, 1, 0, second);
+
+	// Freeing the slot of 'first' must not give 'second' another one
+	binary_file_stats_forget(first);
+	binary_file_stats_record(BINARY_FILE_STATS_WRITE, 1, 1, 0, second);
+
+	binary_file_stats stats;
+	if (!binary_file_stats_get_file(&stats, second) || stats.calls[BINARY_FILE_STATS_WRITE] != 2)
+	{
+		printf("binary_file_stats_table: expected 2 write calls, got %llu\n", (unsigned long long)stats.calls[BINARY_FILE_STATS_WRITE]);
+		return 1;
+	}
+
+	// A new file that starts there reuses the freed slot
+	binary_file third = second;
+	do
+		third = (binary_file)((uintptr_t)third + 16);
+	while (check_slot(third) != check_slot(first));
+	binary_file_stats_record(BINARY_FILE_STATS_WRITE, 1, 1, 0, third);
+	if (binary_file_stats_find(third, false) != &binary_file_stats_files[check_slot(first)].stats)
+	{
+		printf("binary_file_stats_table: the freed slot was not reused\n");
+		return 1;
+	}
+
+	binary_file_stats_forget(second);
+	binary_file_stats_forget(third);
+	return 0;
+}